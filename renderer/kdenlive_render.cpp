@@ -42,6 +42,14 @@ int main(int argc, char **argv)
             out = args.at(0).toInt();
             args.removeFirst();
         }
+        // Segmented render: number of parallel segments and path to ffmpeg, used to join them
+        int segments = 0;
+        QString ffmpeg;
+        if (args.count() > 2 && args.at(0) == QLatin1String("-segments")) {
+            args.removeFirst();
+            segments = args.takeFirst().toInt();
+            ffmpeg = args.takeFirst();
+        }
 
         // Do we want a split render
         if (args.count() > 0 && args.at(0) == QLatin1String("-split")) {
@@ -163,6 +171,9 @@ int main(int argc, char **argv)
             }
         }
         auto *rJob = new RenderJob(render, playlist, target, pid, in, out, qApp);
+        if (segments > 1) {
+            rJob->setSegments(segments, ffmpeg);
+        }
         rJob->start();
         QObject::connect(rJob, &RenderJob::renderingFinished, rJob, [&]() {
             rJob->deleteLater();
@@ -17,8 +17,15 @@
 #endif
 #include <QDebug>
 #include <QDir>
+#include <QDomDocument>
 #include <QElapsedTimer>
 #include <utility>
+
+namespace {
+// Shorter segments are not worth the cost of starting a process and joining the files
+const int minSegmentLength = 250;
+} // namespace
+
 // Can't believe I need to do this to sleep.
 class SleepThread : QThread
 {
@@ -49,6 +56,7 @@ RenderJob::RenderJob(const QString &render, const QString &scenelist, const QStr
     , m_frameout(out)
     , m_pid(pid)
     , m_dualpass(false)
+    , m_segmentCount(0)
 {
     m_renderProcess = new QProcess;
     m_renderProcess->setReadChannel(QProcess::StandardError);
@@ -118,6 +126,12 @@ void RenderJob::sendFinish(int status, const QString &error) {
 
 void RenderJob::slotAbort()
 {
+    for (const Segment &segment : qAsConst(m_segments)) {
+        segment.process->disconnect(this);
+        segment.process->kill();
+        segment.process->waitForFinished();
+    }
+    removeSegmentFiles();
     m_renderProcess->kill();
     sendFinish(-3, QString());
     if (m_erase) {
@@ -150,44 +164,49 @@ void RenderJob::receivedStderr()
         } else if (m_args.contains(QStringLiteral("pass=2"))) {
             m_progress = 50 + m_progress / 2;
         }
-        qint64 elapsedTime = m_startTime.secsTo(QDateTime::currentDateTime());
-        if (elapsedTime == m_seconds) {
-            return;
-        }
-        int speed = (frame - m_frame) / (elapsedTime - m_seconds);
-        m_seconds = elapsedTime;
+        sendProgress(frame);
+    }
+}
+
+void RenderJob::sendProgress(int frame)
+{
+    qint64 elapsedTime = m_startTime.secsTo(QDateTime::currentDateTime());
+    if (elapsedTime == m_seconds) {
+        return;
+    }
+    int speed = (frame - m_frame) / (elapsedTime - m_seconds);
+    m_seconds = elapsedTime;
 #ifndef NODBUS
-        if ((m_kdenliveinterface != nullptr) && m_kdenliveinterface->isValid()) {
-            m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), {m_dest, m_progress, frame});
+    if ((m_kdenliveinterface != nullptr) && m_kdenliveinterface->isValid()) {
+        m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), {m_dest, m_progress, frame});
+    }
+    if (m_jobUiserver) {
+        qint64 remaining = elapsedTime * (100 - m_progress) / qMax(1, m_progress);
+        int days = int(remaining / 86400);
+        int remainingSecs = int(remaining % 86400);
+        QTime when = QTime(0, 0, 0, 0).addSecs(remainingSecs);
+        QString est = tr("Remaining time ");
+        if (days > 0) {
+            est.append(tr("%n day(s) ", "", days));
         }
-        if (m_jobUiserver) {
-            qint64 remaining = elapsedTime * (100 - progress) / progress;
-            int days = int(remaining / 86400);
-            int remainingSecs = int(remaining % 86400);
-            QTime when = QTime(0, 0, 0, 0).addSecs(remainingSecs);
-            QString est = tr("Remaining time ");
-            if (days > 0) {
-                est.append(tr("%n day(s) ", "", days));
-            }
-            est.append(when.toString(QStringLiteral("hh:mm:ss")));
+        est.append(when.toString(QStringLiteral("hh:mm:ss")));
 
-            m_jobUiserver->call(QStringLiteral("setPercent"), uint(m_progress));
-            m_jobUiserver->call(QStringLiteral("setProcessedAmount"), qulonglong(frame - m_framein), tr("frames"));
-            m_jobUiserver->call(QStringLiteral("setSpeed"), qulonglong(speed));
-            m_jobUiserver->call(QStringLiteral("setDescriptionField"), 0, QString(), est);
-        }
+        m_jobUiserver->call(QStringLiteral("setPercent"), uint(m_progress));
+        m_jobUiserver->call(QStringLiteral("setProcessedAmount"), qulonglong(frame - m_framein), tr("frames"));
+        m_jobUiserver->call(QStringLiteral("setSpeed"), qulonglong(speed));
+        m_jobUiserver->call(QStringLiteral("setDescriptionField"), 0, QString(), est);
+    }
 #else
-        QJsonObject method, args;
-        args["url"] = m_dest;
-        args["progress"] = m_progress;
-        args["frame"] = frame;
-        method["setRenderingProgress"] = args;
-        m_kdenlivesocket->write(QJsonDocument(method).toJson());
-        m_kdenlivesocket->flush();
+    QJsonObject method, args;
+    args["url"] = m_dest;
+    args["progress"] = m_progress;
+    args["frame"] = frame;
+    method["setRenderingProgress"] = args;
+    m_kdenlivesocket->write(QJsonDocument(method).toJson());
+    m_kdenlivesocket->flush();
 #endif
-        m_frame = frame;
-        m_logstream << QStringLiteral("%1\t%2\t%3\n").arg(m_seconds).arg(m_frame).arg(m_progress);
-    }
+    m_frame = frame;
+    m_logstream << QStringLiteral("%1\t%2\t%3\n").arg(m_seconds).arg(m_frame).arg(m_progress);
 }
 
 void RenderJob::start()
@@ -264,11 +283,212 @@ void RenderJob::start()
 
     // Because of the logging, we connect to stderr in all cases.
     connect(m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
+    if (m_segmentCount > 1 && startSegments()) {
+        return;
+    }
     m_renderProcess->start(m_prog, m_args);
     m_logstream << "Started render process: " << m_prog << ' ' << m_args.join(QLatin1Char(' ')) << "\n";
     m_logstream.flush();
 }
 
+void RenderJob::setSegments(int count, const QString &ffmpeg)
+{
+    m_segmentCount = count;
+    m_ffmpeg = ffmpeg;
+}
+
+bool RenderJob::startSegments()
+{
+    // The playlist may be wrapped for the embedded consumer resize workaround
+    QString path = m_scenelist;
+    const bool multi = path.startsWith(QLatin1String("xml:")) && path.endsWith(QLatin1String("?multi=1"));
+    if (multi) {
+        path = path.mid(4);
+        path.chop(8);
+    }
+    QFile file(path);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file, false)) {
+        return false;
+    }
+    file.close();
+    QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+    if (consumer.isNull() || consumer.attribute(QStringLiteral("mlt_service")) != QLatin1String("avformat") ||
+        consumer.attribute(QStringLiteral("vn")).toInt() == 1) {
+        return false;
+    }
+    const int in = consumer.attribute(QStringLiteral("in")).toInt();
+    const int out = consumer.attribute(QStringLiteral("out")).toInt();
+    // Segments are aligned on the GOP size, so that the joined file has the keyframe cadence of a single encode
+    int length = (out - in + m_segmentCount) / m_segmentCount;
+    const int gop = consumer.attribute(QStringLiteral("g")).toInt();
+    if (gop > 0) {
+        length = (length + gop - 1) / gop * gop;
+    }
+    if (length < minSegmentLength || out - in + 1 <= length) {
+        m_logstream << "Timeline too short for a segmented render" << "\n";
+        return false;
+    }
+    const bool audio = consumer.attribute(QStringLiteral("an")).toInt() != 1 && consumer.attribute(QStringLiteral("audio_off")).toInt() != 1;
+    const QString extension = m_dest.section(QLatin1Char('.'), -1);
+
+    // Video segments are rendered without audio, the audio is rendered as a single stream to avoid clicks at the joins
+    QList<Segment> segments;
+    for (int start = in; start <= out; start += length) {
+        const int ix = segments.count();
+        segments << Segment{nullptr, path.section(QLatin1Char('.'), 0, -2) + QStringLiteral("-part%1.mlt").arg(ix),
+                            m_dest + QStringLiteral(".part%1.").arg(ix) + extension, start, qMin(out, start + length - 1), 0, false};
+    }
+    if (audio) {
+        segments << Segment{nullptr, path.section(QLatin1Char('.'), 0, -2) + QStringLiteral("-audio.mlt"), m_dest + QStringLiteral(".audio.") + extension, in,
+                            out, 0, true};
+    }
+    for (const Segment &segment : qAsConst(segments)) {
+        consumer.setAttribute(QStringLiteral("in"), segment.in);
+        consumer.setAttribute(QStringLiteral("out"), segment.out);
+        consumer.setAttribute(QStringLiteral("target"), segment.target);
+        consumer.setAttribute(segment.audio ? QStringLiteral("vn") : QStringLiteral("an"), 1);
+        consumer.removeAttribute(segment.audio ? QStringLiteral("an") : QStringLiteral("vn"));
+        QFile playlist(segment.playlist);
+        if (!playlist.open(QIODevice::WriteOnly | QIODevice::Text) || playlist.write(doc.toString().toUtf8()) < 0) {
+            m_logstream << "Cannot write segment playlist " << segment.playlist << "\n";
+            for (const Segment &written : qAsConst(segments)) {
+                QFile::remove(written.playlist);
+            }
+            return false;
+        }
+    }
+
+    m_segments = segments;
+    m_frame = in;
+    for (int ix = 0; ix < m_segments.count(); ++ix) {
+        auto *process = new QProcess(this);
+        process->setReadChannel(QProcess::StandardError);
+        m_segments[ix].process = process;
+        connect(process, &QProcess::readyReadStandardError, this, [this, ix]() { receivedSegmentStderr(ix); });
+        connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this,
+                [this, ix](int exitCode, QProcess::ExitStatus status) { slotSegmentFinished(ix, exitCode, status); });
+        connect(process, &QProcess::errorOccurred, this, [this, ix](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                slotSegmentFinished(ix, 1, QProcess::NormalExit);
+            }
+        });
+        const QString playlist = multi ? QStringLiteral("xml:%1?multi=1").arg(m_segments.at(ix).playlist) : m_segments.at(ix).playlist;
+        process->start(m_prog, {QStringLiteral("-progress"), playlist});
+        m_logstream << "Started segment process: " << m_prog << " -progress " << playlist << "\n";
+    }
+    m_logstream.flush();
+    return true;
+}
+
+void RenderJob::receivedSegmentStderr(int ix)
+{
+    Segment &segment = m_segments[ix];
+    QString result = QString::fromLocal8Bit(segment.process->readAllStandardError()).simplified();
+    if (!result.startsWith(QLatin1String("Current Frame"))) {
+        m_errorMessage.append(result + QStringLiteral("<br>"));
+        m_logstream << result;
+        return;
+    }
+    int progress = result.section(QLatin1Char(' '), -1).toInt();
+    if (segment.audio || progress <= segment.progress || progress > 100) {
+        return;
+    }
+    segment.progress = progress;
+    qint64 done = 0;
+    qint64 total = 0;
+    for (const Segment &part : qAsConst(m_segments)) {
+        if (!part.audio) {
+            done += qint64(part.out - part.in + 1) * part.progress / 100;
+            total += part.out - part.in + 1;
+        }
+    }
+    // The last percent is for joining the segments
+    progress = int(done * 99 / total);
+    if (progress <= m_progress) {
+        return;
+    }
+    m_progress = progress;
+    sendProgress(m_segments.constFirst().in + int(done));
+}
+
+void RenderJob::slotSegmentFinished(int ix, int exitCode, QProcess::ExitStatus status)
+{
+    if (status == QProcess::CrashExit || exitCode != 0) {
+        m_errorMessage.append(tr("Rendering of segment %1 failed.").arg(m_segments.at(ix).target) + QStringLiteral("<br>"));
+        // The other segments are useless now
+        for (const Segment &segment : qAsConst(m_segments)) {
+            segment.process->disconnect(this);
+            segment.process->kill();
+            segment.process->waitForFinished();
+        }
+        slotIsOver(QProcess::CrashExit);
+        return;
+    }
+    for (const Segment &segment : qAsConst(m_segments)) {
+        if (segment.process->state() != QProcess::NotRunning) {
+            return;
+        }
+    }
+    concatSegments();
+}
+
+void RenderJob::concatSegments()
+{
+    // Join the segments with the ffmpeg concat demuxer, copying the streams
+    QFile list(m_dest + QStringLiteral(".parts.txt"));
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        m_errorMessage.append(tr("Cannot write to %1, check permissions.").arg(list.fileName()) + QStringLiteral("<br>"));
+        slotIsOver(QProcess::CrashExit);
+        return;
+    }
+    QStringList args = {QStringLiteral("-y"), QStringLiteral("-v"), QStringLiteral("error"), QStringLiteral("-f"), QStringLiteral("concat"),
+                        QStringLiteral("-safe"), QStringLiteral("0"), QStringLiteral("-i"), list.fileName()};
+    QString audioFile;
+    bool written = true;
+    for (const Segment &segment : qAsConst(m_segments)) {
+        if (segment.audio) {
+            audioFile = segment.target;
+            continue;
+        }
+        QString target = segment.target;
+        const QByteArray line = QStringLiteral("file '%1'\n").arg(target.replace(QLatin1Char('\''), QLatin1String("'\\''"))).toUtf8();
+        if (list.write(line) != line.size()) {
+            written = false;
+            break;
+        }
+    }
+    // A partial list would make ffmpeg silently join fewer segments
+    written = written && list.flush();
+    list.close();
+    if (!written || list.error() != QFileDevice::NoError) {
+        m_errorMessage.append(tr("Cannot write to %1, check permissions.").arg(list.fileName()) + QStringLiteral("<br>"));
+        slotIsOver(QProcess::CrashExit);
+        return;
+    }
+    if (!audioFile.isEmpty()) {
+        args << QStringLiteral("-i") << audioFile << QStringLiteral("-map") << QStringLiteral("0:v") << QStringLiteral("-map") << QStringLiteral("1:a");
+    }
+    args << QStringLiteral("-c") << QStringLiteral("copy") << m_dest;
+    m_logstream << "Joining segments: " << m_ffmpeg << ' ' << args.join(QLatin1Char(' ')) << "\n";
+    m_logstream.flush();
+    // The join is the last step of the render, its end is handled like the end of a single process render
+    m_renderProcess->start(m_ffmpeg, args);
+}
+
+void RenderJob::removeSegmentFiles()
+{
+    for (const Segment &segment : qAsConst(m_segments)) {
+        QFile::remove(segment.playlist);
+        QFile::remove(segment.target);
+        segment.process->deleteLater();
+    }
+    if (!m_segments.isEmpty()) {
+        QFile::remove(m_dest + QStringLiteral(".parts.txt"));
+    }
+    m_segments.clear();
+}
+
 #ifndef NODBUS
 void RenderJob::initKdenliveDbusInterface()
 {
@@ -322,6 +542,7 @@ void RenderJob::slotIsOver(QProcess::ExitStatus status, bool isWritable)
     if (m_erase) {
         QFile(m_scenelist).remove();
     }
+    removeSegmentFiles();
     if (status == QProcess::CrashExit || m_renderProcess->error() != QProcess::UnknownError || m_renderProcess->exitCode() != 0) {
         // rendering crashed
         sendFinish(-2, m_errorMessage);
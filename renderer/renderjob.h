@@ -16,6 +16,7 @@
 #include <QProcess>
 #include <QDateTime>
 #include <QFile>
+#include <QList>
 // Testing
 #include <QTextStream>
 
@@ -27,6 +28,9 @@ public:
     RenderJob(const QString &render, const QString &scenelist, const QString &target, int pid = -1, int in = -1, int out = -1, QObject *parent = nullptr);
     ~RenderJob() override;
 
+    /** @brief Encode the video in @param count segments rendered in parallel, joined with @param ffmpeg without re-encoding */
+    void setSegments(int count, const QString &ffmpeg);
+
 public slots:
     void start();
 
@@ -36,6 +40,8 @@ private slots:
     void slotAbort();
     void slotAbort(const QString &url);
     void slotCheckProcess(QProcess::ProcessState state);
+    void receivedSegmentStderr(int ix);
+    void slotSegmentFinished(int ix, int exitCode, QProcess::ExitStatus status);
 
 private:
     QString m_scenelist;
@@ -67,13 +73,32 @@ private:
     QStringList m_args;
     /** @brief Used to write to the log file. */
     QTextStream m_logstream;
+    /** @brief A part of a segmented render, the audio part covers the whole range */
+    struct Segment
+    {
+        QProcess *process;
+        QString playlist;
+        QString target;
+        int in;
+        int out;
+        int progress;
+        bool audio;
+    };
+    int m_segmentCount;
+    QString m_ffmpeg;
+    QList<Segment> m_segments;
+    /** @brief Write the segment playlists and start their processes, returns false if the render cannot be segmented */
+    bool startSegments();
+    /** @brief Join the rendered segments and the audio in the destination file */
+    void concatSegments();
+    void removeSegmentFiles();
 #ifdef NODBUS
     void fromServer();
 #else
     void initKdenliveDbusInterface();
 #endif
     void sendFinish(int status, const QString &error);
-    void sendProgress();
+    void sendProgress(int frame);
 
 signals:
     void renderingFinished();
@@ -1080,6 +1080,23 @@ QVariant KeyframeModel::getNormalizedValue(double newVal) const
     return QVariant();
 }
 
+Mlt::Properties *KeyframeModel::parsedAnimation(const std::shared_ptr<AssetParameterModel> &model, const QString &animData, int duration) const
+{
+    void *profile = pCore->getCurrentProfile()->get_profile();
+    if (m_animation && duration == m_animationDuration && profile == m_animationProfile && animData == m_animationData) {
+        return m_animation.get();
+    }
+    m_animation.reset(new Mlt::Properties());
+    model->passProperties(*m_animation.get());
+    m_animation->set("key", animData.toUtf8().constData());
+    // This is a fake query to force the animation to be parsed
+    (void)m_animation->anim_get_double("key", 0, duration);
+    m_animationData = animData;
+    m_animationDuration = duration;
+    m_animationProfile = profile;
+    return m_animation.get();
+}
+
 QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
 {
     if (m_keyframeList.count(pos) > 0) {
@@ -1088,28 +1105,26 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
     if (m_keyframeList.size() == 0) {
         return QVariant();
     }
-    Mlt::Properties mlt_prop;
+    auto ptr = m_model.lock();
     QString animData;
     int out = 0;
     bool useOpacity = false;
-    if (auto ptr = m_model.lock()) {
-        ptr->passProperties(mlt_prop);
+    if (ptr) {
         out = ptr->data(m_index, AssetParameterModel::ParentDurationRole).toInt();
         useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
         animData = ptr->data(m_index, AssetParameterModel::ValueRole).toString();
     }
 
     if (!animData.isEmpty() && (m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::ColorWheel)) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        return QVariant(mlt_prop.anim_get_double("key", pos.frames(pCore->getCurrentFps())));
+        QMutexLocker lock(&m_animationMutex);
+        return QVariant(parsedAnimation(ptr, animData, out)->anim_get_double("key", pos.frames(pCore->getCurrentFps())));
     }
     if (!animData.isEmpty() && m_paramType == ParamType::AnimatedRect) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        mlt_rect rect = mlt_prop.anim_get_rect("key", pos.frames(pCore->getCurrentFps()));
+        mlt_rect rect;
+        {
+            QMutexLocker lock(&m_animationMutex);
+            rect = parsedAnimation(ptr, animData, out)->anim_get_rect("key", pos.frames(pCore->getCurrentFps()));
+        }
         QString res = QStringLiteral("%1 %2 %3 %4").arg(int(rect.x)).arg(int(rect.y)).arg(int(rect.w)).arg(int(rect.h));
         if (useOpacity) {
             res.append(QStringLiteral(" %1").arg(QString::number(rect.o, 'f')));
@@ -12,6 +12,7 @@
 #include "undohelper.hpp"
 
 #include <QAbstractListModel>
+#include <QMutex>
 #include <QReadWriteLock>
 
 #include <map>
@@ -205,6 +206,17 @@ private:
     mutable QReadWriteLock m_lock;
 
     std::map<GenTime, std::pair<KeyframeType, QVariant>> m_keyframeList;
+
+    /** @brief Returns the MLT animation parsed from @param animData, only parsing it again when the data, duration or profile changed.
+        m_animationMutex must be locked while the returned properties are used */
+    Mlt::Properties *parsedAnimation(const std::shared_ptr<AssetParameterModel> &model, const QString &animData, int duration) const;
+    /** @brief The parsed animation used for interpolation, and what it was parsed from */
+    mutable QMutex m_animationMutex;
+    mutable std::unique_ptr<Mlt::Properties> m_animation;
+    mutable QString m_animationData;
+    mutable int m_animationDuration{-1};
+    mutable void *m_animationProfile{nullptr};
+
     bool moveOneKeyframe(GenTime oldPos, GenTime pos, QVariant newVal, Fun &undo, Fun &redo, bool updateView = true);
 
 signals:
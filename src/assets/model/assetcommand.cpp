@@ -5,6 +5,8 @@
 
 #include "assetcommand.hpp"
 #include "assets/keyframes/model/keyframemodellist.hpp"
+#include "core.h"
+#include "effects/effectstack/model/effectitemmodel.hpp"
 #include "effects/effectsrepository.hpp"
 #include "transitions/transitionsrepository.hpp"
 #include <memory>
@@ -36,6 +38,7 @@ void AssetCommand::undo()
             QStringList names = m_name.split(QLatin1Char('\n'));
             QStringList oldValues = m_oldValue.split(QLatin1Char('\n'));
             if (names.count() == oldValues.count()) {
+                AssetParameterTransaction transaction;
                 for (int i = 0; i < names.count(); i++) {
                     m_model->setParameter(names.at(i), oldValues.at(i), true, m_index);
                 }
@@ -55,6 +58,7 @@ void AssetCommand::redo()
             QStringList names = m_name.split(QLatin1Char('\n'));
             QStringList values = m_value.split(QLatin1Char('\n'));
             if (names.count() == values.count()) {
+                AssetParameterTransaction transaction;
                 for (int i = 0; i < names.count(); i++) {
                     m_model->setParameter(names.at(i), values.at(i), m_updateView, m_index);
                 }
@@ -83,6 +87,25 @@ bool AssetCommand::mergeWith(const QUndoCommand *other)
     return true;
 }
 
+QJsonObject AssetCommand::journalOperation() const
+{
+    // Effects are found by their row in the stack of their owner, compositions are their own owner
+    int effectRow = -1;
+    if (auto effect = std::dynamic_pointer_cast<EffectItemModel>(m_model)) {
+        if (effect->depth() != 1) {
+            // Effect groups are not supported
+            return QJsonObject();
+        }
+        effectRow = effect->row();
+    }
+    const QJsonObject owner = pCore->journalAddress(m_model->getOwnerId());
+    if (owner.isEmpty() || !m_index.isValid()) {
+        return QJsonObject();
+    }
+    return {{QStringLiteral("op"), QStringLiteral("setParameter")}, {QStringLiteral("owner"), owner}, {QStringLiteral("effect"), effectRow},
+            {QStringLiteral("row"), m_index.row()}, {QStringLiteral("name"), m_name}, {QStringLiteral("value"), m_value}};
+}
+
 AssetMultiCommand::AssetMultiCommand(const std::shared_ptr<AssetParameterModel> &model, const QList <QModelIndex> &indexes, const QStringList &values, QUndoCommand *parent)
     : QUndoCommand(parent)
     , m_model(model)
@@ -107,6 +130,8 @@ AssetMultiCommand::AssetMultiCommand(const std::shared_ptr<AssetParameterModel>
 
 void AssetMultiCommand::undo()
 {
+    // The monitor is only refreshed once for all the parameters
+    AssetParameterTransaction transaction;
     int indx = 0;
     int max = m_indexes.size() - 1;
     for (const QModelIndex &ix : qAsConst(m_indexes)) {
@@ -117,6 +142,8 @@ void AssetMultiCommand::undo()
 // virtual
 void AssetMultiCommand::redo()
 {
+    // The monitor is only refreshed once for all the parameters
+    AssetParameterTransaction transaction;
     int indx = 0;
     int max = m_indexes.size() - 1;
     for (const QModelIndex &ix : qAsConst(m_indexes)) {
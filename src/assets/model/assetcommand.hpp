@@ -7,6 +7,7 @@
 #define ASSETCOMMAND_H
 
 #include "assetparametermodel.hpp"
+#include <QJsonObject>
 #include <QPersistentModelIndex>
 #include <QTime>
 #include <QUndoCommand>
@@ -23,6 +24,8 @@ public:
     void redo() override;
     int id() const override;
     bool mergeWith(const QUndoCommand *other) override;
+    /** @brief Describe the parameter change for the undo journal, returns an empty object if it cannot be replayed */
+    QJsonObject journalOperation() const;
 
 private:
     std::shared_ptr<AssetParameterModel> m_model;
@@ -18,6 +18,7 @@
 #include <QJsonObject>
 #include <QRegularExpression>
 #include <QString>
+#include <algorithm>
 #define DEBUG_LOCALE false
 
 AssetParameterModel::AssetParameterModel(std::unique_ptr<Mlt::Properties> asset, const QDomElement &assetXml, const QString &assetId, ObjectId ownerId,
@@ -263,31 +264,14 @@ void AssetParameterModel::setParameter(const QString &name, int value, bool upda
     } else {
         m_fixedParams[name] = value;
     }
-    if (m_assetId.startsWith(QStringLiteral("sox_"))) {
-        // Warning, SOX effect, need unplug/replug
-        qDebug() << "// Warning, SOX effect, need unplug/replug";
-        QStringList effectParam = {m_assetId.section(QLatin1Char('_'), 1)};
-        for (const QString &pName : m_paramOrder) {
-            effectParam << m_asset->get(pName.toUtf8().constData());
-        }
-        m_asset->set("effect", effectParam.join(QLatin1Char(' ')).toUtf8().constData());
-        emit replugEffect(shared_from_this());
-    } else if (m_assetId.startsWith(QStringLiteral("ladspa"))) {
-        // these effects don't understand param change and need to be rebuild
-        emit replugEffect(shared_from_this());
-    }
+    ParameterNotifications notifications;
+    notifications.replug = needsReplug();
     if (update) {
-        emit modelChanged();
-        emit dataChanged(index(0, 0), index(m_rows.count() - 1, 0), {});
-        // Update fades in timeline
-        pCore->updateItemModel(m_ownerId, m_assetId);
-        if (!m_isAudio) {
-            // Trigger monitor refresh
-            pCore->refreshProjectItem(m_ownerId);
-            // Invalidate timeline preview
-            pCore->invalidateItem(m_ownerId);
-        }
+        notifications.allRows = true;
+        notifications.modelChanged = true;
+        notifications.updateOwner = true;
     }
+    sendNotifications(notifications);
 }
 
 void AssetParameterModel::internalSetParameter(const QString &name, const QString &paramValue, const QModelIndex &paramIndex)
@@ -385,47 +369,105 @@ void AssetParameterModel::setParameter(const QString &name, const QString &param
 {
     // qDebug() << "// PROCESSING PARAM CHANGE: " << name << ", UPDATE: " << update << ", VAL: " << paramValue;
     internalSetParameter(name, paramValue, paramIndex);
-    bool updateChildRequired = true;
-    if (m_assetId.startsWith(QStringLiteral("sox_"))) {
-        // Warning, SOX effect, need unplug/replug
-        QStringList effectParam = {m_assetId.section(QLatin1Char('_'), 1)};
-        for (const QString &pName : m_paramOrder) {
-            effectParam << m_asset->get(pName.toUtf8().constData());
+    ParameterNotifications notifications;
+    notifications.replug = needsReplug();
+    if (!notifications.replug) {
+        if (update) {
+            notifications.rows << (paramIndex.isValid() ? paramIndex.row() : m_rows.indexOf(name));
+            notifications.modelChanged = true;
         }
-        m_asset->set("effect", effectParam.join(QLatin1Char(' ')).toUtf8().constData());
-        emit replugEffect(shared_from_this());
-        updateChildRequired = false;
-    } else if (m_assetId.startsWith(QStringLiteral("ladspa"))) {
-        // these effects don't understand param change and need to be rebuild
-        emit replugEffect(shared_from_this());
-        updateChildRequired = false;
-    } else if (update) {
-        qDebug() << "// SENDING DATA CHANGE....";
-        if (paramIndex.isValid()) {
-            emit dataChanged(paramIndex, paramIndex);
-        } else {
-            QModelIndex ix = index(m_rows.indexOf(name), 0);
-            emit dataChanged(ix, ix);
-        }
-        emit modelChanged();
-    }
-    if (updateChildRequired) {
-        emit updateChildren({name});
+        notifications.childNames << name;
     }
     // Update timeline view if necessary
     if (m_ownerId.first == ObjectType::NoItem) {
         // Used for generator clips
-        if (!update) emit modelChanged();
+        if (!update) {
+            notifications.modelChanged = true;
+        }
     } else {
-        // Update fades in timeline
-        pCore->updateItemModel(m_ownerId, m_assetId);
-        if (!m_isAudio) {
-            // Trigger monitor refresh
-            pCore->refreshProjectItem(m_ownerId);
-            // Invalidate timeline preview
-            pCore->invalidateItem(m_ownerId);
+        notifications.updateOwner = true;
+    }
+    sendNotifications(notifications);
+}
+
+bool AssetParameterModel::needsReplug() const
+{
+    // SOX and LADSPA effects don't understand param change and need to be rebuilt
+    return m_assetId.startsWith(QStringLiteral("sox_")) || m_assetId.startsWith(QStringLiteral("ladspa"));
+}
+
+void AssetParameterModel::ParameterNotifications::merge(const ParameterNotifications &other)
+{
+    replug = replug || other.replug;
+    for (int row : other.rows) {
+        if (!rows.contains(row)) {
+            rows << row;
+        }
+    }
+    allRows = allRows || other.allRows;
+    modelChanged = modelChanged || other.modelChanged;
+    for (const QString &name : other.childNames) {
+        if (!childNames.contains(name)) {
+            childNames << name;
+        }
+    }
+    updateOwner = updateOwner || other.updateOwner;
+}
+
+void AssetParameterModel::sendNotifications(const ParameterNotifications &notifications)
+{
+    if (AssetParameterTransaction::record(this, notifications)) {
+        // Notified when the transaction ends
+        return;
+    }
+    if (emitNotifications(notifications, m_ownerId)) {
+        // Trigger monitor refresh
+        pCore->refreshProjectItem(m_ownerId);
+        // Invalidate timeline preview
+        pCore->invalidateItem(m_ownerId);
+    }
+}
+
+bool AssetParameterModel::emitNotifications(const ParameterNotifications &notifications, const ObjectId &owner)
+{
+    if (notifications.replug) {
+        if (m_assetId.startsWith(QStringLiteral("sox_"))) {
+            // Warning, SOX effect, need unplug/replug
+            QStringList effectParam = {m_assetId.section(QLatin1Char('_'), 1)};
+            for (const QString &pName : m_paramOrder) {
+                effectParam << m_asset->get(pName.toUtf8().constData());
+            }
+            m_asset->set("effect", effectParam.join(QLatin1Char(' ')).toUtf8().constData());
+        }
+        emit replugEffect(shared_from_this());
+    }
+    if (notifications.allRows) {
+        emit dataChanged(index(0, 0), index(m_rows.count() - 1, 0), {});
+    } else if (!notifications.rows.isEmpty()) {
+        // A single notification covering all the changed rows
+        int first = m_rows.count();
+        int last = -1;
+        for (int row : notifications.rows) {
+            if (row > -1) {
+                first = qMin(first, row);
+                last = qMax(last, row);
+            }
         }
+        // Parameters without a row are reported with an invalid index, as setParameter always did
+        emit dataChanged(index(last > -1 ? first : -1, 0), index(last, 0));
+    }
+    if (notifications.modelChanged) {
+        emit modelChanged();
+    }
+    if (!notifications.childNames.isEmpty()) {
+        emit updateChildren(notifications.childNames);
+    }
+    if (!notifications.updateOwner) {
+        return false;
     }
+    // Update fades in timeline
+    pCore->updateItemModel(owner, m_assetId);
+    return !m_isAudio;
 }
 
 AssetParameterModel::~AssetParameterModel() = default;
@@ -1262,6 +1304,8 @@ const QVector<QPair<QString, QVariant>> AssetParameterModel::loadPreset(const QS
 
 void AssetParameterModel::setParameters(const paramVector &params, bool update)
 {
+    // The owner is only refreshed once
+    AssetParameterTransaction transaction;
     ObjectType itemId;
     if (!update) {
         // Change itemId to NoItem to ensure we don't send any update like refreshProjectItem that would trigger monitor refreshes.
@@ -1344,3 +1388,58 @@ const QVariant AssetParameterModel::getParamFromName(const QString &paramName)
     }
     return QVariant();
 }
+
+thread_local AssetParameterTransaction *AssetParameterTransaction::s_current = nullptr;
+
+AssetParameterTransaction::AssetParameterTransaction()
+{
+    // Nested transactions are part of the outermost one
+    if (s_current == nullptr) {
+        s_current = this;
+    }
+}
+
+AssetParameterTransaction::~AssetParameterTransaction()
+{
+    if (s_current != this) {
+        return;
+    }
+    // The notifications may change other parameters, these are not batched anymore
+    s_current = nullptr;
+    std::vector<ObjectId> owners;
+    for (const Change &change : m_changes) {
+        auto asset = change.asset.lock();
+        if (asset && asset->emitNotifications(change.notifications, change.owner) &&
+            std::find(owners.begin(), owners.end(), change.owner) == owners.end()) {
+            owners.push_back(change.owner);
+        }
+    }
+    for (const ObjectId &owner : owners) {
+        // Trigger monitor refresh
+        pCore->refreshProjectItem(owner);
+        // Invalidate timeline preview
+        pCore->invalidateItem(owner);
+    }
+}
+
+// static
+bool AssetParameterTransaction::isRunning()
+{
+    return s_current != nullptr;
+}
+
+// static
+bool AssetParameterTransaction::record(AssetParameterModel *asset, const AssetParameterModel::ParameterNotifications &notifications)
+{
+    if (s_current == nullptr) {
+        return false;
+    }
+    auto &changes = s_current->m_changes;
+    auto change = std::find_if(changes.begin(), changes.end(), [asset](const Change &c) { return c.key == asset; });
+    if (change == changes.end()) {
+        changes.push_back(Change{asset, asset->shared_from_this(), asset->m_ownerId, notifications});
+    } else {
+        change->notifications.merge(notifications);
+    }
+    return true;
+}
@@ -14,8 +14,10 @@
 #include <unordered_map>
 
 #include <memory>
+#include <vector>
 #include <mlt++/MltProperties.h>
 
+class AssetParameterTransaction;
 class KeyframeModelList;
 
 typedef QVector<QPair<QString, QVariant>> paramVector;
@@ -62,6 +64,7 @@ class AssetParameterModel : public QAbstractListModel, public enable_shared_from
 
 friend class KeyframeModelList;
 friend class KeyframeModel;
+friend class AssetParameterTransaction;
 
 public:
     /**
@@ -256,6 +259,31 @@ protected:
      *  building an effect in the constructor, so that we don't call shared_from_this
      */
     void internalSetParameter(const QString &name, const QString &paramValue, const QModelIndex &paramIndex = QModelIndex());
+    /** @brief The notifications of parameter changes. An AssetParameterTransaction merges them, so that each one is sent once */
+    struct ParameterNotifications
+    {
+        /** @brief The effect must be rebuilt */
+        bool replug{false};
+        /** @brief Rows reported as changed, -1 for parameters without a row */
+        QList<int> rows;
+        bool allRows{false};
+        bool modelChanged{false};
+        /** @brief Parameters that must be passed to the child effects */
+        QStringList childNames;
+        /** @brief The owner must be updated in the timeline, refreshed in the monitor and invalidated in the timeline preview */
+        bool updateOwner{false};
+
+        void merge(const ParameterNotifications &other);
+    };
+    /** @brief Returns true for the effects that must be rebuilt when a parameter changes */
+    bool needsReplug() const;
+    /** @brief Send the notifications of a parameter change, or record them if a transaction is running */
+    void sendNotifications(const ParameterNotifications &notifications);
+    /** @brief Emit the notifications of parameter changes
+       @param owner the owner of the asset when the parameters were changed
+       @returns true if the owner must be refreshed in the monitor and invalidated in the timeline preview
+     */
+    bool emitNotifications(const ParameterNotifications &notifications, const ObjectId &owner);
 
 signals:
     void modelChanged();
@@ -269,4 +297,38 @@ signals:
     void showEffectZone(ObjectId id, QPair <int, int>inOut, bool checked);
 };
 
+/** @class AssetParameterTransaction
+    @brief Batches parameter changes, for example when all the effects of a stack are adjusted to a new clip duration.
+   While a transaction exists in the current thread, setParameter only updates the MLT properties. When the outermost
+   transaction is destroyed, each modified asset sends the notifications of its changes once, then each owner is refreshed
+   in the monitor and invalidated in the timeline preview once. Notifications are only merged: a transaction never sends
+   a notification that the changes would not have sent one by one.
+ */
+class AssetParameterTransaction
+{
+public:
+    AssetParameterTransaction();
+    ~AssetParameterTransaction();
+    AssetParameterTransaction(const AssetParameterTransaction &) = delete;
+    AssetParameterTransaction &operator=(const AssetParameterTransaction &) = delete;
+
+    /** @brief Returns true if a transaction is running in the current thread */
+    static bool isRunning();
+
+private:
+    friend class AssetParameterModel;
+    struct Change
+    {
+        AssetParameterModel *key;
+        std::weak_ptr<AssetParameterModel> asset;
+        ObjectId owner;
+        AssetParameterModel::ParameterNotifications notifications;
+    };
+    /** @brief Record the notifications of a parameter change, returns false if no transaction is running */
+    static bool record(AssetParameterModel *asset, const AssetParameterModel::ParameterNotifications &notifications);
+
+    std::vector<Change> m_changes;
+    static thread_local AssetParameterTransaction *s_current;
+};
+
 #endif
@@ -29,7 +29,13 @@ MixerManager::MixerManager(QWidget *parent)
     , m_visibleMixerManager(false)
     , m_expandedWidth(-1)
     , m_recommendedWidth(300)
+    , m_levelsPosition(-1)
 {
+    // The meters are refreshed together at a fixed rate instead of once per track for each displayed frame
+    m_levelsTimer = new QTimer(this);
+    m_levelsTimer->setInterval(40);
+    connect(m_levelsTimer, &QTimer::timeout, this, &MixerManager::refreshLevels);
+    connect(this, &MixerManager::updateLevels, this, [this](int pos) { m_levelsPosition = pos; });
     m_masterBox = new QHBoxLayout;
     setContentsMargins(0, 0, 0, 0);
     m_channelsBox = new QScrollArea(this);
@@ -64,7 +70,6 @@ void MixerManager::registerTrack(int tid, std::shared_ptr<Mlt::Tractor> service,
     if (m_visibleMixerManager) {
         mixer->connectMixer(!KdenliveSettings::mixerCollapse());
     }
-    connect(this, &MixerManager::updateLevels, mixer.get(), &MixerWidget::updateAudioLevel);
     connect(this, &MixerManager::clearMixers, mixer.get(), &MixerWidget::clear);
     connect(mixer.get(), &MixerWidget::toggleSolo, this, [&](int trid, bool solo) {
         if (!solo) {
@@ -165,7 +170,6 @@ void MixerManager::setModel(std::shared_ptr<TimelineItemModel> model)
     if (m_visibleMixerManager) {
         m_masterMixer->connectMixer(true);
     }
-    connect(this, &MixerManager::updateLevels, m_masterMixer.get(), &MixerWidget::updateAudioLevel);
     connect(this, &MixerManager::clearMixers, m_masterMixer.get(), &MixerWidget::clear);
     m_masterBox->addWidget(m_masterMixer.get());
     if (KdenliveSettings::mixerCollapse()) {
@@ -189,6 +193,21 @@ void MixerManager::connectMixer(bool doConnect)
     if (m_masterMixer != nullptr) {
         m_masterMixer->connectMixer(m_visibleMixerManager);
     }
+    if (m_visibleMixerManager) {
+        m_levelsTimer->start();
+    } else {
+        m_levelsTimer->stop();
+    }
+}
+
+void MixerManager::refreshLevels()
+{
+    for (const auto &item : m_mixers) {
+        item.second->updateAudioLevel(m_levelsPosition);
+    }
+    if (m_masterMixer != nullptr) {
+        m_masterMixer->updateAudioLevel(m_levelsPosition);
+    }
 }
 
 void MixerManager::collapseMixers()
@@ -18,6 +18,7 @@ namespace Mlt {
 
 class MixerWidget;
 class QHBoxLayout;
+class QTimer;
 class TimelineItemModel;
 class QScrollArea;
 
@@ -45,6 +46,8 @@ public slots:
 
 private slots:
     void resetSizePolicy();
+    /** @brief Refresh the audio levels of all tracks for the last displayed frame */
+    void refreshLevels();
 
 signals:
     void updateLevels(int);
@@ -70,6 +73,9 @@ private:
     int m_expandedWidth;
     QVector <int> m_soloMuted;
     int m_recommendedWidth;
+    /** @brief Position of the last frame displayed in the project monitor */
+    int m_levelsPosition;
+    QTimer *m_levelsTimer;
 
 };
 
@@ -29,6 +29,7 @@
 #include <QStyle>
 #include <QToolButton>
 #include <klocalizedstring.h>
+#include <algorithm>
 #include <utility>
 
 static inline double IEC_Scale(double dB)
@@ -68,20 +69,16 @@ static inline int fromDB(double level)
 
 void MixerWidget::property_changed( mlt_service , MixerWidget *widget, mlt_event_data data )
 {
+    // Called from the MLT audio thread
     if (widget && !strcmp(Mlt::EventData(data).to_string(), "_position")) {
         mlt_properties filter_props = MLT_FILTER_PROPERTIES( widget->m_monitorFilter->get_filter());
-        int pos = mlt_properties_get_int(filter_props, "_position");
-        if (!widget->m_levels.contains(pos)) {
-            QVector<double> levels;
-            for (int i = 0; i < widget->m_channels; i++) {
-                levels << IEC_Scale(mlt_properties_get_double(filter_props, QString("_audio_level.%1").arg(i).toUtf8().constData()));
-            }
-            widget->m_levels[pos] = std::move(levels);
-            //{IEC_Scale(mlt_properties_get_double(filter_props, "_audio_level.0")), IEC_Scale(mlt_properties_get_double(filter_props, "_audio_level.1"))};
-            if (widget->m_levels.size() > widget->m_maxLevels) {
-                widget->m_levels.erase(widget->m_levels.begin());
-            }
+        MeterLevels levels;
+        levels.position = mlt_properties_get_int(filter_props, "_position");
+        levels.channels = int(widget->m_levelKeys.size());
+        for (int i = 0; i < levels.channels; i++) {
+            levels.values[size_t(i)] = IEC_Scale(mlt_properties_get_double(filter_props, widget->m_levelKeys[size_t(i)].constData()));
         }
+        widget->m_levelQueue.push(levels);
     }
 }
 
@@ -92,9 +89,10 @@ MixerWidget::MixerWidget(int tid, std::shared_ptr<Mlt::Tractor> service, QString
     , m_levelFilter(nullptr)
     , m_monitorFilter(nullptr)
     , m_balanceFilter(nullptr)
+    , m_displayedPosition(-1)
+    , m_meterCleared(false)
     , m_channels(pCore->audioChannels())
     , m_balanceSlider(nullptr)
-    , m_maxLevels(qMax(30, int(service->get_fps() * 1.5)))
     , m_solo(nullptr)
     , m_record(nullptr)
     , m_collapse(nullptr)
@@ -113,10 +111,11 @@ MixerWidget::MixerWidget(int tid, Mlt::Tractor *service, QString trackTag, const
     , m_levelFilter(nullptr)
     , m_monitorFilter(nullptr)
     , m_balanceFilter(nullptr)
+    , m_displayedPosition(-1)
+    , m_meterCleared(false)
     , m_channels(pCore->audioChannels())
     , m_balanceSpin(nullptr)
     , m_balanceSlider(nullptr)
-    , m_maxLevels(qMax(30, int(service->get_fps() * 1.5)))
     , m_solo(nullptr)
     , m_record(nullptr)
     , m_collapse(nullptr)
@@ -137,6 +136,10 @@ MixerWidget::~MixerWidget()
 
 void MixerWidget::buildUI(Mlt::Tractor *service, const QString &trackName)
 {
+    // Formatted once, the audio thread reads them for each frame
+    for (int i = 0; i < qMin(m_channels, MeterLevels::maxChannels); i++) {
+        m_levelKeys.push_back(QStringLiteral("_audio_level.%1").arg(i).toUtf8());
+    }
     setFont(QFontDatabase::systemFont(QFontDatabase::SmallestReadableFont));
     // Build audio meter widget
     m_audioMeterWidget.reset(new AudioLevelWidget(width(), this));
@@ -333,7 +336,7 @@ void MixerWidget::buildUI(Mlt::Tractor *service, const QString &trackName)
             m_volumeSpin->setValue(dbValue);
             m_levelFilter->set("level", dbValue);
             m_levelFilter->set("disable", value == 60 ? 1 : 0);
-            m_levels.clear();
+            clearLevels();
             emit m_manager->purgeCache();
             pCore->setDocumentModified();
         }
@@ -345,7 +348,7 @@ void MixerWidget::buildUI(Mlt::Tractor *service, const QString &trackName)
             if (m_balanceFilter != nullptr) {
                 m_balanceFilter->set("start", (value + 50) / 100.);
                 m_balanceFilter->set("disable", value == 0 ? 1 : 0);
-                m_levels.clear();
+                clearLevels();
                 emit m_manager->purgeCache();
                 pCore->setDocumentModified();
             }
@@ -448,30 +451,51 @@ void MixerWidget::updateLabel()
 
 void MixerWidget::updateAudioLevel(int pos)
 {
-    QMutexLocker lk(&m_storeMutex);
-    if (m_levels.contains(pos)) {
-        m_audioMeterWidget->setAudioValues(m_levels.value(pos));
-        //m_levels.remove(pos);
-    } else {
+    // Store the levels received since the last refresh
+    MeterLevels levels;
+    while (m_levelQueue.pop(levels)) {
+        if (levels.position >= 0) {
+            m_levels[size_t(levels.position) % m_levels.size()] = levels;
+        }
+    }
+    if (m_recording || pos == m_displayedPosition) {
+        // While the track is armed for recording, the meter shows the capture levels
+        return;
+    }
+    const MeterLevels &current = m_levels[size_t(qMax(0, pos)) % m_levels.size()];
+    if (current.position == pos) {
+        // The levels of a frame may arrive after it is displayed, only skip the next refreshes when they were found
+        m_displayedPosition = pos;
+        m_meterCleared = false;
+        QVector<double> values(current.channels);
+        std::copy(current.values.begin(), current.values.begin() + current.channels, values.begin());
+        m_audioMeterWidget->setAudioValues(values);
+    } else if (!m_meterCleared) {
+        // No levels for this frame, reset the meter once instead of repainting it on each refresh
+        m_meterCleared = true;
         m_audioMeterWidget->setAudioValues(m_audioData);
     }
 }
 
+void MixerWidget::clearLevels()
+{
+    m_levelQueue.discard();
+    m_levels.fill(MeterLevels());
+    m_displayedPosition = -1;
+}
 
 void MixerWidget::reset()
 {
-    QMutexLocker lk(&m_storeMutex);
-    m_levels.clear();
+    clearLevels();
+    m_meterCleared = true;
     m_audioMeterWidget->setAudioValues(m_audioData);
 }
 
 void MixerWidget::clear()
 {
-    QMutexLocker lk(&m_storeMutex);
-    m_levels.clear();
+    clearLevels();
 }
 
-
 bool MixerWidget::isMute() const
 {
     return m_muteAction->isActive();
@@ -487,6 +511,8 @@ void MixerWidget::unSolo()
 
 void MixerWidget::gotRecLevels(QVector<qreal>levels)
 {
+    // Reset the meter on the first refresh after the recording is disarmed
+    m_meterCleared = false;
     switch (levels.size()) {
         case 0:
             m_audioMeterWidget->setAudioValues({-100, -100});
@@ -523,6 +549,8 @@ void MixerWidget::setRecordState(bool recording)
         }
         int level = m_levelFilter->get_int("level");
         disconnect(pCore->getAudioDevice(), &MediaCapture::audioLevels, this, &MixerWidget::gotRecLevels);
+        // Replace the capture levels with the playback levels on the next refresh
+        m_displayedPosition = -1;
         m_volumeSpin->setRange(-100, 60);
         m_volumeSpin->setSuffix(i18n("dB"));
         m_volumeSpin->setValue(level);
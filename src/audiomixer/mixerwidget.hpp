@@ -8,11 +8,14 @@
 
 #include "definitions.h"
 #include "mlt++/MltService.h"
+#include "utils/audiolevelqueue.hpp"
 
+#include <array>
 #include <memory>
 #include <unordered_map>
+#include <vector>
+#include <QByteArray>
 #include <QWidget>
-#include <QMutex>
 
 class KDualAction;
 class AudioLevelWidget;
@@ -61,6 +64,7 @@ protected:
     void mousePressEvent(QMouseEvent *event) override;
 
 public slots:
+    /** @brief Read the levels received from the audio thread and display the ones of the given position */
     void updateAudioLevel(int pos);
     void setRecordState(bool recording);
 
@@ -73,13 +77,20 @@ protected:
     std::shared_ptr<Mlt::Filter> m_levelFilter;
     std::shared_ptr<Mlt::Filter> m_monitorFilter;
     std::shared_ptr<Mlt::Filter> m_balanceFilter;
-    QMap<int, QVector<double>> m_levels;
+    /** @brief Levels sent by the audio thread, read in the GUI thread */
+    AudioLevelQueue m_levelQueue;
+    /** @brief Received levels, indexed by position modulo the queue capacity */
+    std::array<MeterLevels, AudioLevelQueue::capacity> m_levels;
+    /** @brief Names of the audio level properties of the monitor filter, by channel */
+    std::vector<QByteArray> m_levelKeys;
+    int m_displayedPosition;
+    /** @brief The meter shows no levels, it is not repainted until levels are displayed again */
+    bool m_meterCleared;
     int m_channels;
     KDualAction *m_muteAction;
     QSpinBox *m_balanceSpin;
     QSlider *m_balanceSlider;
     QDoubleSpinBox *m_volumeSpin;
-    int m_maxLevels;
 
 private:
     std::shared_ptr<AudioLevelWidget> m_audioMeterWidget;
@@ -88,7 +99,6 @@ private:
     QToolButton *m_record;
     QToolButton *m_collapse;
     KSqueezedTextLabel *m_trackLabel;
-    QMutex m_storeMutex;
     double m_lastVolume;
     QVector <double>m_audioData;
     Mlt::Event *m_listener;
@@ -96,6 +106,8 @@ private:
     const QString m_trackTag;
     /** @Update track label to reflect state */
     void updateLabel();
+    /** @brief Drop the received levels */
+    void clearLevels();
 
 signals:
     void gotLevels(QPair <double, double>);
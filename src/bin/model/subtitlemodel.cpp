@@ -23,9 +23,40 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <QTextCodec>
 #include <utility>
 
+namespace {
+// Delay in ms before the subtitle file is written after an edit
+const int subtitleWriteDelay = 300;
+
+// Formats a time as hh:mm:ss.cc for .ass files and hh:mm:ss,mmm for .srt files
+QString subtitleTime(double seconds, bool assFormat)
+{
+    int millisec = int(seconds * 1000);
+    int secs = millisec / 1000;
+    millisec %= 1000;
+    int minutes = secs / 60;
+    secs %= 60;
+    int hours = minutes / 60;
+    minutes %= 60;
+    if (assFormat) {
+        // Limit ms to 2 digits
+        return QString("%1:%2:%3.%4")
+            .arg(hours, 2, 10, QChar('0'))
+            .arg(minutes, 2, 10, QChar('0'))
+            .arg(secs, 2, 10, QChar('0'))
+            .arg(millisec / 10, 2, 10, QChar('0'));
+    }
+    return QString("%1:%2:%3,%4")
+        .arg(hours, 2, 10, QChar('0'))
+        .arg(minutes, 2, 10, QChar('0'))
+        .arg(secs, 2, 10, QChar('0'))
+        .arg(millisec, 3, 10, QChar('0'));
+}
+} // namespace
+
 SubtitleModel::SubtitleModel(Mlt::Tractor *tractor, std::shared_ptr<TimelineItemModel> timeline, QObject *parent)
     : QAbstractListModel(parent)
     , m_timeline(timeline)
@@ -47,10 +78,11 @@ SubtitleModel::SubtitleModel(Mlt::Tractor *tractor, std::shared_ptr<TimelineItem
     styleSection = QString("[V4 Styles]\nFormat: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, TertiaryColour, BackColour, Bold, Italic, BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, AlphaLevel, Encoding\nStyle: Default,Consolas,%1,16777215,65535,255,0,-1,0,1,2,2,6,40,40,%2,0,1\n").arg(fontSize).arg(fontMargin);
     eventSection = QStringLiteral("[Events]\n");
     styleName = QStringLiteral("Default");
-    connect(this, &SubtitleModel::modelChanged, [this]() {
-        jsontoSubtitle(toJson()); 
-    });
-    
+    // Successive edits are batched, the subtitle file is written once they pause
+    m_writeTimer.setSingleShot(true);
+    m_writeTimer.setInterval(subtitleWriteDelay);
+    connect(&m_writeTimer, &QTimer::timeout, this, &SubtitleModel::writeSubtitleFile);
+    connect(this, &SubtitleModel::modelChanged, &m_writeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
 }
 
 void SubtitleModel::setup()
@@ -359,6 +391,7 @@ bool SubtitleModel::addSubtitle(int id, GenTime start, GenTime end, const QStrin
     int row = m_timeline->getSubtitleIndex(id);
     beginInsertRows(QModelIndex(), row, row);
     m_subtitleList[start] = {str, end};
+    updateLongestDuration(start, end);
     endInsertRows();
     addSnapPoint(start);
     addSnapPoint(end);
@@ -487,17 +520,18 @@ std::unordered_set<int> SubtitleModel::getItemsInRange(int startFrame, int endFr
     GenTime startTime(startFrame, pCore->getCurrentFps());
     GenTime endTime(endFrame, pCore->getCurrentFps());
     std::unordered_set<int> matching;
-    for (const auto &subtitles : m_subtitleList) {
-        if (endFrame > -1 && subtitles.first > endTime) {
+    // Subtitles starting before the range can only reach it if they start less than the longest duration before it
+    for (auto subtitles = m_subtitleList.lower_bound(startTime - m_longestDuration); subtitles != m_subtitleList.end(); ++subtitles) {
+        if (endFrame > -1 && subtitles->first > endTime) {
             // Outside range
-            continue;
+            break;
         }
-        if (subtitles.first >= startTime || subtitles.second.second > startTime) {
-            int sid = getIdForStartPos(subtitles.first);
+        if (subtitles->first >= startTime || subtitles->second.second > startTime) {
+            int sid = getIdForStartPos(subtitles->first);
             if (sid > -1) {
                 matching.emplace(sid);
             } else {
-                qDebug()<<"==== FOUND INVALID SUBTILE AT: "<<subtitles.first.frames(pCore->getCurrentFps());
+                qDebug()<<"==== FOUND INVALID SUBTILE AT: "<<subtitles->first.frames(pCore->getCurrentFps());
             }
         }
     }
@@ -596,6 +630,13 @@ void SubtitleModel::removeSnapPoint(GenTime startpos)
     std::swap(m_regSnaps, validSnapModels);
 }
 
+void SubtitleModel::updateLongestDuration(GenTime start, GenTime end)
+{
+    if (end - start > m_longestDuration) {
+        m_longestDuration = end - start;
+    }
+}
+
 void SubtitleModel::editEndPos(GenTime startPos, GenTime newEndPos, bool refreshModel)
 {
     qDebug()<<"Changing the sub end timings in model";
@@ -604,6 +645,7 @@ void SubtitleModel::editEndPos(GenTime startPos, GenTime newEndPos, bool refresh
         return;
     }
     m_subtitleList[startPos].second = newEndPos;
+    updateLongestDuration(startPos, newEndPos);
     // Trigger update of the qml view
     int id = getIdForStartPos(startPos);
     int row = m_timeline->getSubtitleIndex(id);
@@ -663,6 +705,7 @@ bool SubtitleModel::requestResize(int id, int size, bool right, Fun &undo, Fun &
         GenTime newEndPos = startPos + GenTime(size, pCore->getCurrentFps());
         operation = [this, id, startPos, endPos, newEndPos, logUndo]() {
             m_subtitleList[startPos].second = newEndPos;
+            updateLongestDuration(startPos, newEndPos);
             removeSnapPoint(endPos);
             addSnapPoint(newEndPos);
             // Trigger update of the qml view
@@ -709,9 +752,10 @@ bool SubtitleModel::requestResize(int id, int size, bool right, Fun &undo, Fun &
         }
         const QString text = m_subtitleList.at(startPos).first;
         operation = [this, id, startPos, newStartPos, endPos, text, logUndo]() {
-            m_timeline->m_allSubtitles[id] = newStartPos;
+            m_timeline->setSubtitleStart(id, newStartPos);
             m_subtitleList.erase(startPos);
             m_subtitleList[newStartPos] = {text, endPos};
+            updateLongestDuration(newStartPos, endPos);
             // Trigger update of the qml view
             removeSnapPoint(startPos);
             addSnapPoint(newStartPos);
@@ -731,7 +775,7 @@ bool SubtitleModel::requestResize(int id, int size, bool right, Fun &undo, Fun &
             return true;
         };
         reverse = [this, id, startPos, newStartPos, endPos, text, logUndo]() {
-            m_timeline->m_allSubtitles[id] = startPos;
+            m_timeline->setSubtitleStart(id, startPos);
             m_subtitleList.erase(newStartPos);
             m_subtitleList[startPos] = {text, endPos};
             removeSnapPoint(newStartPos);
@@ -806,6 +850,9 @@ bool SubtitleModel::removeSubtitle(int id, bool temporary, bool updateFilter)
         lastSub = true;
     }
     m_subtitleList.erase(start);
+    if (m_subtitleList.empty()) {
+        m_longestDuration = GenTime();
+    }
     endRemoveRows();
     removeSnapPoint(start);
     removeSnapPoint(end);
@@ -863,7 +910,7 @@ bool SubtitleModel::moveSubtitle(int subId, GenTime newPos, bool updateModel, bo
     GenTime duration = m_subtitleList[oldPos].second - oldPos;
     GenTime endPos = newPos + duration;
     int id = getIdForStartPos(oldPos);
-    m_timeline->m_allSubtitles[id] = newPos;
+    m_timeline->setSubtitleStart(id, newPos);
     m_subtitleList.erase(oldPos);
     m_subtitleList[newPos] = {subtitleText, endPos};
     addSnapPoint(newPos);
@@ -892,13 +939,7 @@ bool SubtitleModel::moveSubtitle(int subId, GenTime newPos, bool updateModel, bo
 
 int SubtitleModel::getIdForStartPos(GenTime startTime) const
 {
-    auto findResult = std::find_if(std::begin(m_timeline->m_allSubtitles), std::end(m_timeline->m_allSubtitles), [&](const std::pair<int, GenTime> &pair) {
-        return pair.second == startTime;
-    });
-    if (findResult != std::end(m_timeline->m_allSubtitles)) {
-        return findResult->first;
-    }
-    return -1;
+    return m_timeline->getSubtitleIdForStart(startTime);
 }
 
 GenTime SubtitleModel::getStartPosForId(int id) const
@@ -956,6 +997,7 @@ QString SubtitleModel::toJson()
 
 void SubtitleModel::copySubtitle(const QString &path, bool checkOverwrite)
 {
+    flushSubtitleFile();
     QFile srcFile(pCore->currentDoc()->subTitlePath(false));
     if (srcFile.exists()) {
         QFile prev(path);
@@ -975,16 +1017,10 @@ void SubtitleModel::copySubtitle(const QString &path, bool checkOverwrite)
 void SubtitleModel::jsontoSubtitle(const QString &data)
 {
     QString outFile = pCore->currentDoc()->subTitlePath(false);
-    QString masterFile = m_subtitleFilter->get("av.filename");
-    if (masterFile.isEmpty()) {
-        m_subtitleFilter->set("av.filename", outFile.toUtf8().constData());
-    }
     bool assFormat = outFile.endsWith(".ass");
     if (!assFormat) {
         qDebug()<< "srt file import"; // if imported file isn't .ass, it is .srt format
     }
-    QFile outF(outFile);
-
     //qDebug()<< "Import from JSON";
     QWriteLocker locker(&m_lock);
     auto json = QJsonDocument::fromJson(data.toUtf8());
@@ -994,85 +1030,95 @@ void SubtitleModel::jsontoSubtitle(const QString &data)
     }
     int line=0;
     auto list = json.array();
-    if (outF.open(QIODevice::WriteOnly)) {
-        QTextStream out(&outF);
-        out.setCodec("UTF-8");
-        if (assFormat) {
-            out<<scriptInfoSection<<'\n';
-            out<<styleSection<<'\n';
-            out<<eventSection;
+    QString content = subtitleHeader(assFormat);
+    for (const auto &entry : qAsConst(list)) {
+        if (!entry.isObject()) {
+            qDebug() << "Warning : Skipping invalid subtitle data";
+            continue;
         }
-        for (const auto &entry : qAsConst(list)) {
-            if (!entry.isObject()) {
-                qDebug() << "Warning : Skipping invalid subtitle data";
-                continue;
-            }
-            auto entryObj = entry.toObject();
-            if (!entryObj.contains(QLatin1String("startPos"))) {
-                qDebug() << "Warning : Skipping invalid subtitle data (does not contain position)";
-                continue;
-            }
-            double startPos = entryObj[QLatin1String("startPos")].toDouble();
-            //convert seconds to FORMAT= hh:mm:ss.SS (in .ass) and hh:mm:ss,SSS (in .srt)
-            int millisec = int(startPos * 1000);
-            int seconds = millisec / 1000;
-            millisec %=1000;
-            int minutes = seconds / 60;
-            seconds %= 60;
-            int hours = minutes /60;
-            minutes %= 60;
-            int milli_2 = millisec / 10;
-            QString startTimeString = QString("%1:%2:%3.%4")
-              .arg(hours, 2, 10, QChar('0'))
-              .arg(minutes, 2, 10, QChar('0'))
-              .arg(seconds, 2, 10, QChar('0'))
-              .arg(milli_2,2,10,QChar('0'));
-            QString startTimeStringSRT = QString("%1:%2:%3,%4")
-              .arg(hours, 2, 10, QChar('0'))
-              .arg(minutes, 2, 10, QChar('0'))
-              .arg(seconds, 2, 10, QChar('0'))
-              .arg(millisec,3,10,QChar('0'));
-            QString dialogue = entryObj[QLatin1String("dialogue")].toString();
-            double endPos = entryObj[QLatin1String("endPos")].toDouble();
-            millisec = int(endPos * 1000);
-            seconds = millisec / 1000;
-            millisec %=1000;
-            minutes = seconds / 60;
-            seconds %= 60;
-            hours = minutes /60;
-            minutes %= 60;
-
-            milli_2 = millisec / 10; // to limit ms to 2 digits (for .ass)
-            QString endTimeString = QString("%1:%2:%3.%4")
-              .arg(hours, 2, 10, QChar('0'))
-              .arg(minutes, 2, 10, QChar('0'))
-              .arg(seconds, 2, 10, QChar('0'))
-              .arg(milli_2,2,10,QChar('0'));
-
-            QString endTimeStringSRT = QString("%1:%2:%3,%4")
-              .arg(hours, 2, 10, QChar('0'))
-              .arg(minutes, 2, 10, QChar('0'))
-              .arg(seconds, 2, 10, QChar('0'))
-              .arg(millisec,3,10,QChar('0'));
-            line++;
-            if (assFormat) {
-                //Format: Layer, Start, End, Style, Actor, MarginL, MarginR, MarginV, Effect, Text
-                out <<"Dialogue: 0,"<<startTimeString<<","<<endTimeString<<","<<styleName<<",,0000,0000,0000,,"<<dialogue<<'\n';
-            } else {
-                out<<line<<"\n"<<startTimeStringSRT<<" --> "<<endTimeStringSRT<<"\n"<<dialogue<<"\n"<<'\n';
-            }
-            
-            //qDebug() << "ADDING SUBTITLE to FILE AT START POS: " << startPos <<" END POS: "<<endPos;//<< ", FPS: " << pCore->getCurrentFps();
+        auto entryObj = entry.toObject();
+        if (!entryObj.contains(QLatin1String("startPos"))) {
+            qDebug() << "Warning : Skipping invalid subtitle data (does not contain position)";
+            continue;
         }
-        outF.close();
+        double startPos = entryObj[QLatin1String("startPos")].toDouble();
+        double endPos = entryObj[QLatin1String("endPos")].toDouble();
+        content += subtitleEntry(++line, startPos, endPos, entryObj[QLatin1String("dialogue")].toString(), assFormat);
+    }
+    saveSubtitleFile(outFile, content, line);
+}
+
+void SubtitleModel::writeSubtitleFile()
+{
+    m_writeTimer.stop();
+    QString outFile = pCore->currentDoc()->subTitlePath(false);
+    bool assFormat = outFile.endsWith(".ass");
+    QWriteLocker locker(&m_lock);
+    // Written directly from the model, without going through json
+    int line = 0;
+    QString content = subtitleHeader(assFormat);
+    for (const auto &subtitle : m_subtitleList) {
+        content += subtitleEntry(++line, subtitle.first.seconds(), subtitle.second.second.seconds(), subtitle.second.first, assFormat);
+    }
+    saveSubtitleFile(outFile, content, line);
+}
+
+void SubtitleModel::flushSubtitleFile()
+{
+    if (m_writeTimer.isActive()) {
+        writeSubtitleFile();
+    }
+}
+
+QString SubtitleModel::subtitleHeader(bool assFormat) const
+{
+    if (assFormat) {
+        return scriptInfoSection + QLatin1Char('\n') + styleSection + QLatin1Char('\n') + eventSection;
+    }
+    return QString();
+}
+
+QString SubtitleModel::subtitleEntry(int line, double startPos, double endPos, const QString &dialogue, bool assFormat) const
+{
+    if (assFormat) {
+        //Format: Layer, Start, End, Style, Actor, MarginL, MarginR, MarginV, Effect, Text
+        return QStringLiteral("Dialogue: 0,%1,%2,%3,,0000,0000,0000,,%4\n").arg(subtitleTime(startPos, true), subtitleTime(endPos, true), styleName, dialogue);
+    }
+    return QStringLiteral("%1\n%2 --> %3\n%4\n\n").arg(QString::number(line), subtitleTime(startPos, false), subtitleTime(endPos, false), dialogue);
+}
+
+void SubtitleModel::saveSubtitleFile(const QString &outFile, const QString &content, int lines)
+{
+    const QByteArray data = content.toUtf8();
+    if (data == m_writtenData && outFile == m_writtenFile) {
+        // Nothing changed since the last write, do not make the filter reload the file
+        return;
     }
+    QSaveFile outF(outFile);
+    if (!outF.open(QIODevice::WriteOnly)) {
+        qDebug() << "Cannot write subtitle file" << outFile;
+        return;
+    }
+    outF.write(data);
+    if (!outF.commit()) {
+        qDebug() << "Error writing subtitle file" << outFile;
+        return;
+    }
+    m_writtenData = data;
+    m_writtenFile = outFile;
     qDebug()<<"Saving subtitle filter: "<<outFile;
-    if (line > 0) {
-        m_subtitleFilter->set("av.filename", outFile.toUtf8().constData());
-        m_tractor->attach(*m_subtitleFilter.get());
-    } else {
-        m_tractor->detach(*m_subtitleFilter.get());
+    if (m_tractor) {
+        if (lines > 0) {
+            m_subtitleFilter->set("av.filename", outFile.toUtf8().constData());
+            m_tractor->attach(*m_subtitleFilter.get());
+        } else {
+            m_tractor->detach(*m_subtitleFilter.get());
+        }
     }
+    // The edit already refreshed the monitor, before the file was written
+    int duration = trackDuration();
+    pCore->refreshProjectRange({0, qMax(duration, m_writtenDuration)});
+    m_writtenDuration = duration;
 }
 
 void SubtitleModel::updateSub(int id, const QVector <int> &roles)
@@ -13,6 +13,7 @@
 
 #include <QAbstractListModel>
 #include <QReadWriteLock>
+#include <QTimer>
 
 #include <array>
 #include <map>
@@ -116,6 +117,8 @@ public:
     int getNextSub(int id) const;
     /** @brief Copy subtitle file to a new path */
     void copySubtitle(const QString &path, bool checkOverwrite);
+    /** @brief Write the pending changes to the subtitle file now, instead of waiting for the edits to pause */
+    void flushSubtitleFile();
     int trackDuration() const;
     void switchDisabled();
     bool isDisabled() const;
@@ -154,6 +157,8 @@ private:
     std::weak_ptr<DocUndoStack> m_undoStack;
     /** @brief A list of subtitles as: start time, text, end time */
     std::map<GenTime, std::pair<QString, GenTime>> m_subtitleList;
+    /** @brief No subtitle is longer than this, used to find the subtitles overlapping a position without scanning the list */
+    GenTime m_longestDuration;
 
     QString scriptInfoSection, styleSection,eventSection;
     QString styleName;
@@ -169,6 +174,19 @@ private:
     Mlt::Tractor *m_tractor;
     QVector <int> m_selected;
     QVector <int> m_grabbedIds;
+    /** @brief Delays the writing of the subtitle file until the edits pause */
+    QTimer m_writeTimer;
+    /** @brief Last content written to the subtitle file, unchanged content is not written again */
+    QByteArray m_writtenData;
+    QString m_writtenFile;
+    int m_writtenDuration{0};
+
+    /** @brief Write the subtitle file from the model */
+    void writeSubtitleFile();
+    QString subtitleHeader(bool assFormat) const;
+    QString subtitleEntry(int line, double startPos, double endPos, const QString &dialogue, bool assFormat) const;
+    /** @brief Write the subtitle file if its content changed, and attach the subtitle filter if it has subtitles */
+    void saveSubtitleFile(const QString &outFile, const QString &content, int lines);
 
 signals:
     void modelChanged();
@@ -180,6 +198,8 @@ protected:
     void removeSnapPoint(GenTime startpos);
     /** @brief Connect changes in model with signal */
     void setup();
+    /** @brief Keep m_longestDuration up to date when a subtitle is added or resized */
+    void updateLongestDuration(GenTime start, GenTime end);
 
 };
 Q_DECLARE_METATYPE(SubtitleModel *)
@@ -19,6 +19,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "jobs/cliploadtask.h"
 #include "jobs/proxytask.h"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioLevels.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "macros.hpp"
 #include "mltcontroller/clipcontroller.h"
@@ -33,7 +34,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "utils/timecode.h"
 #include "timeline2/model/snapmodel.hpp"
 
+#include "utils/filehashcache.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailgenerator.hpp"
 #include "xml/xml.hpp"
 #include <QPainter>
 #include <kimagecache.h>
@@ -46,6 +49,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QDir>
 #include <QDomElement>
 #include <QFile>
+#include <QPointer>
 #include <memory>
 
 #ifdef CRASH_AUTO_TEST
@@ -178,6 +182,7 @@ std::shared_ptr<ProjectClip> ProjectClip::construct(const QString &id, const QDo
 
 ProjectClip::~ProjectClip()
 {
+    ThumbnailGenerator::get()->releaseProducers(m_binId);
 }
 
 void ProjectClip::connectEffectStack()
@@ -215,7 +220,7 @@ void ProjectClip::updateAudioThumbnail(bool cachedThumb)
 {
     emit audioThumbReady();
     if (m_clipType == ClipType::Audio) {
-        QImage thumb = ThumbnailCache::get()->getThumbnail(m_binId, 0);
+        QImage thumb = ThumbnailCache::get()->getThumbnail(m_binId, 0, true);
         if (thumb.isNull() && !pCore->taskManager.hasPendingJob({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::AUDIOTHUMBJOB)) {
             int iconHeight = int(QFontInfo(qApp->font()).pixelSize() * 3.5);
             QImage img(QSize(int(iconHeight * pCore->getCurrentDar()), iconHeight), QImage::Format_ARGB32);
@@ -382,7 +387,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
         ThumbnailCache::get()->invalidateThumbsForClip(m_binId);
         pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::LOADJOB, true);
         pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::CACHEJOB);
-        m_thumbsProducer.reset();
+        resetThumbProducers();
         // Reset uuid to enforce reloading thumbnails from qml cache
         m_uuid = QUuid::createUuid();
         updateTimelineClips({TimelineModel::ClipThumbRole});
@@ -407,7 +412,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
         }
         if (!xml.isNull()) {
             bool hashChanged = false;
-            m_thumbsProducer.reset();
+            resetThumbProducers();
             m_clipStatus = FileStatus::StatusWaiting;
             ClipType::ProducerType type = clipType();
             if (type != ClipType::Color && type != ClipType::Image && type != ClipType::SlideShow) {
@@ -431,7 +436,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
                 discardAudioThumb();
             }
             ThumbnailCache::get()->invalidateThumbsForClip(clipId());
-            m_thumbsProducer.reset();
+            resetThumbProducers();
             ClipLoadTask::start({ObjectType::BinClip,m_binId.toInt()}, xml, false, -1, -1, this);
         }
     }
@@ -518,7 +523,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool gene
     FileStatus::ClipStatus currentStatus = m_clipStatus;
     updateProducer(producer);
     emit producerChanged(m_binId, producer);
-    m_thumbsProducer.reset();
+    resetThumbProducers();
     connectEffectStack();
 
     // Update info
@@ -653,13 +658,26 @@ std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
     if (m_thumbsProducer) {
         return m_thumbsProducer;
     }
+    QMutexLocker lock(&m_thumbMutex);
+    m_thumbsProducer = buildThumbProducer();
+    return m_thumbsProducer;
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::createThumbProducer()
+{
+    QMutexLocker lock(&m_thumbMutex);
+    return buildThumbProducer();
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::buildThumbProducer()
+{
     if (clipType() == ClipType::Unknown || m_masterProducer == nullptr || m_clipStatus == FileStatus::StatusWaiting) {
         return nullptr;
     }
-    QMutexLocker lock(&m_thumbMutex);
+    std::shared_ptr<Mlt::Producer> thumbProducer;
     if (KdenliveSettings::gpu_accel()) {
         // TODO: when the original producer changes, we must reload this thumb producer
-        m_thumbsProducer = softClone(ClipController::getPassPropertiesList());
+        thumbProducer = softClone(ClipController::getPassPropertiesList());
     } else {
         QString mltService = m_masterProducer->get("mlt_service");
         const QString mltResource = m_masterProducer->get("resource");
@@ -671,28 +689,34 @@ std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
             // Xml producers can corrupt the profile, so enforce width/height again after loading
             int profileWidth = profile->width();
             int profileHeight= profile->height();
-            m_thumbsProducer.reset(new Mlt::Producer(*profile, "consumer", mltResource.toUtf8().constData()));
+            thumbProducer.reset(new Mlt::Producer(*profile, "consumer", mltResource.toUtf8().constData()));
             profile->set_width(profileWidth);
             profile->set_height(profileHeight);
         } else {
-            m_thumbsProducer.reset(new Mlt::Producer(*profile, mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
+            thumbProducer.reset(new Mlt::Producer(*profile, mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
         }
-        if (m_thumbsProducer->is_valid()) {
+        if (thumbProducer->is_valid()) {
             Mlt::Properties original(m_masterProducer->get_properties());
-            Mlt::Properties cloneProps(m_thumbsProducer->get_properties());
+            Mlt::Properties cloneProps(thumbProducer->get_properties());
             cloneProps.pass_list(original, ClipController::getPassPropertiesList());
             Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
             Mlt::Filter padder(*pCore->thumbProfile(), "resize");
             Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
-            m_thumbsProducer->set("audio_index", -1);
+            thumbProducer->set("audio_index", -1);
             // Required to make get_playtime() return > 1
-            m_thumbsProducer->set("out", m_thumbsProducer->get_length() -1);
-            m_thumbsProducer->attach(scaler);
-            m_thumbsProducer->attach(padder);
-            m_thumbsProducer->attach(converter);
+            thumbProducer->set("out", thumbProducer->get_length() -1);
+            thumbProducer->attach(scaler);
+            thumbProducer->attach(padder);
+            thumbProducer->attach(converter);
         }
     }
-    return m_thumbsProducer;
+    return thumbProducer;
+}
+
+void ProjectClip::resetThumbProducers()
+{
+    m_thumbsProducer.reset();
+    ThumbnailGenerator::get()->releaseProducers(m_binId);
 }
 
 void ProjectClip::createDisabledMasterProducer()
@@ -1166,7 +1190,7 @@ const QString ProjectClip::hash()
 
 const QByteArray ProjectClip::getFolderHash(const QDir &dir, QString fileName)
 {
-    QStringList files = dir.entryList(QDir::Files);
+    QStringList files = FileHashCache::get()->folderEntries(dir);
     fileName.append(files.join(QLatin1Char(',')));
     // Include file hash info in case we have several folders with same file names (can happen for image sequences)
     if (!files.isEmpty()) {
@@ -1226,28 +1250,8 @@ const QString ProjectClip::getFileHash()
 
 const QPair<QByteArray, qint64> ProjectClip::calculateHash(const QString &path)
 {
-    QFile file(path);
-    QByteArray fileHash;
-    qint64 fSize = 0;
-    if (file.open(QIODevice::ReadOnly)) { // write size and hash only if resource points to a file
-        /*
-        * 1 MB = 1 second per 450 files (or faster)
-        * 10 MB = 9 seconds per 450 files (or faster)
-        */
-        QByteArray fileData;
-        fSize = file.size();
-        if (fSize > 2000000) {
-            fileData = file.read(1000000);
-            if (file.seek(file.size() - 1000000)) {
-                fileData.append(file.readAll());
-            }
-        } else {
-            fileData = file.readAll();
-        }
-        file.close();
-        fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-    }
-    return {fileHash, fSize};
+    // Files are only read again when their size or modification time changed
+    return FileHashCache::get()->hash(path);
 }
 
 double ProjectClip::getOriginalFps() const
@@ -1585,6 +1589,7 @@ void ProjectClip::discardAudioThumb()
         audioThumbPath = getAudioThumbPath(st);
         if (!audioThumbPath.isEmpty()) {
             QFile::remove(audioThumbPath);
+            QFile::remove(getAudioThumbPath(st, true));
         }
         // Clear audio cache
         QString key = QString("%1:%2").arg(m_binId).arg(st);
@@ -1615,7 +1620,7 @@ int ProjectClip::getAudioStreamFfmpegIndex(int mltStream)
     return -1;
 }
 
-const QString ProjectClip::getAudioThumbPath(int stream)
+const QString ProjectClip::getAudioThumbPath(int stream, bool legacyFormat)
 {
     if (audioInfo() == nullptr) {
         return QString();
@@ -1632,7 +1637,7 @@ const QString ProjectClip::getAudioThumbPath(int stream)
     QString audioPath = thumbFolder.absoluteFilePath(clipHash);
     audioPath.append(QLatin1Char('_') + QString::number(stream));
     int roundedFps = int(pCore->getCurrentFps());
-    audioPath.append(QStringLiteral("_%1_audio.png").arg(roundedFps));
+    audioPath.append(QStringLiteral("_%1_audio.%2").arg(roundedFps).arg(legacyFormat ? QStringLiteral("png") : QStringLiteral("levels")));
     return audioPath;
 }
 
@@ -1908,7 +1913,18 @@ void ProjectClip::getThumbFromPercent(int percent, bool storeFrame)
     if (percent < 0) {
         if (hasProducerProperty(QStringLiteral("kdenlive:thumbnailFrame"))) {
             int framePos = qMax(0, getProducerIntProperty(QStringLiteral("kdenlive:thumbnailFrame")));
-            setThumbnail(ThumbnailCache::get()->getThumbnail(m_binId, framePos), -1, -1);
+            QImage thumb = ThumbnailCache::get()->getThumbnail(m_binId, framePos, true);
+            if (!thumb.isNull()) {
+                setThumbnail(thumb, -1, -1);
+            } else {
+                // Don't wait for the disk in the GUI thread
+                QPointer<ProjectClip> self(this);
+                ThumbnailCache::get()->loadThumbnail(m_binId, framePos, [self](const QImage &img) {
+                    if (self) {
+                        self->setThumbnail(img, -1, -1);
+                    }
+                });
+            }
         }
         return;
     }
@@ -1916,10 +1932,10 @@ void ProjectClip::getThumbFromPercent(int percent, bool storeFrame)
     int steps = qCeil(qMax(pCore->getCurrentFps(), double(duration) / 30));
     int framePos = duration * percent / 100;
     framePos -= framePos%steps;
-    if (ThumbnailCache::get()->hasThumbnail(m_binId, framePos)) {
-        setThumbnail(ThumbnailCache::get()->getThumbnail(m_binId, framePos), -1, -1);
+    if (ThumbnailCache::get()->hasThumbnail(m_binId, framePos, true)) {
+        setThumbnail(ThumbnailCache::get()->getThumbnail(m_binId, framePos, true), -1, -1);
     } else {
-        // Generate percent thumbs
+        // Load percent thumbs from the persistent cache, or generate them
         CacheTask::start({ObjectType::BinClip,m_binId.toInt()}, 30, 0, 0, this);
     }
     if (storeFrame) {
@@ -1941,11 +1957,7 @@ int ProjectClip::getAudioMax(int stream)
         return m_masterProducer->get_int(key.toUtf8().constData());
     }
     // Process audio max for the stream
-    const QString key2 = QString("_kdenlive:audio%1").arg(stream);
-    if (!m_masterProducer->property_exists(key2.toUtf8().constData())) {
-        return 0;
-    }
-    const QVector <uint8_t> audioData = *static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key2.toUtf8().constData()));
+    const QVector <uint8_t> audioData = audioFrameCache(stream);
     if (audioData.isEmpty()) {
         return 0;
     }
@@ -1964,14 +1976,23 @@ const QVector <uint8_t> ProjectClip::audioFrameCache(int stream)
             return audioLevels;
         }
     }
-    const QString key = QString("_kdenlive:audio%1").arg(stream);
-    if (m_masterProducer->get_data(key.toUtf8().constData())) {
-        const QVector <uint8_t> audioData = *static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key.toUtf8().constData()));
-        return audioData;
-    } else {
+    const QByteArray key = QString("_kdenlive:audio%1").arg(stream).toUtf8();
+    const QByteArray validKey = QString("_kdenlive:audiovalid%1").arg(stream).toUtf8();
+    // The audio levels task shares its buffer while decoding, only the valid part of it can be read
+    bool found = false;
+    int validSize = 0;
+    m_masterProducer->lock();
+    auto *published = static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key.constData()));
+    if (published) {
+        found = true;
+        audioLevels = *published;
+        validSize = m_masterProducer->get_int(validKey.constData());
+    }
+    m_masterProducer->unlock();
+    if (!found) {
         qDebug()<<"=== AUDIO NOT FOUND ";
     }
-    return QVector <uint8_t>();
+    return audioLevels.mid(0, validSize);
     
     // TODO
     /*QString key = QString("%1:%2").arg(m_binId).arg(stream);
@@ -2005,6 +2026,26 @@ const QVector <uint8_t> ProjectClip::audioFrameCache(int stream)
     return audioLevels;*/
 }
 
+const AudioLevels ProjectClip::audioLevelsPyramid(int stream)
+{
+    if (stream == -1) {
+        if (m_audioInfo) {
+            stream = m_audioInfo->ffmpeg_audio_index();
+        } else {
+            return AudioLevels();
+        }
+    }
+    const QString key = QString("_kdenlive:audiolod%1").arg(stream);
+    AudioLevels result;
+    m_masterProducer->lock();
+    auto *levels = static_cast<AudioLevels *>(m_masterProducer->get_data(key.toUtf8().constData()));
+    if (levels) {
+        result = *levels;
+    }
+    m_masterProducer->unlock();
+    return result;
+}
+
 void ProjectClip::setClipStatus(FileStatus::ClipStatus status)
 {
     AbstractProjectItem::setClipStatus(status);
@@ -20,6 +20,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QUuid>
 #include <memory>
 
+class AudioLevels;
 class ClipPropertiesController;
 class ProjectFolder;
 class ProjectSubClip;
@@ -131,6 +132,8 @@ public:
 
     /** @brief Returns this clip's producer. */
     std::shared_ptr<Mlt::Producer> thumbProducer() override;
+    /** @brief Create a new producer for thumbnails, independent from thumbProducer() so that several frames can be extracted in parallel */
+    std::shared_ptr<Mlt::Producer> createThumbProducer();
 
     /** @brief Recursively disable/enable bin effects. */
     void setBinEffectsEnabled(bool enabled) override;
@@ -145,7 +148,7 @@ public:
 
     /** @brief The clip hash created from the clip's resource. */
     const QString hash();
-    /** @brief Callculate a file hash from a path. */
+    /** @brief Callculate a file hash from a path. The hash is cached until the file changes, see FileHashCache. */
     static const QPair<QByteArray, qint64> calculateHash(const QString &path);
 
     /** @brief Returns true if we are using a proxy for this clip. */
@@ -168,8 +171,9 @@ public:
     QStringList subClipIds() const;
     /** @brief Delete cached audio thumb - needs to be recreated */
     void discardAudioThumb();
-    /** @brief Get path for this clip's audio thumbnail */
-    const QString getAudioThumbPath(int stream);
+    /** @brief Get path for this clip's audio levels cache file
+     *  @param legacyFormat if true, return the path of the PNG file used by older versions */
+    const QString getAudioThumbPath(int stream, bool legacyFormat = false);
     /** @brief Returns true if this producer has audio and can be splitted on timeline*/
     bool isSplittable() const;
 
@@ -208,6 +212,9 @@ public:
     /** @brief Return audio cache for a stream
      */
     const QVector <uint8_t> audioFrameCache(int stream = -1);
+    /** @brief Return the audio levels of a stream with their decimations, or empty levels if they are not fully computed yet
+     */
+    const AudioLevels audioLevelsPyramid(int stream = -1);
     /** @brief Return FFmpeg's audio stream index for an MLT audio stream index
      */
     int getAudioStreamFfmpegIndex(int mltStream);
@@ -303,6 +310,10 @@ private:
     const QString getFileHash();
     QMutex m_producerMutex;
     QMutex m_thumbMutex;
+    /** @brief Build a thumbnail producer from the master producer. m_thumbMutex must be locked */
+    std::shared_ptr<Mlt::Producer> buildThumbProducer();
+    /** @brief Discard the thumbnail producers, for example when the clip is reloaded */
+    void resetThumbProducers();
     const QString geometryWithOffset(const QString &data, int offset);
     QMap <QString, QByteArray> m_audioLevels;
     /** @brief If true, all timeline occurrences of this clip will be replaced from a fresh producer on reload. */
@@ -16,6 +16,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "jobs/audiolevelstask.h"
 #include "jobs/cliploadtask.h"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioLevels.h"
 #include "lib/localeHandling.h"
 #include "macros.hpp"
 #include "profiles/profilemodel.hpp"
@@ -387,37 +388,44 @@ std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &bin
     if (binId.contains(QLatin1Char('_'))) {
         return getClipByBinID(binId.section(QLatin1Char('_'), 0, 0));
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c);
-        }
+    auto it = m_clipsByBinId.find(binId);
+    if (it == m_clipsByBinId.end()) {
+        return nullptr;
     }
-    return nullptr;
+    return it->second.lock();
 }
 
 const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c)->audioFrameCache(stream);
+    auto it = m_clipsByBinId.find(binId);
+    if (it != m_clipsByBinId.end()) {
+        if (auto clip = it->second.lock()) {
+            return clip->audioFrameCache(stream);
         }
     }
     return QVector<uint8_t>();
 }
 
+const AudioLevels ProjectItemModel::getAudioLevelsPyramidByBinID(const QString &binId, int stream)
+{
+    READ_LOCK();
+    auto it = m_clipsByBinId.find(binId);
+    if (it != m_clipsByBinId.end()) {
+        if (auto clip = it->second.lock()) {
+            return clip->audioLevelsPyramid(stream);
+        }
+    }
+    return AudioLevels();
+}
+
 double ProjectItemModel::getAudioMaxLevel(const QString &binId, int stream)
 {
     READ_LOCK();
-    for (const auto &item : m_allItems) {
-        auto i = std::static_pointer_cast<AbstractProjectItem>(item.second.lock());
-        if (i->itemType() == AbstractProjectItem::ClipItem && i->clipId() == binId) {
-            auto clip = std::static_pointer_cast<ProjectClip>(i);
-            if (clip) {
-                return clip->getAudioMax(stream);
-            }
+    auto it = m_clipsByBinId.find(binId);
+    if (it != m_clipsByBinId.end()) {
+        if (auto clip = it->second.lock()) {
+            return clip->getAudioMax(stream);
         }
     }
     return 0;
@@ -469,6 +477,13 @@ const QString ProjectItemModel::getFolderIdByName(const QString &folderName)
 std::shared_ptr<AbstractProjectItem> ProjectItemModel::getItemByBinId(const QString &binId)
 {
     READ_LOCK();
+    auto it = m_clipsByBinId.find(binId);
+    if (it != m_clipsByBinId.end()) {
+        if (auto clip = it->second.lock()) {
+            return clip;
+        }
+    }
+    // Folders and subclips are not indexed
     for (const auto &clip : m_allItems) {
         auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
         if (c->clipId() == binId) {
@@ -637,6 +652,7 @@ void ProjectItemModel::registerItem(const std::shared_ptr<TreeItem> &item)
     AbstractTreeModel::registerItem(item);
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = std::static_pointer_cast<ProjectClip>(clip);
+        m_clipsByBinId[clipItem->clipId()] = clipItem;
         updateWatcher(clipItem);
     }
 }
@@ -649,6 +665,11 @@ void ProjectItemModel::deregisterItem(int id, TreeItem *item)
     AbstractTreeModel::deregisterItem(id, item);
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = static_cast<ProjectClip *>(clip);
+        auto it = m_clipsByBinId.find(clipItem->clipId());
+        // The item may be deregistered while being destroyed, when its weak pointer already expired
+        if (it != m_clipsByBinId.end() && (it->second.expired() || it->second.lock().get() == clipItem)) {
+            m_clipsByBinId.erase(it);
+        }
         m_fileWatcher->removeFile(clipItem->clipId());
     }
 }
@@ -19,8 +19,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QReadWriteLock>
 #include <QSize>
 #include <QUuid>
+#include <unordered_map>
 
 class AbstractProjectItem;
+class AudioLevels;
 class BinPlaylist;
 class FileWatcher;
 class MarkerListModel;
@@ -50,6 +52,7 @@ public:
     ~ProjectItemModel() override;
 
     friend class ProjectClip;
+    friend class TimelineModel;
     
     /** @brief Builds the MLT playlist, can only be done after MLT is correctly initialized */
     void buildPlaylist();
@@ -58,6 +61,8 @@ public:
     std::shared_ptr<ProjectClip> getClipByBinID(const QString &binId);
     /** @brief Returns audio levels for a clip from its id */
     const QVector <uint8_t>getAudioLevelsByBinID(const QString &binId, int stream);
+    /** @brief Returns audio levels and their decimations for a clip from its id, used to draw zoomed out waveforms */
+    const AudioLevels getAudioLevelsPyramidByBinID(const QString &binId, int stream);
     double getAudioMaxLevel(const QString &binId, int stream);
 
     /** @brief Returns a list of clips using the given url */
@@ -247,6 +252,9 @@ private:
 
     std::unique_ptr<FileWatcher> m_fileWatcher;
 
+    /** @brief Bin clips by bin id, maintained on item registration so that clip lookups do not scan all items */
+    std::unordered_map<QString, std::weak_ptr<ProjectClip>> m_clipsByBinId;
+
     int m_nextId;
     QIcon m_blankThumb;
     PlaylistState::ClipState m_dragType;
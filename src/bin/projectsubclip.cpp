@@ -19,6 +19,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <KLocalizedString>
 #include <QDomElement>
 #include <QPainter>
+#include <QPointer>
 #include <utility>
 
 class ClipController;
@@ -187,17 +188,28 @@ void ProjectSubClip::getThumbFromPercent(int percent)
 {
     // extract a maximum of 30 frames for bin preview
     if (percent < 0) {
-        setThumbnail(ThumbnailCache::get()->getThumbnail(m_binId, m_inPoint));
+        QImage thumb = ThumbnailCache::get()->getThumbnail(m_binId, m_inPoint, true);
+        if (!thumb.isNull()) {
+            setThumbnail(thumb);
+        } else {
+            // Don't wait for the disk in the GUI thread
+            QPointer<ProjectSubClip> self(this);
+            ThumbnailCache::get()->loadThumbnail(m_binId, m_inPoint, [self](const QImage &img) {
+                if (self) {
+                    self->setThumbnail(img);
+                }
+            });
+        }
         return;
     }
     int duration = m_outPoint - m_inPoint;
     int steps = qCeil(qMax(pCore->getCurrentFps(), double(duration) / 30));
     int framePos = duration * percent / 100;
     framePos -= framePos%steps;
-    if (ThumbnailCache::get()->hasThumbnail(m_parentClipId, m_inPoint + framePos)) {
-        setThumbnail(ThumbnailCache::get()->getThumbnail(m_parentClipId, m_inPoint + framePos));
+    if (ThumbnailCache::get()->hasThumbnail(m_parentClipId, m_inPoint + framePos, true)) {
+        setThumbnail(ThumbnailCache::get()->getThumbnail(m_parentClipId, m_inPoint + framePos, true));
     } else {
-        // Generate percent thumbs
+        // Load percent thumbs from the persistent cache, or generate them
         CacheTask::start({ObjectType::BinClip,m_parentClipId.toInt()}, 30, m_inPoint, m_outPoint, this);
     }
 }
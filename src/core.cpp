@@ -784,9 +784,9 @@ void Core::pushUndo(const Fun &undo, const Fun &redo, const QString &text)
     undoStack()->push(new FunctionalUndoCommand(undo, redo, text));
 }
 
-void Core::pushUndo(QUndoCommand *command)
+void Core::pushUndo(QUndoCommand *command, const QJsonObject &operation)
 {
-    undoStack()->push(command);
+    undoStack()->push(command, operation);
 }
 
 int Core::undoIndex() const
@@ -851,6 +851,12 @@ std::shared_ptr<EffectStackModel> Core::getItemEffectStack(int itemType, int ite
     }
 }
 
+QJsonObject Core::journalAddress(const ObjectId &id)
+{
+    if (!m_guiConstructed) return QJsonObject();
+    return m_mainWindow->getCurrentTimeline()->model()->journalAddress(id);
+}
+
 std::shared_ptr<DocUndoStack> Core::undoStack()
 {
     return projectManager()->undoStack();
@@ -10,6 +10,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "jobs/taskmanager.h"
 #include "kdenlivecore_export.h"
 #include "undohelper.hpp"
+#include <QJsonObject>
 #include <QMutex>
 #include <QObject>
 #include <QColor>
@@ -171,7 +172,8 @@ public:
     /** @brief Create and push and undo object based on the corresponding functions
         Note that if you class permits and requires it, you should use the macro PUSH_UNDO instead*/
     void pushUndo(const Fun &undo, const Fun &redo, const QString &text);
-    void pushUndo(QUndoCommand *command);
+    /** @brief Push an undo command, @param operation describes it in the undo journal used for crash recovery */
+    void pushUndo(QUndoCommand *command, const QJsonObject &operation = QJsonObject());
     /** @brief display a user info/warning message in statusbar */
     void displayMessage(const QString &message, MessageType type, int timeout = -1);
     /** @brief display timeline selection info in statusbar */
@@ -180,6 +182,8 @@ public:
     void clearAssetPanel(int itemId);
     /** @brief Returns the effectstack of a given bin clip. */
     std::shared_ptr<EffectStackModel> getItemEffectStack(int itemType, int itemId);
+    /** @brief Describe the owner of an asset for the undo journal, returns an empty object if it cannot be described */
+    QJsonObject journalAddress(const ObjectId &id);
     int getItemPosition(const ObjectId &id);
     int getItemIn(const ObjectId &id);
     int getItemTrack(const ObjectId &id);
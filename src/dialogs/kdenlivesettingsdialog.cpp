@@ -330,6 +330,7 @@ void KdenliveSettingsDialog::initEnviromentPage()
     connect(m_configEnv.kcfg_librarytodefaultfolder, &QAbstractButton::clicked, this, &KdenliveSettingsDialog::slotEnableLibraryFolder);
 
     m_configEnv.kcfg_proxythreads->setMaximum(qMax(1, QThread::idealThreadCount() - 1));
+    m_configEnv.kcfg_renderthreadbudget->setMaximum(QThread::idealThreadCount() * 4);
 
     // Script rendering folder
     m_configEnv.videofolderurl->setMode(KFile::Directory);
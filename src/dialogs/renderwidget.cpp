@@ -71,9 +71,20 @@ enum {
     ExtraInfoRole = ProgressRole + 2, // vpinon: don't understand why, else spurious message displayed
     LastTimeRole,
     LastFrameRole,
-    OpenBrowserRole
+    OpenBrowserRole,
+    ThreadCostRole,
+    MemoryCostRole,
+    SpeedRole
 };
 
+namespace {
+// Memory estimate of a render pipeline, in MB, without its frame buffers
+const int baseJobMemory = 150;
+const int audioJobMemory = 100;
+// Frames held by the consumer buffer and the encoder lookahead
+const int bufferedFrames = 50;
+} // namespace
+
 // Running job status
 enum JOBSTATUS { WAITINGJOB = 0, STARTINGJOB, RUNNINGJOB, FINISHEDJOB, FAILEDJOB, ABORTEDJOB };
 
@@ -226,6 +237,8 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
         // Disable parallel rendering for movit
         m_view.parallel_process->setEnabled(false);
     }
+    m_view.segmented_render->setChecked(KdenliveSettings::segmentedrender());
+    connect(m_view.segmented_render, &QCheckBox::toggled, this, &KdenliveSettings::setSegmentedrender);
     connect(m_view.export_meta, &QCheckBox::stateChanged, this, &RenderWidget::refreshParams);
     connect(m_view.checkTwoPass, &QCheckBox::stateChanged, this, &RenderWidget::refreshParams);
 
@@ -944,9 +957,11 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, int in, int out, QStrin
         return;
     }
     QList<RenderJobItem *> jobList;
+    // Only the main output of a single pass render can be split in segments
+    const int segments = passes == 1 && !renderArgs.contains(QLatin1String("=stills/")) ? renderSegments() : 0;
     QMap<QString, QString>::const_iterator i = renderFiles.constBegin();
     while (i != renderFiles.constEnd()) {
-        RenderJobItem *renderItem = createRenderJob(i.key(), i.value(), in, out);
+        RenderJobItem *renderItem = createRenderJob(i.key(), i.value(), in, out, i.value() == outputFile ? segments : 0);
         if (renderItem != nullptr) {
             jobList << renderItem;
         }
@@ -960,7 +975,16 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, int in, int out, QStrin
     checkRenderStatus();
 }
 
-RenderJobItem *RenderWidget::createRenderJob(const QString &playlist, const QString &outputFile, int in, int out)
+int RenderWidget::renderSegments() const
+{
+    if (!m_view.segmented_render->isChecked() || !m_view.video_box->isChecked() || KdenliveSettings::ffmpegpath().isEmpty()) {
+        return 0;
+    }
+    // Each segment runs its own MLT pipeline and encoder threads, so do not use a process per core
+    return qBound(2, QThread::idealThreadCount() / 2, 8);
+}
+
+RenderJobItem *RenderWidget::createRenderJob(const QString &playlist, const QString &outputFile, int in, int out, int segments)
 {
     QList<QTreeWidgetItem *> existing = m_view.running_jobs->findItems(outputFile, Qt::MatchExactly, 1);
     RenderJobItem *renderItem = nullptr;
@@ -987,7 +1011,11 @@ RenderJobItem *RenderWidget::createRenderJob(const QString &playlist, const QStr
     renderItem->setData(1, LastFrameRole, in);
     QStringList argsJob = {KdenliveSettings::rendererpath(), playlist, outputFile,
                            QStringLiteral("-pid:%1").arg(QCoreApplication::applicationPid()), QStringLiteral("-out"), QString::number(out)};
+    if (segments > 1) {
+        argsJob << QStringLiteral("-segments") << QString::number(segments) << KdenliveSettings::ffmpegpath();
+    }
     renderItem->setData(1, ParametersRole, argsJob);
+    setJobCost(renderItem, playlist, segments);
     qDebug() << "* CREATED JOB WITH ARGS: " << argsJob;
     renderItem->setData(1, OpenBrowserRole, m_view.open_browser->isChecked());
     if (!m_view.audio_box->isChecked()) {
@@ -1000,6 +1028,42 @@ RenderJobItem *RenderWidget::createRenderJob(const QString &playlist, const QStr
     return renderItem;
 }
 
+void RenderWidget::setJobCost(RenderJobItem *item, const QString &playlist, int segments)
+{
+    // Jobs with an unreadable playlist are assumed to use half of the machine
+    int threads = qMax(1, QThread::idealThreadCount() / 2);
+    int memory = baseJobMemory * 4;
+    QFile file(playlist);
+    QDomDocument doc;
+    if (file.open(QIODevice::ReadOnly) && doc.setContent(&file, false)) {
+        QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+        QDomElement profile = doc.documentElement().firstChildElement(QStringLiteral("profile"));
+        QSize frameSize(profile.attribute(QStringLiteral("width")).toInt(), profile.attribute(QStringLiteral("height")).toInt());
+        const QString size = consumer.attribute(QStringLiteral("s"));
+        if (size.contains(QLatin1Char('x'))) {
+            frameSize = QSize(size.section(QLatin1Char('x'), 0, 0).toInt(), size.section(QLatin1Char('x'), 1).toInt());
+        }
+        if (consumer.attribute(QStringLiteral("vn")).toInt() == 1 || consumer.attribute(QStringLiteral("video_off")).toInt() == 1) {
+            threads = 1;
+            memory = audioJobMemory;
+        } else {
+            const int pipelineThreads = qMax(1, qAbs(consumer.attribute(QStringLiteral("real_time")).toInt()));
+            int encoderThreads = consumer.attribute(QStringLiteral("threads")).toInt();
+            if (encoderThreads <= 0) {
+                // Automatic encoder threads, most encoders do not scale to all cores
+                encoderThreads = qMax(2, QThread::idealThreadCount() / 2);
+            }
+            const qint64 frameMemory = qint64(frameSize.width()) * frameSize.height() * 4 * bufferedFrames / (1024 * 1024);
+            // A segmented render runs one pipeline per segment, plus one for the audio
+            const int pipelines = qMax(1, segments);
+            threads = pipelines * (pipelineThreads + encoderThreads) + (segments > 1 ? 1 : 0);
+            memory = int(pipelines * (baseJobMemory + frameMemory)) + (segments > 1 ? audioJobMemory : 0);
+        }
+    }
+    item->setData(1, ThreadCostRole, threads);
+    item->setData(1, MemoryCostRole, memory);
+}
+
 void RenderWidget::checkRenderStatus()
 {
     // check if we have a job waiting to render
@@ -1007,22 +1071,37 @@ void RenderWidget::checkRenderStatus()
         return;
     }
 
-    // Make sure no other rendering is running
-    if (runningJobsCount() > 0) {
-        return;
-    }
-
+    const int threadBudget = KdenliveSettings::renderthreadbudget() > 0 ? KdenliveSettings::renderthreadbudget() : QThread::idealThreadCount();
+    const int memoryBudget = KdenliveSettings::rendermemorybudget();
+    int usedThreads = 0;
+    int usedMemory = 0;
+    int running = 0;
     auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+    while (item != nullptr) {
+        if (item->status() == RUNNINGJOB || item->status() == STARTINGJOB) {
+            usedThreads += item->data(1, ThreadCostRole).toInt();
+            usedMemory += item->data(1, MemoryCostRole).toInt();
+            running++;
+        }
+        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+    }
 
     bool waitingJob = false;
+    item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
 
-    // Find first waiting job
+    // Start the waiting jobs in queue order while they fit in the budget. A job that does not fit
+    // also holds back the jobs below it, so that large jobs are not delayed forever by smaller ones.
     while (item != nullptr) {
         if (item->status() == WAITINGJOB) {
+            waitingJob = true;
+            const int threads = item->data(1, ThreadCostRole).toInt();
+            const int memory = item->data(1, MemoryCostRole).toInt();
+            if (running > 0 && (usedThreads + threads > threadBudget || usedMemory + memory > memoryBudget)) {
+                break;
+            }
             QDateTime t = QDateTime::currentDateTime();
             item->setData(1, StartTimeRole, t);
             item->setData(1, LastTimeRole, t);
-            waitingJob = true;
             startRendering(item);
             // Check for 2 pass encoding
             QStringList jobData = item->data(1, ParametersRole).toStringList();
@@ -1040,16 +1119,49 @@ void RenderWidget::checkRenderStatus()
                     above = m_view.running_jobs->itemAbove(above);
                 }
             }
-            item->setStatus(STARTINGJOB);
-            break;
+            if (item->status() == WAITINGJOB) {
+                item->setStatus(STARTINGJOB);
+                usedThreads += threads;
+                usedMemory += memory;
+                running++;
+            }
         }
         item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
     }
-    if (!waitingJob && m_view.shutdown->isChecked()) {
+    updateQueueStatus();
+    if (!waitingJob && running == 0 && m_view.shutdown->isChecked()) {
         emit shutdown();
     }
 }
 
+void RenderWidget::updateQueueStatus()
+{
+    int running = 0;
+    int waiting = 0;
+    int speed = 0;
+    int threads = 0;
+    int memory = 0;
+    auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+    while (item != nullptr) {
+        if (item->status() == RUNNINGJOB || item->status() == STARTINGJOB) {
+            running++;
+            speed += item->data(1, SpeedRole).toInt();
+            threads += item->data(1, ThreadCostRole).toInt();
+            memory += item->data(1, MemoryCostRole).toInt();
+        } else if (item->status() == WAITINGJOB) {
+            waiting++;
+        }
+        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+    }
+    if (running == 0) {
+        m_view.queue_status->clear();
+        return;
+    }
+    const int threadBudget = KdenliveSettings::renderthreadbudget() > 0 ? KdenliveSettings::renderthreadbudget() : QThread::idealThreadCount();
+    m_view.queue_status->setText(i18n("%1 running, %2 waiting, %3 fps in total (estimated use: %4 of %5 threads, %6 of %7 MB)", running, waiting, speed,
+                                      threads, threadBudget, memory, KdenliveSettings::rendermemorybudget()));
+}
+
 void RenderWidget::startRendering(RenderJobItem *item)
 {
     auto rendererArgs = item->data(1, ParametersRole).toStringList();
@@ -1455,6 +1567,8 @@ void RenderWidget::setRenderProgress(const QString &dest, int progress, int fram
         item->setData(1, Qt::UserRole, est);
         item->setData(1, LastTimeRole, elapsedTime);
         item->setData(1, LastFrameRole, frame);
+        item->setData(1, SpeedRole, speed);
+        updateQueueStatus();
     }
 }
 
@@ -1689,6 +1803,7 @@ void RenderWidget::slotStartScript()
         renderItem->setData(1, LastTimeRole, t);
         QStringList argsJob = {KdenliveSettings::rendererpath(), path, destination, QStringLiteral("-pid:%1").arg(QCoreApplication::applicationPid()),QStringLiteral("-out"),QString::number(out)};
         renderItem->setData(1, ParametersRole, argsJob);
+        setJobCost(renderItem, path);
         checkRenderStatus();
         m_view.tabWidget->setCurrentIndex(Tabs::JobsTab);
     }
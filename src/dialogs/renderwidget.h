@@ -219,8 +219,12 @@ private:
 #endif
     void parseProfiles(const QString &selectedProfile = QString());
     QUrl filenameWithExtension(QUrl url, const QString &extension);
-    /** @brief Check if a job needs to be started. */
+    /** @brief Start the waiting jobs that fit in the thread and memory budget of the render queue. */
     void checkRenderStatus();
+    /** @brief Store the estimated thread count and memory used by a job, read from the consumer of its playlist. */
+    void setJobCost(RenderJobItem *item, const QString &playlist, int segments = 0);
+    /** @brief Display the running jobs, their resource usage and aggregate speed. */
+    void updateQueueStatus();
     void startRendering(RenderJobItem *item);
     /** @brief Create a rendering profile from MLT preset. */
     QTreeWidgetItem *loadFromMltPreset(const QString &groupName, const QString &path, QString profileName, bool codecInName = false);
@@ -228,7 +232,10 @@ private:
     /** @brief Create a new empty playlist (*.mlt) file and @returns the filename of the created file */
     QString generatePlaylistFile(bool delayedRendering);
     void generateRenderFiles(QDomDocument doc, int in, int out, QString outputFile, bool delayedRendering);
-    RenderJobItem *createRenderJob(const QString &playlist, const QString &outputFile, int in, int out);
+    /** @brief Create a render job. If @param segments is above 1, kdenlive_render encodes the video in that many parallel segments */
+    RenderJobItem *createRenderJob(const QString &playlist, const QString &outputFile, int in, int out, int segments = 0);
+    /** @brief Number of parallel segments for a segmented render, 0 if the current settings do not allow it */
+    int renderSegments() const;
 
 signals:
     void abortProcess(const QString &url);
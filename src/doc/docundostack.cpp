@@ -4,19 +4,54 @@
 */
 
 #include "docundostack.hpp"
+#include "undojournal.hpp"
 #include <QUndoCommand>
 #include <QUndoGroup>
 
 DocUndoStack::DocUndoStack(QUndoGroup *parent)
     : QUndoStack(parent)
 {
+    connect(this, &QUndoStack::indexChanged, this, [this]() {
+        if (!m_pushing && m_journal) {
+            // Undo and redo are not recorded
+            m_journal->invalidate();
+        }
+    });
 }
 
 // TODO: custom undostack everywhere do that
-void DocUndoStack::push(QUndoCommand *cmd)
+void DocUndoStack::push(QUndoCommand *cmd, const QJsonObject &operation)
 {
     if (index() < count()) {
         emit invalidate(index());
     }
+    m_pushing = true;
+    m_pushingJournaled = m_journal && !operation.isEmpty();
     QUndoStack::push(cmd);
+    m_pushing = false;
+    m_pushingJournaled = false;
+    if (m_journal) {
+        // Timeline edits are pushed under the timeline lock, so they are either in the backup being written or in the new journal.
+        // Parameter changes may be in both, replaying them sets the same value
+        if (operation.isEmpty()) {
+            m_journal->invalidate();
+        } else {
+            m_journal->append(operation);
+        }
+    }
+}
+
+void DocUndoStack::setJournal(std::shared_ptr<UndoJournal> journal)
+{
+    m_journal = std::move(journal);
+}
+
+std::shared_ptr<UndoJournal> DocUndoStack::journal() const
+{
+    return m_journal;
+}
+
+bool DocUndoStack::isPushingJournaled() const
+{
+    return m_pushingJournaled;
 }
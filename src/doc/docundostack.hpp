@@ -5,17 +5,34 @@
 #ifndef DOCUNDOSTACK_H
 #define DOCUNDOSTACK_H
 
+#include <QJsonObject>
 #include <QUndoCommand>
+#include <memory>
 
 class QUndoGroup;
 class QUndoCommand;
+class UndoJournal;
 
 class DocUndoStack : public QUndoStack
 {
     Q_OBJECT
 public:
     explicit DocUndoStack(QUndoGroup *parent = Q_NULLPTR);
-    void push(QUndoCommand *cmd);
+    /** @brief Push a command on the stack
+       @param operation describes the command in the undo journal, the journal is invalidated if it is empty
+     */
+    void push(QUndoCommand *cmd, const QJsonObject &operation = QJsonObject());
+    /** @brief Set the journal recording the pushed commands for crash recovery */
+    void setJournal(std::shared_ptr<UndoJournal> journal);
+    std::shared_ptr<UndoJournal> journal() const;
+    /** @brief Returns true while a command recorded in the journal is being pushed */
+    bool isPushingJournaled() const;
+
+private:
+    std::shared_ptr<UndoJournal> m_journal;
+    bool m_pushing{false};
+    bool m_pushingJournaled{false};
+
 signals:
     void invalidate(int ix);
 };
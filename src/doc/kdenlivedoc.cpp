@@ -27,6 +27,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "project/projectcommands.h"
 #include "titler/titlewidget.h"
 #include "transitions/transitionsrepository.hpp"
+#include "undojournal.hpp"
 
 #include <config-kdenlive.h>
 
@@ -287,6 +288,9 @@ KdenliveDoc::~KdenliveDoc()
         }
         delete m_autosave;
     }
+    if (auto journal = m_commandStack->journal()) {
+        journal->remove();
+    }
 }
 
 int KdenliveDoc::clipsCount() const
@@ -425,26 +429,36 @@ bool KdenliveDoc::autoGenerateImageProxy(int width) const
            width > m_documentProperties.value(QStringLiteral("proxyimageminsize")).toInt();
 }
 
-void KdenliveDoc::slotAutoSave(const QString &scene)
+bool KdenliveDoc::slotAutoSave(const QString &scene)
 {
+    // The backup may be written from a worker thread, messages are displayed by the GUI thread
     if (m_autosave != nullptr) {
+        const QString fileName = m_autosave->fileName();
         if (!m_autosave->isOpen() && !m_autosave->open(QIODevice::ReadWrite)) {
             // show error: could not open the autosave file
             qCDebug(KDENLIVE_LOG) << "ERROR; CANNOT CREATE AUTOSAVE FILE";
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
-            return;
+            QMetaObject::invokeMethod(pCore.get(), [fileName] {
+                pCore->displayMessage(i18n("Cannot create autosave file %1", fileName), ErrorMessage);
+            }, Qt::QueuedConnection);
+            return false;
         }
         if (scene.isEmpty()) {
             // Make sure we don't save if scenelist is corrupted
-            KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", m_autosave->fileName()));
-            return;
+            QMetaObject::invokeMethod(qApp, [fileName] {
+                KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", fileName));
+            }, Qt::QueuedConnection);
+            return false;
         }
         m_autosave->resize(0);
         if (m_autosave->write(scene.toUtf8()) < 0) {
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
+            QMetaObject::invokeMethod(pCore.get(), [fileName] {
+                pCore->displayMessage(i18n("Cannot create autosave file %1", fileName), ErrorMessage);
+            }, Qt::QueuedConnection);
+            return false;
         };
-        m_autosave->flush();
+        return m_autosave->flush();
     }
+    return false;
 }
 
 void KdenliveDoc::setZoom(int horizontal, int vertical)
@@ -717,6 +731,24 @@ std::shared_ptr<DocUndoStack> KdenliveDoc::commandStack()
     return m_commandStack;
 }
 
+std::shared_ptr<UndoJournal> KdenliveDoc::autoSaveJournal()
+{
+    // The journal is named after the autosave file, which is only known once it is opened
+    if (m_autosave == nullptr || (!m_autosave->isOpen() && !m_autosave->open(QIODevice::ReadWrite))) {
+        return nullptr;
+    }
+    const QString path = UndoJournal::journalPath(m_autosave->fileName());
+    std::shared_ptr<UndoJournal> journal = m_commandStack->journal();
+    if (journal == nullptr || journal->path() != path) {
+        if (journal) {
+            journal->remove();
+        }
+        journal = std::make_shared<UndoJournal>(path);
+        m_commandStack->setJournal(journal);
+    }
+    return journal;
+}
+
 int KdenliveDoc::getFramePos(const QString &duration)
 {
     return m_timecode.getFrameCount(duration);
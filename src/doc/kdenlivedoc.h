@@ -38,6 +38,7 @@ class SubtitleModel;
 class QUndoGroup;
 class QUndoCommand;
 class DocUndoStack;
+class UndoJournal;
 
 namespace Mlt {
 class Profile;
@@ -63,6 +64,9 @@ public:
     bool m_sameProjectFolder;
     Timecode timecode() const;
     std::shared_ptr<DocUndoStack> commandStack();
+    /** @brief Returns the journal of the edits made since the last autosave, attached to the command stack.
+        It is created with the autosave file, returns nullptr if the autosave file cannot be opened */
+    std::shared_ptr<UndoJournal> autoSaveJournal();
 
     int getFramePos(const QString &duration);
     /** @brief Get a list of all clip ids that are inside a folder. */
@@ -238,8 +242,10 @@ public slots:
                               QUndoCommand *masterCommand = nullptr);
     /** @brief Saves the current project at the autosave location.
      * 
-     * The autosave files are in ~/.kde/data/stalefiles/kdenlive/ */
-    void slotAutoSave(const QString &scene);
+     * The autosave files are in ~/.kde/data/stalefiles/kdenlive/
+     * This can be called from a worker thread, errors are reported from the GUI thread.
+     * @returns true if the backup was written */
+    bool slotAutoSave(const QString &scene);
     /** @brief Groups were changed, save to MLT. */
     void groupsChanged(const QString &groups);
     void switchProfile(ProfileParam* pf, const QString clipName);
@@ -0,0 +1,162 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "undojournal.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QStandardPaths>
+
+namespace {
+const QString previousSuffix = QStringLiteral(".previous");
+const QString invalidOperation = QStringLiteral("invalid");
+} // namespace
+
+UndoJournal::UndoJournal(const QString &path)
+    : m_path(path)
+    , m_file(path)
+{
+}
+
+// static
+QString UndoJournal::journalPath(const QString &autoSaveFile)
+{
+    // Not in the autosave folder, where every file is considered as a project backup
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/journal/") + QFileInfo(autoSaveFile).fileName() +
+           QStringLiteral(".journal");
+}
+
+const QString &UndoJournal::path() const
+{
+    return m_path;
+}
+
+void UndoJournal::append(const QJsonObject &operation)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_invalidated) {
+        // Cannot be replayed anyway
+        return;
+    }
+    if (write(operation)) {
+        m_size++;
+    } else {
+        writeInvalidMarker();
+    }
+}
+
+void UndoJournal::invalidate()
+{
+    QMutexLocker lock(&m_mutex);
+    writeInvalidMarker();
+}
+
+bool UndoJournal::isComplete() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_complete;
+}
+
+int UndoJournal::size() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_size;
+}
+
+void UndoJournal::startSnapshot()
+{
+    QMutexLocker lock(&m_mutex);
+    m_file.close();
+    const QString previousPath = m_path + previousSuffix;
+    if (QFile::exists(m_path)) {
+        if (QFile::exists(previousPath)) {
+            // The last backup was not written, keep all the edits made since the one before
+            QFile previous(previousPath);
+            if (m_file.open(QIODevice::ReadOnly) && previous.open(QIODevice::WriteOnly | QIODevice::Append)) {
+                previous.write(m_file.readAll());
+            }
+            m_file.close();
+            QFile::remove(m_path);
+        } else {
+            QFile::rename(m_path, previousPath);
+        }
+    }
+    m_size = 0;
+    m_complete = true;
+    m_invalidated = false;
+}
+
+void UndoJournal::finishSnapshot(bool written)
+{
+    QMutexLocker lock(&m_mutex);
+    if (written) {
+        QFile::remove(m_path + previousSuffix);
+    } else {
+        m_complete = false;
+    }
+}
+
+void UndoJournal::remove()
+{
+    QMutexLocker lock(&m_mutex);
+    m_file.close();
+    QFile::remove(m_path);
+    QFile::remove(m_path + previousSuffix);
+    m_size = 0;
+    m_complete = false;
+    m_invalidated = false;
+}
+
+void UndoJournal::writeInvalidMarker()
+{
+    m_complete = false;
+    if (!m_invalidated) {
+        // Recovery stops at this marker
+        m_invalidated = true;
+        write(QJsonObject{{QStringLiteral("op"), invalidOperation}});
+    }
+}
+
+bool UndoJournal::write(const QJsonObject &operation)
+{
+    if (!m_file.isOpen()) {
+        QDir().mkpath(QFileInfo(m_path).absolutePath());
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qDebug() << "// Cannot open undo journal" << m_path;
+            return false;
+        }
+    }
+    // Flushing hands the line to the system, it is kept if the application crashes
+    return m_file.write(QJsonDocument(operation).toJson(QJsonDocument::Compact) + '\n') > 0 && m_file.flush();
+}
+
+// static
+QVector<QJsonObject> UndoJournal::read(const QString &path)
+{
+    QVector<QJsonObject> operations;
+    for (const QString &fileName : {path + previousSuffix, path}) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        while (!file.atEnd()) {
+            const QByteArray line = file.readLine().trimmed();
+            if (line.isEmpty()) {
+                continue;
+            }
+            QJsonParseError error;
+            const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+            // A line may be truncated by a crash
+            if (error.error != QJsonParseError::NoError || !doc.isObject() ||
+                doc.object().value(QStringLiteral("op")).toString() == invalidOperation) {
+                return operations;
+            }
+            operations.append(doc.object());
+        }
+    }
+    return operations;
+}
@@ -0,0 +1,62 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QFile>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/** @class UndoJournal
+    @brief Append-only log of the edits made since the last backup of the project.
+    Each command pushed on the undo stack that can be described (clip moves, resizes, effect parameter changes) is appended
+    as a line of JSON and flushed immediately, so that crash recovery can replay it on top of the backup. Commands that
+    cannot be described, undo and redo mark the journal as incomplete: a full backup is then needed.
+    When a backup starts, the journal is moved to a ".previous" file which is removed once the backup is written, so that a
+    crash while writing the backup keeps all the edits.
+    All methods are thread safe.
+ */
+class UndoJournal
+{
+public:
+    explicit UndoJournal(const QString &path);
+
+    /** @brief Returns the path of the journal belonging to an autosave file */
+    static QString journalPath(const QString &autoSaveFile);
+    const QString &path() const;
+
+    /** @brief Record an edit, flushing it to the file */
+    void append(const QJsonObject &operation);
+    /** @brief Mark the journal as incomplete, the edits made after that cannot be replayed */
+    void invalidate();
+    /** @brief Returns true if all the edits since the last backup are recorded */
+    bool isComplete() const;
+    /** @brief Number of edits recorded since the last backup */
+    int size() const;
+
+    /** @brief Start a new journal, must be called when the state saved by the backup is captured */
+    void startSnapshot();
+    /** @brief Drop the previous journal if the backup was written, otherwise keep it for recovery */
+    void finishSnapshot(bool written);
+    /** @brief Delete the journal files */
+    void remove();
+
+    /** @brief Returns the edits that can be replayed on the last backup, in order */
+    static QVector<QJsonObject> read(const QString &path);
+
+private:
+    bool write(const QJsonObject &operation);
+    void writeInvalidMarker();
+
+    mutable QMutex m_mutex;
+    QString m_path;
+    QFile m_file;
+    int m_size{0};
+    bool m_complete{false};
+    // The current journal ends with an invalid marker
+    bool m_invalidated{false};
+};
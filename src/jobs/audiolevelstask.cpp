@@ -6,6 +6,7 @@
 */
 
 #include "audiolevelstask.h"
+#include "audio/audioLevels.h"
 #include "audio/audioStreamInfo.h"
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
@@ -19,19 +20,50 @@
 #include <QMutex>
 #include <QRgb>
 #include <QString>
+#include <QThread>
 #include <QThreadPool>
 #include <QTime>
 #include <QVariantList>
+#include <QtConcurrent>
 #include <klocalizedstring.h>
+#include <vector>
 
 static QList<AudioLevelsTask*> tasksList;
 static QMutex tasksListMutex;
 
+// Clips shorter than 2 segments are decoded in one pass
+static const int minSegmentFrames = 3000;
+
 static void deleteQVariantList(QVector <uint8_t>* list)
 {
     delete list;
 }
 
+static void deleteAudioLevels(AudioLevels *levels)
+{
+    delete levels;
+}
+
+/** @brief Read the levels from the PNG cache format used by older versions, where levels were packed in ARGB pixels */
+static QVector <uint8_t> loadLegacyLevels(const QString &path, int channels)
+{
+    QVector <uint8_t> levels;
+    QImage image(path);
+    if (image.isNull()) {
+        return levels;
+    }
+    int n = image.width() * image.height();
+    levels.reserve(4 * n);
+    for (int i = 0; n > 1 && i < n; i++) {
+        QRgb p = image.pixel(i / channels, i % channels);
+        levels << qRed(p);
+        levels << qGreen(p);
+        levels << qBlue(p);
+        levels << qAlpha(p);
+    }
+    return levels;
+}
+
 AudioLevelsTask::AudioLevelsTask(const ObjectId &owner, QObject* object)
     : AbstractTask(owner, AbstractTask::AUDIOTHUMBJOB, object)
 {
@@ -53,6 +85,69 @@ void AudioLevelsTask::start(const ObjectId &owner, QObject* object, bool force)
     }
 }
 
+std::unique_ptr<Mlt::Producer> AudioLevelsTask::createAudioProducer(Mlt::Profile &profile, const QString &service, const QByteArray &resource, int stream)
+{
+    std::unique_ptr<Mlt::Producer> audioProducer(new Mlt::Producer(profile, service.toUtf8().constData(), resource.constData()));
+    if (!audioProducer->is_valid()) {
+        return nullptr;
+    }
+    audioProducer->set("video_index", "-1");
+    audioProducer->set("audio_index", stream);
+    Mlt::Filter chans(profile, "audiochannels");
+    Mlt::Filter converter(profile, "audioconvert");
+    Mlt::Filter levels(profile, "audiolevel");
+    audioProducer->attach(chans);
+    audioProducer->attach(converter);
+    audioProducer->attach(levels);
+    return audioProducer;
+}
+
+uint AudioLevelsTask::decodeSegment(Mlt::Producer *audioProducer, int frequency, int channels, int start, int end, uint8_t *levels, QAtomicInt *done)
+{
+    double framesPerSecond = audioProducer->get_fps();
+    mlt_audio_format audioFormat = mlt_audio_s16;
+    std::vector<QByteArray> keys;
+    keys.reserve(size_t(channels));
+    for (int i = 0; i < channels; i++) {
+        keys.push_back(QStringLiteral("meta.media.audio_level.%1").arg(i).toUtf8());
+    }
+    uint maxLevel = 1;
+    if (start > 0) {
+        audioProducer->seek(start);
+    }
+    for (int z = start; z < end && !m_isCanceled; ++z) {
+        uint8_t *frameLevels = levels + qint64(z) * channels;
+        QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
+        if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
+            int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
+            mltFrame->get_audio(audioFormat, frequency, channels, samples);
+            for (int channel = 0; channel < channels; ++channel) {
+                uint lev = qMin(uint(256 * qMin(mltFrame->get_double(keys.at(size_t(channel)).constData()) * 0.9, 1.0)), 255u);
+                frameLevels[channel] = uint8_t(lev);
+                maxLevel = qMax(lev, maxLevel);
+            }
+        } else if (z > start) {
+            memcpy(frameLevels, frameLevels - channels, size_t(channels));
+        }
+        done->storeRelease(z - start + 1);
+    }
+    return maxLevel;
+}
+
+void AudioLevelsTask::publishLevels(const std::shared_ptr<Mlt::Producer> &producer, int stream, const QVector<uint8_t> &levels, int validSize)
+{
+    const QByteArray key = QString("_kdenlive:audio%1").arg(stream).toUtf8();
+    const QByteArray validKey = QString("_kdenlive:audiovalid%1").arg(stream).toUtf8();
+    producer->lock();
+    auto *published = static_cast<QVector<uint8_t> *>(producer->get_data(key.constData()));
+    if (published == nullptr || published->constData() != levels.constData()) {
+        // Share the buffer without copying it, the published vector is never modified
+        producer->set(key.constData(), new QVector<uint8_t>(levels), 0, (mlt_destructor) deleteQVariantList);
+    }
+    producer->set(validKey.constData(), validSize);
+    producer->unlock();
+}
+
 void AudioLevelsTask::run()
 {
     m_running = true;
@@ -106,28 +201,26 @@ void AudioLevelsTask::run()
         // Generate one thumb per stream
         QString cachePath = binClip->getAudioThumbPath(stream);
         QVector <uint8_t> mltLevels;
-        if (!m_isForce && QFile::exists(cachePath)) {
-            // Audio thumb already exists
-            QImage image(cachePath);
-            if (!m_isCanceled && !image.isNull()) {
-                // convert cached image
-                int n = image.width() * image.height();
-                for (int i = 0; n > 1 && i < n; i++) {
-                    QRgb p = image.pixel(i / channels, i % channels);
-                    mltLevels << qRed(p);
-                    mltLevels << qGreen(p);
-                    mltLevels << qBlue(p);
-                    mltLevels << qAlpha(p);
-                }
-                if (mltLevels.size() > 0) {
-                    QVector <uint8_t>* levelsCopy = new QVector <uint8_t>(mltLevels);
-                    producer->lock();
-                    QString key = QString("_kdenlive:audio%1").arg(stream);
-                    producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor) deleteQVariantList);
-                    producer->unlock();
-                    continue;
+        if (!m_isForce && !cachePath.isEmpty()) {
+            AudioLevels cached = AudioLevels::load(cachePath, channels);
+            if (cached.isEmpty() && !m_isCanceled) {
+                // Convert an audio thumb from the previous PNG format
+                const QString legacyPath = binClip->getAudioThumbPath(stream, true);
+                if (QFile::exists(legacyPath)) {
+                    cached = AudioLevels(loadLegacyLevels(legacyPath, channels), channels);
+                    if (cached.save(cachePath)) {
+                        QFile::remove(legacyPath);
+                    }
                 }
             }
+            if (!m_isCanceled && !cached.isEmpty()) {
+                publishLevels(producer, stream, cached.rawLevels(), cached.rawLevels().size());
+                QString lodKey = QString("_kdenlive:audiolod%1").arg(stream);
+                producer->lock();
+                producer->set(lodKey.toUtf8().constData(), new AudioLevels(cached), 0, (mlt_destructor) deleteAudioLevels);
+                producer->unlock();
+                continue;
+            }
         }
         QString service = producer->get("mlt_service");
         if (service == QLatin1String("avformat-novalidate")) {
@@ -135,66 +228,96 @@ void AudioLevelsTask::run()
         } else if (service.startsWith(QLatin1String("xml"))) {
             service = QStringLiteral("xml-nogl");
         }
-        QScopedPointer<Mlt::Producer> audioProducer(new Mlt::Producer(*producer->profile(), service.toUtf8().constData(), producer->get("resource")));
-        if (!audioProducer->is_valid()) {
+        const QByteArray resource(producer->get("resource"));
+        // Long clips are split in segments decoded in parallel, each one by its own producer
+        int segmentCount = qBound(1, lengthInFrames / minSegmentFrames, qBound(1, QThread::idealThreadCount() / 2, 8));
+        std::vector<std::unique_ptr<Mlt::Producer>> audioProducers;
+        for (int i = 0; i < segmentCount; ++i) {
+            std::unique_ptr<Mlt::Producer> audioProducer = createAudioProducer(*producer->profile(), service, resource, stream);
+            if (!audioProducer) {
+                break;
+            }
+            audioProducers.push_back(std::move(audioProducer));
+        }
+        if (audioProducers.empty()) {
             QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection, Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", producer->get("resource"))),
                                   Q_ARG(int, int(KMessageWidget::Warning)));
             pCore->taskManager.taskDone(m_owner.second, this);
             return;
         }
-        audioProducer->set("video_index", "-1");
-        audioProducer->set("audio_index", stream);
-        Mlt::Filter chans(*producer->profile(), "audiochannels");
-        Mlt::Filter converter(*producer->profile(), "audioconvert");
-        Mlt::Filter levels(*producer->profile(), "audiolevel");
-        audioProducer->attach(chans);
-        audioProducer->attach(converter);
-        audioProducer->attach(levels);
-
-        double framesPerSecond = audioProducer->get_fps();
-        mlt_audio_format audioFormat = mlt_audio_s16;
-        QStringList keys;
-        keys.reserve(channels);
-        for (int i = 0; i < channels; i++) {
-            keys << "meta.media.audio_level." + QString::number(i);
+        segmentCount = int(audioProducers.size());
+        QVector<int> bounds;
+        for (int i = 0; i <= segmentCount; ++i) {
+            bounds << int(qint64(lengthInFrames) * i / segmentCount);
         }
-        uint maxLevel = 1;
+        mltLevels.fill(0, lengthInFrames * channels);
+        uint8_t *levelsData = mltLevels.data();
+        std::vector<QAtomicInt> decodedFrames(size_t(segmentCount));
+        QList<QFuture<uint>> segments;
+        for (int i = 0; i < segmentCount; ++i) {
+            // Segments run on the global pool: the task itself occupies a slot of the task manager pool
+            // and waits for them, using that pool could deadlock
+            Mlt::Producer *segmentProducer = audioProducers.at(size_t(i)).get();
+            QAtomicInt *done = &decodedFrames[size_t(i)];
+            int start = bounds.at(i);
+            int end = bounds.at(i + 1);
+            segments << QtConcurrent::run(QThreadPool::globalInstance(), [this, segmentProducer, frequency, channels, start, end, levelsData, done]() {
+                return decodeSegment(segmentProducer, frequency, channels, start, end, levelsData, done);
+            });
+        }
+        const QString lodKey = QString("_kdenlive:audiolod%1").arg(stream);
+        // Drop outdated decimations, they are rebuilt once all levels are known
+        producer->lock();
+        producer->set(lodKey.toUtf8().constData(), nullptr, 0);
+        producer->unlock();
+        int publishedFrames = 0;
         QElapsedTimer updateTime;
         updateTime.start();
-        for (int z = 0; z < lengthInFrames && !m_isCanceled; ++z) {
-            int val = int(100.0 * z / lengthInFrames);
-            if (m_progress != val) {
+        bool running = true;
+        while (running) {
+            running = false;
+            for (const QFuture<uint> &segment : qAsConst(segments)) {
+                if (!segment.isFinished()) {
+                    running = true;
+                    break;
+                }
+            }
+            // Count decoded frames, and find the end of the contiguous decoded part
+            int decoded = 0;
+            int contiguous = -1;
+            for (int i = 0; i < segmentCount; ++i) {
+                int done = decodedFrames[size_t(i)].loadAcquire();
+                decoded += done;
+                if (contiguous == -1 && bounds.at(i) + done < bounds.at(i + 1)) {
+                    contiguous = bounds.at(i) + done;
+                }
+            }
+            if (contiguous == -1) {
+                contiguous = lengthInFrames;
+            }
+            int val = int(100.0 * decoded / lengthInFrames);
+            if (m_progress != val && val < 100) {
                 m_progress = val;
                 QMetaObject::invokeMethod(m_object, "updateJobProgress");
             }
-            QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
-            if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
-                int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
-                mltFrame->get_audio(audioFormat, frequency, channels, samples);
-                for (int channel = 0; channel < channels; ++channel) {
-                    uint lev = 256 * qMin(mltFrame->get_double(keys.at(channel).toUtf8().constData()) * 0.9, 1.0);
-                    mltLevels << lev;
-                    //double lev = mltFrame->get_double(keys.at(channel).toUtf8().constData());
-                    //mltLevels << lev;
-                    maxLevel = qMax(lev, maxLevel);
-                }
-            } else if (!mltLevels.isEmpty()) {
-                for (int channel = 0; channel < channels; channel++) {
-                    mltLevels << mltLevels.last();
-                }
+            if (!running) {
+                break;
             }
             // Incrementally update the audio levels every 3 seconds.
-            if (updateTime.elapsed() > 3000 && !m_isCanceled) {
+            if (updateTime.elapsed() > 3000 && !m_isCanceled && contiguous > publishedFrames) {
                 updateTime.restart();
-                QVector <uint8_t>* levelsCopy = new  QVector <uint8_t>(mltLevels);
-                producer->lock();
-                QString key = QString("_kdenlive:audio%1").arg(stream);
-                producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor) deleteQVariantList);
-                producer->unlock();
+                publishLevels(producer, stream, mltLevels, contiguous * channels);
+                publishedFrames = contiguous;
                 QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
             }
+            QThread::msleep(100);
+        }
+        uint maxLevel = 1;
+        for (const QFuture<uint> &segment : qAsConst(segments)) {
+            maxLevel = qMax(maxLevel, segment.result());
         }
-        
+        audioProducers.clear();
+
         /*// Normalize
         for (double &v : mltLevels) {
             m_audioLevels << uchar(255 * v / maxLevel);
@@ -205,35 +328,20 @@ void AudioLevelsTask::run()
             QMetaObject::invokeMethod(m_object, "updateJobProgress");
         }
         if (mltLevels.size() > 0) {
-            QVector <uint8_t>* levelsCopy = new  QVector <uint8_t>(mltLevels);
+            const AudioLevels pyramid(mltLevels, channels);
+            publishLevels(producer, stream, mltLevels, mltLevels.size());
             producer->lock();
-            QString key = QString("_kdenlive:audio%1").arg(stream);
             QString key2 = QString("kdenlive:audio_max%1").arg(stream);
             producer->set(key2.toUtf8().constData(), int(maxLevel));
-            producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor) deleteQVariantList);
+            producer->set(lodKey.toUtf8().constData(), new AudioLevels(pyramid), 0, (mlt_destructor) deleteAudioLevels);
             producer->unlock();
-            //qDebug()<<"=== FINISHED PRODUCING AUDIO FOR: "<<key<<", SIZE: "<<levelsCopy->size();
+            //qDebug()<<"=== FINISHED PRODUCING AUDIO FOR STREAM: "<<stream<<", SIZE: "<<mltLevels.size();
             m_progress = 100;
             QMetaObject::invokeMethod(m_object, "updateJobProgress");
-            // Put into an image for caching.
-            int count = mltLevels.size();
-            QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
-            int n = image.width() * image.height();
-            for (int i = 0; i < n; i ++) {
-                QRgb p;
-                if ((4*i + 3) < count) {
-                    p = qRgba(mltLevels.at(4*i), mltLevels.at(4*i+1), mltLevels.at(4*i+2), mltLevels.at(4*i+3));
-                } else {
-                    int last = mltLevels.last();
-                    int r = (4*i+0) < count? mltLevels.at(4*i+0) : last;
-                    int g = (4*i+1) < count? mltLevels.at(4*i+1) : last;
-                    int b = (4*i+2) < count? mltLevels.at(4*i+2) : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / channels, i % channels, p);
+            // Store the levels and their decimations in the persistent cache
+            if (!cachePath.isEmpty()) {
+                pyramid.save(cachePath);
             }
-            image.save(cachePath);
             audioCreated = true;
             QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
         }
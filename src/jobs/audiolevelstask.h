@@ -13,6 +13,10 @@
 
 #include <QRunnable>
 #include <QObject>
+#include <QVector>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+#include <memory>
 
 class AudioLevelsTask : public AbstractTask
 {
@@ -23,6 +27,15 @@ public:
 protected:
     void run() override;
 
+private:
+    /** @brief Create a producer decoding only the audio stream, with the filters computing the levels */
+    static std::unique_ptr<Mlt::Producer> createAudioProducer(Mlt::Profile &profile, const QString &service, const QByteArray &resource, int stream);
+    /** @brief Decode the levels of frames [start, end[ into the preallocated buffer, returns the max level.
+     *  @param done is updated with the number of processed frames, so that the calling thread can publish the decoded data */
+    uint decodeSegment(Mlt::Producer *audioProducer, int frequency, int channels, int start, int end, uint8_t *levels, QAtomicInt *done);
+    /** @brief Share the levels of a stream with the clip's producer, only the first validSize values are readable.
+     *  The decoding threads may still write after validSize: readers take the producer lock and only read the valid part */
+    static void publishLevels(const std::shared_ptr<Mlt::Producer> &producer, int stream, const QVector<uint8_t> &levels, int validSize);
 };
 
 #endif // AUDIOLEVELSTASK_H
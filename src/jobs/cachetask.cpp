@@ -74,7 +74,8 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip>binClip)
             if (m_isCanceled) {
                 break;
             }
-            if (ThumbnailCache::get()->hasThumbnail(clipId, i)) {
+            if (!ThumbnailCache::get()->getThumbnail(clipId, i).isNull()) {
+                // Already cached. A thumbnail read from the disk is now also in memory, where the bin looks for it
                 continue;
             }
             if (thumbProd == nullptr) {
@@ -338,6 +338,11 @@ void ClipLoadTask::run()
         type = ClipType::AV;
         service.clear();
     }
+    // The file identifying the clip, a proxied clip is identified by its original file
+    QString hashPath = Xml::getXmlProperty(m_xml, QStringLiteral("kdenlive:originalurl"));
+    if (hashPath.isEmpty()) {
+        hashPath = resource;
+    }
     std::shared_ptr<Mlt::Producer> producer;
     switch (type) {
     case ClipType::Color:
@@ -702,6 +707,14 @@ void ClipLoadTask::run()
             vindex = -1;
         }
     }
+    if (!m_isCanceled && QFileInfo(hashPath).isAbsolute()) {
+        // Hash the clip file here, so that the clips are hashed in parallel and setProducer finds the hash in the cache
+        if (type == ClipType::SlideShow) {
+            ProjectClip::getFolderHash(QFileInfo(hashPath).absoluteDir(), QFileInfo(hashPath).fileName());
+        } else if (type != ClipType::Color && type != ClipType::Text && type != ClipType::TextTemplate && type != ClipType::QText) {
+            ProjectClip::calculateHash(hashPath);
+        }
+    }
     if (!m_isCanceled) {
         auto binClip = pCore->projectItemModel()->getClipByBinID(QString::number(m_owner.second));
         if (binClip) {
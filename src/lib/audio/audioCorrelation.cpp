@@ -8,7 +8,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "kdenlive_debug.h"
 #include "klocalizedstring.h"
-#include <QElapsedTimer>
+#include <QtConcurrent>
 #include <cmath>
 #include <iostream>
 
@@ -22,6 +22,12 @@ AudioCorrelation::AudioCorrelation(std::unique_ptr<AudioEnvelope> mainTrackEnvel
 
 AudioCorrelation::~AudioCorrelation()
 {
+    for (const auto &pending : qAsConst(m_pending)) {
+        pending.second->disconnect(this);
+        pending.second->waitForFinished();
+        delete pending.second->result();
+        delete pending.first;
+    }
     for (AudioEnvelope *envelope : qAsConst(m_children)) {
         delete envelope;
     }
@@ -47,35 +53,42 @@ void AudioCorrelation::addChild(AudioEnvelope *envelope)
     envelope->startComputeEnvelope();
 }
 
-void AudioCorrelation::slotProcessChild(AudioEnvelope *envelope)
+const BatchCorrelation &AudioCorrelation::batch()
 {
-    // Note that at this point the computation of the envelope of the
-    // main track might not be finished. envelope() will block until
-    // the computation is done.
-    const size_t sizeMain = m_mainTrackEnvelope->envelope().size();
-    const size_t sizeSub = envelope->envelope().size();
-
-    auto *info = new AudioCorrelationInfo(sizeMain, sizeSub);
-    qint64 *correlation = info->correlationVector();
-
-    const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
-    const std::vector<qint64> &envSub = envelope->envelope();
-    qint64 max = 0;
-
-    if (sizeSub > 200) {
-        FFTCorrelation::correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation);
-    } else {
-        correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation, &max);
-        info->setMax(max);
+    QMutexLocker lock(&m_batchMutex);
+    if (!m_batch) {
+        m_batch.reset(new BatchCorrelation(m_mainTrackEnvelope->envelope()));
     }
+    return *m_batch;
+}
 
-    m_children.append(envelope);
-    m_correlations.append(info);
-
-    Q_ASSERT(m_correlations.size() == m_children.size());
-    int index = m_children.indexOf(envelope);
-    int shift = getShift(index);
-    emit gotAudioAlignData(envelope->clipId(), shift);
+void AudioCorrelation::slotProcessChild(AudioEnvelope *envelope)
+{
+    auto *watcher = new QFutureWatcher<AudioCorrelationInfo *>(this);
+    m_pending.append({envelope, watcher});
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, envelope, watcher]() {
+        for (int i = 0; i < m_pending.count(); ++i) {
+            if (m_pending.at(i).second == watcher) {
+                m_pending.removeAt(i);
+                break;
+            }
+        }
+        m_children.append(envelope);
+        m_correlations.append(watcher->result());
+        watcher->deleteLater();
+
+        Q_ASSERT(m_correlations.size() == m_children.size());
+        emit gotAudioAlignData(envelope->clipId(), getShift(m_children.count() - 1));
+    });
+    watcher->setFuture(QtConcurrent::run([this, envelope]() {
+        // Note that at this point the computation of the envelope of the
+        // main track might not be finished. batch() will block until
+        // the computation is done.
+        const BatchCorrelation &correlation = batch();
+        auto *info = new AudioCorrelationInfo(correlation.referenceSize(), envelope->envelope().size());
+        correlation.correlate(envelope->envelope(), info);
+        return info;
+    }));
 }
 
 int AudioCorrelation::getShift(int childIndex) const
@@ -97,61 +110,3 @@ AudioCorrelationInfo const *AudioCorrelation::info(int childIndex) const
 
     return m_correlations.at(childIndex);
 }
-
-void AudioCorrelation::correlate(const qint64 *envMain, size_t sizeMain, const qint64 *envSub, size_t sizeSub, qint64 *correlation, qint64 *out_max)
-{
-    Q_ASSERT(correlation != nullptr);
-
-    qint64 const *left;
-    qint64 const *right;
-    size_t size;
-    qint64 sum;
-    qint64 max = 0;
-
-    /*
-      Correlation:
-
-      SHIFT \in [-sS..sM]
-
-      <--sS----
-      [  sub  ]----sM--->[ sub ]
-               [  main  ]
-
-            ^ correlation vector index = SHIFT + sS
-
-      main is fixed, sub is shifted along main.
-
-    */
-
-    QElapsedTimer t;
-    t.start();
-    for (size_t shift = -sizeSub; shift <= sizeMain; ++shift) {
-
-        if (shift == 0) {
-            left = envSub - shift;
-            right = envMain;
-            size = std::min(sizeSub + shift, sizeMain);
-        } else {
-            left = envSub;
-            right = envMain + shift;
-            size = std::min(sizeSub, sizeMain - shift);
-        }
-
-        sum = 0;
-        for (size_t i = 0; i < size; ++i) {
-            sum += (*left) * (*right);
-            left++;
-            right++;
-        }
-        correlation[sizeSub + shift] = qAbs(sum);
-
-        if (sum > max) {
-            max = sum;
-        }
-    }
-    qCDebug(KDENLIVE_LOG) << "Correlation calculated. Time taken: " << t.elapsed() << " ms.";
-
-    if (out_max != nullptr) {
-        *out_max = max;
-    }
-}
@@ -10,15 +10,20 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "audioCorrelationInfo.h"
 #include "audioEnvelope.h"
+#include "batchCorrelation.h"
 #include "definitions.h"
+#include <QFutureWatcher>
 #include <QList>
+#include <QMutex>
+#include <QPair>
 
 /**
   This class does the correlation between two tracks
   in order to synchronize (align) them.
 
   It uses one main track (used in the initializer); further tracks will be
-  aligned relative to this main track.
+  aligned relative to this main track. The children are correlated in
+  parallel, sharing the spectrum of the main track.
   */
 class AudioCorrelation : public QObject
 {
@@ -53,23 +58,25 @@ public:
     const AudioCorrelationInfo *info(int childIndex) const;
     int getShift(int childIndex) const;
 
-    /**
-      Correlates the two vectors envMain and envSub.
-      \c correlation must be a pre-allocated vector of size sizeMain+sizeSub+1.
-      */
-    static void correlate(const qint64 *envMain, size_t sizeMain, const qint64 *envSub, size_t sizeSub, qint64 *correlation, qint64 *out_max = nullptr);
-
 private:
     std::unique_ptr<AudioEnvelope> m_mainTrackEnvelope;
 
     QList<AudioEnvelope *> m_children;
     QList<AudioCorrelationInfo *> m_correlations;
 
+    /** @brief Returns the correlation engine of the main track, blocks until its envelope is computed */
+    const BatchCorrelation &batch();
+    QMutex m_batchMutex;
+    std::unique_ptr<BatchCorrelation> m_batch;
+    /** @brief Children whose correlation is being computed */
+    QList<QPair<AudioEnvelope *, QFutureWatcher<AudioCorrelationInfo *> *>> m_pending;
+
 private slots:
     /**
      This is invoked when the child envelope is computed. This
-     triggers the actual computations of the cross-correlation for
-     aligning the envelope to the reference envelope.
+     starts the computation of the cross-correlation for
+     aligning the envelope to the reference envelope, in a
+     separate thread.
 
      Takes ownership of @p envelope.
    */
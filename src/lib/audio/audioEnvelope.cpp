@@ -39,6 +39,18 @@ AudioEnvelope::AudioEnvelope(const QString &binId, int clipId, size_t offset, si
         qCDebug(KDENLIVE_LOG) << "// Cannot create envelope for producer: " << binId;
     } else {
         m_info = std::make_unique<AudioInfo>(m_producer);
+        if (clip->audioInfo()) {
+            // Reuse the levels of the audio thumbnail if they cover the analysed zone
+            const int stream = clip->audioInfo()->ffmpeg_audio_index();
+            const int channels = clip->audioInfo()->channelsForStream(stream);
+            const QVector<uint8_t> levels = clip->audioFrameCache(stream);
+            const int start = m_producer->get_in();
+            if (channels > 0 && qint64(levels.size()) >= (qint64(start) + qint64(m_envelopeSize)) * channels) {
+                m_cachedLevels = levels;
+                m_cachedChannels = channels;
+                m_cachedStart = start;
+            }
+        }
     }
 }
 
@@ -92,13 +104,21 @@ const std::vector<qint64> &AudioEnvelope::envelope()
     return audioSummary().audioAmplitudes;
 }
 
-AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
+void AudioEnvelope::envelopeFromLevels(AudioSummary &summary) const
 {
-    qCDebug(KDENLIVE_LOG) << "Loading envelope …";
-    AudioSummary summary(m_envelopeSize);
-    if (!m_info || m_info->size() < 1) {
-        return summary;
+    const uint8_t *levels = m_cachedLevels.constData() + qint64(m_cachedStart) * m_cachedChannels;
+    for (size_t i = 0; i < summary.audioAmplitudes.size(); ++i) {
+        qint64 sum = 0;
+        for (int channel = 0; channel < m_cachedChannels; ++channel) {
+            sum += *levels++;
+        }
+        // Keep some precision for the mean removal, levels only have 8 bits
+        summary.audioAmplitudes[i] = sum << 8;
     }
+}
+
+void AudioEnvelope::decodeEnvelope(AudioSummary &summary) const
+{
     int samplingRate = m_info->info(0)->samplingRate();
     mlt_audio_format format_s16 = mlt_audio_s16;
     int channels = 1;
@@ -120,6 +140,25 @@ AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
         pCore->displayMessage(i18n("Processing data analysis"), ProcessingJobMessage, int(100 * i / max));
     }
     qCDebug(KDENLIVE_LOG) << "Calculating the envelope (" << m_envelopeSize << " frames) took " << t.elapsed() << " ms.";
+}
+
+AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
+{
+    qCDebug(KDENLIVE_LOG) << "Loading envelope …";
+    AudioSummary summary(m_envelopeSize);
+    if (summary.audioAmplitudes.empty()) {
+        return summary;
+    }
+    if (!m_cachedLevels.isEmpty()) {
+        envelopeFromLevels(summary);
+        qCDebug(KDENLIVE_LOG) << "Envelope (" << m_envelopeSize << " frames) read from the audio thumbnail levels";
+    } else {
+        if (!m_info || m_info->size() < 1) {
+            return summary;
+        }
+        decodeEnvelope(summary);
+    }
+    size_t max = summary.audioAmplitudes.size();
     qCDebug(KDENLIVE_LOG) << "Normalizing envelope …";
     const qint64 meanBeforeNormalization =
         std::accumulate(summary.audioAmplitudes.begin(), summary.audioAmplitudes.end(), 0LL) / qint64(summary.audioAmplitudes.size());
@@ -11,6 +11,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "audioInfo.h"
 #include <QFutureWatcher>
 #include <QObject>
+#include <QVector>
 #include <memory>
 #include <mlt++/Mlt.h>
 #include <vector>
@@ -21,6 +22,9 @@ class QImage;
   The audio envelope is a simplified version of an audio track
   with frame resolution. One entry is calculated by the sum
   of the absolute values of all samples in the current frame.
+  When the audio levels of the clip were already computed for its
+  audio thumbnail, the envelope is built from these levels instead
+  of decoding the audio again.
 
   See also: http://web.archive.org/web/20180626235917/http://bemasc.net/wordpress/2011/07/26/an-auto-aligner-for-pitivi/
   */
@@ -86,8 +90,22 @@ private:
     */
     AudioSummary loadAndNormalizeEnvelope() const;
 
+    /**
+     Builds the envelope from the cached per frame audio levels
+     of the clip, one value per channel and frame.
+    */
+    void envelopeFromLevels(AudioSummary &summary) const;
+    /**
+     Builds the envelope by decoding the audio of the producer.
+    */
+    void decodeEnvelope(AudioSummary &summary) const;
+
     std::shared_ptr<Mlt::Producer> m_producer;
     std::unique_ptr<AudioInfo> m_info;
+    // Audio thumbnail levels of the clip, empty if they do not cover the analysed zone
+    QVector<uint8_t> m_cachedLevels;
+    int m_cachedChannels{0};
+    int m_cachedStart{0};
     QFutureWatcher<AudioSummary> m_watcher;
     QFuture<AudioSummary> m_audioSummary;
 
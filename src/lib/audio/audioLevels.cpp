@@ -0,0 +1,177 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audioLevels.h"
+#include "kdenlive_debug.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const char levelsMagic[4] = {'K', 'D', 'A', 'L'};
+// magic, version, channels, frames, decimation count
+const int headerSize = 4 + 4 * int(sizeof(quint32));
+// Stop decimating once a level has less entries than this
+const int minDecimatedEntries = 16;
+} // namespace
+
+const quint32 AudioLevels::formatVersion = 2;
+
+AudioLevels::AudioLevels(const QVector<uint8_t> &levels, int channels)
+    : m_channels(channels)
+    , m_raw(levels)
+{
+    buildDecimations();
+}
+
+void AudioLevels::buildDecimations()
+{
+    m_decimations.clear();
+    int entries = frames();
+    if (m_channels <= 0 || entries < 2 * minDecimatedEntries) {
+        return;
+    }
+    // First decimation is built from the raw levels
+    int count = (entries + 1) / 2;
+    QVector<uint8_t> current(count * m_channels);
+    const uint8_t *raw = m_raw.constData();
+    uint8_t *out = current.data();
+    for (int i = 0; i < count; ++i) {
+        int first = 2 * i;
+        int second = std::min(first + 1, entries - 1);
+        for (int c = 0; c < m_channels; ++c) {
+            *out++ = std::max(raw[first * m_channels + c], raw[second * m_channels + c]);
+        }
+    }
+    m_decimations << current;
+    // Next decimations are built from the previous one
+    while (count >= 2 * minDecimatedEntries) {
+        int previousCount = count;
+        count = (count + 1) / 2;
+        const QVector<uint8_t> &previous = m_decimations.constLast();
+        QVector<uint8_t> next(count * m_channels);
+        const uint8_t *in = previous.constData();
+        out = next.data();
+        for (int i = 0; i < count; ++i) {
+            int first = 2 * i;
+            int second = std::min(first + 1, previousCount - 1);
+            for (int c = 0; c < m_channels; ++c) {
+                *out++ = std::max(in[first * m_channels + c], in[second * m_channels + c]);
+            }
+        }
+        m_decimations << next;
+    }
+}
+
+bool AudioLevels::isEmpty() const
+{
+    return m_channels <= 0 || m_raw.isEmpty();
+}
+
+int AudioLevels::channels() const
+{
+    return m_channels;
+}
+
+int AudioLevels::frames() const
+{
+    return m_channels > 0 ? m_raw.size() / m_channels : 0;
+}
+
+const QVector<uint8_t> &AudioLevels::rawLevels() const
+{
+    return m_raw;
+}
+
+int AudioLevels::decimationCount() const
+{
+    return m_decimations.size();
+}
+
+const QVector<uint8_t> &AudioLevels::decimation(int n) const
+{
+    Q_ASSERT(n >= 1 && n <= m_decimations.size());
+    return m_decimations.at(n - 1);
+}
+
+bool AudioLevels::save(const QString &path) const
+{
+    if (isEmpty()) {
+        return false;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(KDENLIVE_LOG) << "// Cannot write audio levels to" << path;
+        return false;
+    }
+    uchar header[headerSize];
+    memcpy(header, levelsMagic, 4);
+    qToLittleEndian<quint32>(formatVersion, header + 4);
+    qToLittleEndian<quint32>(quint32(m_channels), header + 8);
+    qToLittleEndian<quint32>(quint32(frames()), header + 12);
+    qToLittleEndian<quint32>(quint32(m_decimations.size()), header + 16);
+    file.write(reinterpret_cast<const char *>(header), headerSize);
+    file.write(reinterpret_cast<const char *>(m_raw.constData()), frames() * m_channels);
+    for (const QVector<uint8_t> &level : m_decimations) {
+        file.write(reinterpret_cast<const char *>(level.constData()), level.size());
+    }
+    return file.commit();
+}
+
+AudioLevels AudioLevels::load(const QString &path, int channels)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return AudioLevels();
+    }
+    qint64 size = file.size();
+    uchar header[headerSize];
+    if (size <= headerSize || file.read(reinterpret_cast<char *>(header), headerSize) != headerSize) {
+        return AudioLevels();
+    }
+    AudioLevels result;
+    quint32 version = qFromLittleEndian<quint32>(header + 4);
+    int fileChannels = int(qFromLittleEndian<quint32>(header + 8));
+    qint64 frames = qint64(qFromLittleEndian<quint32>(header + 12));
+    int decimations = int(qFromLittleEndian<quint32>(header + 16));
+    if (decimations > 32) {
+        return result;
+    }
+    // Compute the expected file size before reading the data
+    qint64 expected = headerSize + frames * fileChannels;
+    qint64 entries = frames;
+    for (int i = 0; i < decimations; ++i) {
+        entries = (entries + 1) / 2;
+        expected += entries * fileChannels;
+    }
+    if (memcmp(header, levelsMagic, 4) != 0 || version != formatVersion || fileChannels != channels || fileChannels <= 0 || frames == 0 || expected != size) {
+        qCDebug(KDENLIVE_LOG) << "// Discarding invalid audio levels cache" << path;
+        return result;
+    }
+    // Each level is read straight into its vector. The levels are handed to the producers as QVectors, so mapping the
+    // file would only add a copy, and a mapped file cannot be replaced or deleted on Windows while a clip uses it.
+    auto readLevel = [&file](QVector<uint8_t> &level, int levelSize) {
+        level.resize(levelSize);
+        return file.read(reinterpret_cast<char *>(level.data()), levelSize) == levelSize;
+    };
+    if (!readLevel(result.m_raw, int(frames * fileChannels))) {
+        return AudioLevels();
+    }
+    entries = frames;
+    result.m_decimations.resize(decimations);
+    for (int i = 0; i < decimations; ++i) {
+        entries = (entries + 1) / 2;
+        if (!readLevel(result.m_decimations[i], int(entries * fileChannels))) {
+            return AudioLevels();
+        }
+    }
+    result.m_channels = fileChannels;
+    return result;
+}
@@ -0,0 +1,59 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef AUDIOLEVELS_H
+#define AUDIOLEVELS_H
+
+#include <QString>
+#include <QVector>
+
+/**
+  The audio levels of one audio stream, as produced by AudioLevelsTask:
+  one uint8 level per channel and frame, channels interleaved.
+
+  Next to the raw levels, we keep decimated copies of the data. Decimation n
+  (n >= 1) stores, for each block of 2^n frames, the maximum level of each
+  channel, channels interleaved. The levels are magnitudes, so the maximum is
+  all the waveform needs to draw a zoomed out clip without reading every frame.
+
+  The levels are persisted in the project's audio cache folder using a small
+  versioned binary format, read back with one read per level.
+  */
+class AudioLevels
+{
+public:
+    AudioLevels() = default;
+    /** @brief Build the decimated levels from the raw interleaved level data */
+    AudioLevels(const QVector<uint8_t> &levels, int channels);
+
+    bool isEmpty() const;
+    int channels() const;
+    /** @brief Number of frames covered by the raw levels */
+    int frames() const;
+    const QVector<uint8_t> &rawLevels() const;
+    /** @brief Number of available decimations, decimation n covers 2^n frames per entry */
+    int decimationCount() const;
+    /** @brief The maximum levels of decimation n, with 1 <= n <= decimationCount() */
+    const QVector<uint8_t> &decimation(int n) const;
+
+    /** @brief Write the levels to a binary cache file, returns false on failure */
+    bool save(const QString &path) const;
+    /** @brief Read a binary cache file. Returns empty levels if the file is missing,
+        invalid, from another format version or does not have the expected number of channels */
+    static AudioLevels load(const QString &path, int channels);
+
+    /** @brief Version of the binary cache format, increase it when changing the file layout */
+    static const quint32 formatVersion;
+
+private:
+    int m_channels{0};
+    QVector<uint8_t> m_raw;
+    QVector<QVector<uint8_t>> m_decimations;
+    void buildDecimations();
+};
+
+#endif // AUDIOLEVELS_H
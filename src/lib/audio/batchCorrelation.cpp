@@ -0,0 +1,44 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "batchCorrelation.h"
+
+#include <QFuture>
+#include <QtConcurrent>
+#include <utility>
+
+BatchCorrelation::BatchCorrelation(std::vector<qint64> reference)
+    : m_reference(std::move(reference))
+    , m_fft(m_reference.data(), m_reference.size())
+{
+}
+
+size_t BatchCorrelation::referenceSize() const
+{
+    return m_reference.size();
+}
+
+void BatchCorrelation::correlate(const std::vector<qint64> &child, AudioCorrelationInfo *info) const
+{
+    m_fft.correlate(child.data(), child.size(), info->correlationVector());
+}
+
+std::vector<std::unique_ptr<AudioCorrelationInfo>> BatchCorrelation::correlateAll(const std::vector<std::vector<qint64>> &children) const
+{
+    std::vector<std::unique_ptr<AudioCorrelationInfo>> result(children.size());
+    QList<QFuture<void>> jobs;
+    for (size_t i = 0; i < children.size(); ++i) {
+        result[i].reset(new AudioCorrelationInfo(m_reference.size(), children[i].size()));
+        AudioCorrelationInfo *info = result[i].get();
+        const std::vector<qint64> &child = children[i];
+        jobs << QtConcurrent::run([this, &child, info]() { correlate(child, info); });
+    }
+    for (QFuture<void> &job : jobs) {
+        job.waitForFinished();
+    }
+    return result;
+}
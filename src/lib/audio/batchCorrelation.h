@@ -0,0 +1,46 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef BATCHCORRELATION_H
+#define BATCHCORRELATION_H
+
+#include "audioCorrelationInfo.h"
+#include "fftCorrelation.h"
+#include <memory>
+#include <vector>
+
+/**
+  Correlates many envelopes against the same reference envelope,
+  for example several camera angles aligned on one reference recording.
+
+  The spectrum of the reference is only computed once, and correlate()
+  can be called from several threads at once.
+  */
+class BatchCorrelation
+{
+public:
+    explicit BatchCorrelation(std::vector<qint64> reference);
+
+    size_t referenceSize() const;
+
+    /**
+      Correlates \c child with the reference. \c info must have been
+      created with the sizes of the reference and of \c child.
+      */
+    void correlate(const std::vector<qint64> &child, AudioCorrelationInfo *info) const;
+
+    /**
+      Correlates all \c children with the reference, in parallel.
+      */
+    std::vector<std::unique_ptr<AudioCorrelationInfo>> correlateAll(const std::vector<std::vector<qint64>> &children) const;
+
+private:
+    std::vector<qint64> m_reference;
+    FFTReference m_fft;
+};
+
+#endif // BATCHCORRELATION_H
@@ -11,8 +11,64 @@ extern "C" {
 
 #include "kdenlive_debug.h"
 #include <algorithm>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
+namespace {
+struct FFTPlans
+{
+    explicit FFTPlans(size_t size)
+        : forward(kiss_fftr_alloc(int(size), 0, nullptr, nullptr))
+        , inverse(kiss_fftr_alloc(int(size), 1, nullptr, nullptr))
+    {
+    }
+    ~FFTPlans()
+    {
+        kiss_fftr_free(forward);
+        kiss_fftr_free(inverse);
+    }
+    kiss_fftr_cfg forward;
+    kiss_fftr_cfg inverse;
+};
+
+// kiss_fftr configurations contain scratch buffers, so each thread keeps its own plans
+const FFTPlans &plans(size_t size)
+{
+    thread_local std::unordered_map<size_t, std::unique_ptr<FFTPlans>> cache;
+    std::unique_ptr<FFTPlans> &cached = cache[size];
+    if (!cached) {
+        cached.reset(new FFTPlans(size));
+    }
+    return *cached;
+}
+
+// Normalizes the qint64 values to floats in [-1, 1]
+void normalize(const qint64 *values, size_t size, float *out, bool reversed)
+{
+    qint64 max = 1;
+    for (size_t i = 0; i < size; ++i) {
+        max = std::max(max, qAbs(values[i]));
+    }
+    for (size_t i = 0; i < size; ++i) {
+        out[reversed ? size - 1 - i : i] = float(values[i]) / max;
+    }
+}
+} // namespace
+
+size_t FFTCorrelation::fftSize(size_t largestSize)
+{
+    // To avoid issues with repetition (we are dealing with cosine waves
+    // in the fourier domain) we need to pad the vectors to at least twice their size,
+    // otherwise convolution would convolve with the repeated pattern as well.
+    // The size should be a power of 2 (for FFT).
+    size_t size = 64;
+    while (size / 2 < largestSize) {
+        size = size << 1;
+    }
+    return size;
+}
+
 void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated)
 {
     auto *correlatedFloat = new float[leftSize + rightSize + 1];
@@ -74,21 +130,13 @@ void FFTCorrelation::convolve(const float *left, const size_t leftSize, const fl
     QElapsedTimer time;
     time.start();
 
-    // To avoid issues with repetition (we are dealing with cosine waves
-    // in the fourier domain) we need to pad the vectors to at least twice their size,
-    // otherwise convolution would convolve with the repeated pattern as well
-    size_t largestSize = std::max(leftSize, rightSize);
-
-    // The vectors must have the same size (same frequency resolution!) and should
-    // be a power of 2 (for FFT).
-    size_t size = 64;
-    while (size / 2 < largestSize) {
-        size = size << 1;
-    }
+    // The vectors must have the same size (same frequency resolution!)
+    const size_t size = fftSize(std::max(leftSize, rightSize));
 
     const size_t fft_size = size / 2 + 1;
-    kiss_fftr_cfg fftConfig = kiss_fftr_alloc(int(size), 0, nullptr, nullptr);
-    kiss_fftr_cfg ifftConfig = kiss_fftr_alloc(int(size), 1, nullptr, nullptr);
+    const FFTPlans &fftPlans = plans(size);
+    kiss_fftr_cfg fftConfig = fftPlans.forward;
+    kiss_fftr_cfg ifftConfig = fftPlans.inverse;
     std::vector<kiss_fft_cpx> leftFFT(fft_size);
     std::vector<kiss_fft_cpx> rightFFT(fft_size);
     std::vector<kiss_fft_cpx> correlatedFFT(fft_size);
@@ -120,9 +168,55 @@ void FFTCorrelation::convolve(const float *left, const size_t leftSize, const fl
     kiss_fftri(ifftConfig, &correlatedFFT[0], &convolved[0]);
     std::copy(convolved.begin(), convolved.begin() + int(out_size) - 1, out_convolved + 1);
 
-    // Finally some cleanup.
-    kiss_fftr_free(fftConfig);
-    kiss_fftr_free(ifftConfig);
-
     qCDebug(KDENLIVE_LOG) << "FFT convolution computed. Time taken: " << time.elapsed() << " ms";
 }
+
+FFTReference::FFTReference(const qint64 *reference, size_t size)
+    : m_reference(size)
+{
+    normalize(reference, size, m_reference.data(), false);
+}
+
+const std::vector<float> &FFTReference::spectrum(size_t fftSize) const
+{
+    QMutexLocker lock(&m_mutex);
+    // References to map elements stay valid when other sizes are inserted
+    std::vector<float> &spectrum = m_spectra[fftSize];
+    if (spectrum.empty()) {
+        std::vector<float> data(fftSize, 0);
+        std::copy(m_reference.begin(), m_reference.end(), data.begin());
+        spectrum.resize(2 * (fftSize / 2 + 1));
+        kiss_fftr(plans(fftSize).forward, data.data(), reinterpret_cast<kiss_fft_cpx *>(spectrum.data()));
+    }
+    return spectrum;
+}
+
+void FFTReference::correlate(const qint64 *right, const size_t rightSize, float *out_correlated) const
+{
+    const size_t size = FFTCorrelation::fftSize(std::max(m_reference.size(), rightSize));
+    const auto *referenceFFT = reinterpret_cast<const kiss_fft_cpx *>(spectrum(size).data());
+    const FFTPlans &fftPlans = plans(size);
+
+    // The right side is reversed, see FFTCorrelation::correlate()
+    std::vector<float> data(size, 0);
+    normalize(right, rightSize, data.data(), true);
+    std::vector<kiss_fft_cpx> rightFFT(size / 2 + 1);
+    kiss_fftr(fftPlans.forward, data.data(), rightFFT.data());
+    for (size_t i = 0; i < rightFFT.size(); ++i) {
+        const kiss_fft_cpx r = rightFFT[i];
+        rightFFT[i].r = referenceFFT[i].r * r.r - referenceFFT[i].i * r.i;
+        rightFFT[i].i = referenceFFT[i].r * r.i + referenceFFT[i].i * r.r;
+    }
+    kiss_fftri(fftPlans.inverse, rightFFT.data(), data.data());
+    *out_correlated = 0;
+    std::copy(data.begin(), data.begin() + int(m_reference.size() + rightSize), out_correlated + 1);
+}
+
+void FFTReference::correlate(const qint64 *right, const size_t rightSize, qint64 *out_correlated) const
+{
+    std::vector<float> correlated(m_reference.size() + rightSize + 1);
+    correlate(right, rightSize, correlated.data());
+    for (size_t i = 0; i < correlated.size(); ++i) {
+        out_correlated[i] = qint64(correlated[i]);
+    }
+}
@@ -6,7 +6,11 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #ifndef FFTCORRELATION_H
 #define FFTCORRELATION_H
 
+#include <QMutex>
 #include <QtGlobal>
+#include <map>
+#include <vector>
+
 /** @class FFTCorrelation
     @brief This class provides methods to calculate convolution
     and correlation of two vectors by means of FFT, which
@@ -31,6 +35,34 @@ public:
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated);
 
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated);
+
+    /**
+      Size of the FFT used to convolve vectors of at most \c largestSize entries.
+      */
+    static size_t fftSize(size_t largestSize);
+};
+
+/** @class FFTReference
+    @brief Correlates vectors against a fixed left vector, like
+    FFTCorrelation::correlate(). The spectrum of the reference is only
+    computed once per FFT size, and correlate() can be called from
+    several threads at once.
+  */
+class FFTReference
+{
+public:
+    FFTReference(const qint64 *reference, size_t size);
+
+    void correlate(const qint64 *right, const size_t rightSize, float *out_correlated) const;
+    void correlate(const qint64 *right, const size_t rightSize, qint64 *out_correlated) const;
+
+private:
+    /** @brief The spectrum of the padded reference, as interleaved real and imaginary parts */
+    const std::vector<float> &spectrum(size_t fftSize) const;
+
+    std::vector<float> m_reference;
+    mutable QMutex m_mutex;
+    mutable std::map<size_t, std::vector<float>> m_spectra;
 };
 
 #endif // FFTCORRELATION_H
@@ -28,7 +28,7 @@ FFTTools::FFTTools()
 }
 FFTTools::~FFTTools()
 {
-    QHash<QString, kiss_fftr_cfg>::iterator i;
+    QHash<uint, kiss_fftr_cfg>::iterator i;
     for (i = m_fftCfgs.begin(); i != m_fftCfgs.end(); ++i) {
         free(*i);
     }
@@ -118,64 +118,63 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
         return;
     }
 
-    const QString cfgSig = cfgSignature(int(windowSize));
-    const QString winSig = windowSignature(windowType, int(windowSize), param);
-
     // Get the kiss_fft configuration from the config cache
     // or build a new configuration if the requested one is not available.
-    kiss_fftr_cfg myCfg;
-    if (m_fftCfgs.contains(cfgSig)) {
-#ifdef DEBUG_FFTTOOLS
-        qCDebug(KDENLIVE_LOG) << "Re-using FFT configuration with size " << windowSize;
-#endif
-        myCfg = m_fftCfgs.value(cfgSig);
-    } else {
+    kiss_fftr_cfg myCfg = m_fftCfgs.value(windowSize, nullptr);
+    if (myCfg == nullptr) {
 #ifdef DEBUG_FFTTOOLS
         qCDebug(KDENLIVE_LOG) << "Creating FFT configuration with size " << windowSize;
 #endif
         myCfg = kiss_fftr_alloc(int(windowSize), 0, nullptr, nullptr);
-        m_fftCfgs.insert(cfgSig, myCfg);
+        m_fftCfgs.insert(windowSize, myCfg);
     }
 
     // Get the window function from the cache
     // (except for a rectangular window; nothing to do there).
-    QVector<float> window;
     float windowScaleFactor = 1;
     if (windowType != FFTTools::Window_Rect) {
-
-        if (m_windowFunctions.contains(winSig)) {
+        if (m_window.isEmpty() || windowType != m_windowType || windowSize != m_windowSize || !qFuzzyCompare(param + 1, m_windowParam + 1)) {
+            const QString winSig = windowSignature(windowType, int(windowSize), param);
+            if (m_windowFunctions.contains(winSig)) {
 #ifdef DEBUG_FFTTOOLS
-            qCDebug(KDENLIVE_LOG) << "Re-using window function with signature " << winSig;
+                qCDebug(KDENLIVE_LOG) << "Re-using window function with signature " << winSig;
 #endif
-            window = m_windowFunctions.value(winSig);
-        } else {
+                m_window = m_windowFunctions.value(winSig);
+            } else {
 #ifdef DEBUG_FFTTOOLS
-            qCDebug(KDENLIVE_LOG) << "Building new window function with signature " << winSig;
+                qCDebug(KDENLIVE_LOG) << "Building new window function with signature " << winSig;
 #endif
-            window = FFTTools::window(windowType, int(windowSize), 0);
-            m_windowFunctions.insert(winSig, window);
+                m_window = FFTTools::window(windowType, int(windowSize), 0);
+                m_windowFunctions.insert(winSig, m_window);
+            }
+            m_windowType = windowType;
+            m_windowSize = windowSize;
+            m_windowParam = param;
         }
-        windowScaleFactor = 1.0f / window[int(windowSize)];
+        windowScaleFactor = 1.0f / m_window.at(int(windowSize));
     }
+    const float *windowData = m_window.constData();
 
     // Prepare frequency space vector. The resulting FFT vector is only half as long.
-    auto *freqData = new kiss_fft_cpx[size_t(windowSize) / 2];
-    auto *data = new float[size_t(windowSize)];
+    m_fftOutput.resize(size_t(windowSize) / 2 + 1);
+    m_fftInput.resize(size_t(windowSize));
+    kiss_fft_cpx *freqData = m_fftOutput.data();
+    float *data = m_fftInput.data();
 
     // Copy the first channel's audio into a vector for the FFT display;
     // Fill the data vector indices that cannot be covered with sample data with 0
     if (numSamples < windowSize) {
-        std::fill(&data[numSamples], &data[windowSize - 1], 0);
+        std::fill(data + numSamples, data + windowSize, 0.f);
     }
     // Normalize signals to [0,1] to get correct dB values later on
-    for (uint i = 0; i < numSamples && i < windowSize; ++i) {
-        // Performance note: Benchmarking has shown that using the if/else inside the loop
-        // does not do noticeable worse than keeping it outside (perhaps the branch predictor
-        // is good enough), so it remains in there for better readability.
-        if (windowType != FFTTools::Window_Rect) {
-            data[i] = float(audioFrame.data()[i * numChannels + channel]) / 32767.0f * window[int(i)];
-        } else {
-            data[i] = float(audioFrame.data()[i * numChannels + channel]) / 32767.0f;
+    const qint16 *samples = audioFrame.constData();
+    if (windowType != FFTTools::Window_Rect) {
+        for (uint i = 0; i < numSamples && i < windowSize; ++i) {
+            data[i] = float(samples[i * numChannels + channel]) / 32767.0f * windowData[i];
+        }
+    } else {
+        for (uint i = 0; i < numSamples && i < windowSize; ++i) {
+            data[i] = float(samples[i * numChannels + channel]) / 32767.0f;
         }
     }
 
@@ -184,13 +183,10 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
 
     // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
     // with N = FFT size (after FFT, 1/2 window size)
+    // which is 10 * log(r² + i²) + 20 * log(scale / N), without computing the square root for each value
+    const float offset = 20 * log10f(windowScaleFactor / (float(windowSize) / 2.0f));
     for (uint i = 0; i < windowSize / 2; ++i) {
-        // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
-        // with N = FFT size (after FFT, 1/2 window size)
-        freqSpectrum[i] =
-            20 * logf(powf(powf(fabs(freqData[i].r * windowScaleFactor), 2) + powf(fabs(freqData[i].i * windowScaleFactor), 2), .5) / (float(windowSize) / 2.0f)) /
-            logf(10);
-        ;
+        freqSpectrum[i] = 10 * log10f(freqData[i].r * freqData[i].r + freqData[i].i * freqData[i].i) + offset;
     }
 
 #ifdef DEBUG_FFTTOOLS
@@ -220,25 +216,28 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
 #ifdef DEBUG_FFTTOOLS
     qCDebug(KDENLIVE_LOG) << "Calculated FFT in " << start.elapsed() << " ms.";
 #endif
-    delete[] freqData;
-    delete[] data;
 }
 
 const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &in, const uint targetSize, uint left, uint right, float fill)
+{
+    QVector<float> out(static_cast<int>(targetSize));
+    interpolatePeakPreserving(in.constData(), in.size(), out.data(), targetSize, left, right, fill);
+    return out;
+}
+
+void FFTTools::interpolatePeakPreserving(const float *in, const int inSize, float *out, const uint targetSize, uint left, uint right, float fill)
 {
 #ifdef DEBUG_FFTTOOLS
     QTime start = QTime::currentTime();
 #endif
 
     if (right == 0) {
-        Q_ASSERT(in.size() > 0);
-        right = uint(in.size()) - 1;
+        Q_ASSERT(inSize > 0);
+        right = uint(inSize) - 1;
     }
     Q_ASSERT(targetSize > 0);
     Q_ASSERT(left < right);
 
-    QVector<float> out(static_cast<int>(targetSize));
-
     float x;
     int xi;
     int i;
@@ -254,14 +253,14 @@ const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &i
             x = float(i) / (targetSize - 1) * (right - left) + left;
             xi = int(floor(x));
 
-            if (x > float(in.size() - 1)) {
-                // This may happen if right > in.size()-1; Fill the rest of the vector
+            if (x > float(inSize - 1)) {
+                // This may happen if right > inSize-1; Fill the rest of the vector
                 // with the default value now.
                 break;
             }
 
             // Use linear interpolation in order to get smoother display
-            if (xi == 0 || xi == in.size() - 1) {
+            if (xi == 0 || xi == inSize - 1) {
                 // ... except if we are at the left or right border of the input signal.
                 // Special case here since we consider previous and future values as well for
                 // the actual interpolation (not possible here).
@@ -295,7 +294,7 @@ const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &i
 
             out[i] = fill;
 
-            for (; src < xi && src < in.size(); ++src) {
+            for (; src < xi && src < inSize; ++src) {
                 if (out[i] < in[src]) {
                     out[i] = in[src];
                 }
@@ -311,10 +310,8 @@ const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &i
     }
 
 #ifdef DEBUG_FFTTOOLS
-    qCDebug(KDENLIVE_LOG) << "Interpolated " << targetSize << " nodes from " << in.size() << " input points in " << start.elapsed() << " ms";
+    qCDebug(KDENLIVE_LOG) << "Interpolated " << targetSize << " nodes from " << inSize << " input points in " << start.elapsed() << " ms";
 #endif
-
-    return out;
 }
 
 #ifdef DEBUG_FFTTOOLS
@@ -12,6 +12,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "../external/kiss_fft/tools/kiss_fftr.h"
 #include <QHash>
 #include <QVector>
+#include <vector>
 
 class FFTTools
 {
@@ -69,10 +70,21 @@ public:
                             will be used for filling the missing information.
         */
     static const QVector<float> interpolatePeakPreserving(const QVector<float> &in, const uint targetSize, uint left = 0, uint right = 0, float fill = 0.0);
+    /** Same as above, writing the #targetSize interpolated values to out without allocating */
+    static void interpolatePeakPreserving(const float *in, const int inSize, float *out, const uint targetSize, uint left = 0, uint right = 0,
+                                          float fill = 0.0);
 
 private:
-    QHash<QString, kiss_fftr_cfg> m_fftCfgs;          // FFT cfg cache
+    QHash<uint, kiss_fftr_cfg> m_fftCfgs;             // FFT cfg cache, by window size
     QHash<QString, QVector<float>> m_windowFunctions; // Window function cache
+    // Window function of the last call, so that the cache is only searched when the parameters change
+    QVector<float> m_window;
+    WindowType m_windowType{Window_Rect};
+    uint m_windowSize{0};
+    float m_windowParam{0};
+    // Buffers reused by each transformation
+    std::vector<float> m_fftInput;
+    std::vector<kiss_fft_cpx> m_fftOutput;
 };
 
 #endif // FFTTOOLS_H
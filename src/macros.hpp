@@ -56,6 +56,16 @@ reading a Read-protected property. In that case, we try to write lock it first (
         Q_ASSERT(false);                                                                                                                                       \
     }
 
+/** @brief Same as PUSH_UNDO, operation describes the command in the undo journal used for crash recovery
+*/
+#define PUSH_JOURNALED_UNDO(undo, redo, text, operation)                                                                                                       \
+    if (auto ptr = m_undoStack.lock()) {                                                                                                                       \
+        ptr->push(new FunctionalUndoCommand(undo, redo, text), operation);                                                                                     \
+    } else {                                                                                                                                                   \
+        qDebug() << "ERROR : unable to access undo stack";                                                                                                     \
+        Q_ASSERT(false);                                                                                                                                       \
+    }
+
 /** @brief This macro takes as parameter one atomic operation and its reverse, and update
  * the undo and redo functional stacks/queue accordingly
  * This should be used in the rare case where we don't need a lock mutex. In general, prefer the other version
@@ -16,6 +16,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QFont>
 #include <QPaintEvent>
 #include <QPainter>
+#include <QTimer>
 #include <memory>
 
 const double log_factor = 1.0 / log10(1.0 / 127);
@@ -31,12 +32,15 @@ static inline double levelToDB(double level)
 MonitorAudioLevel::MonitorAudioLevel(int height, QWidget *parent)
     : ScopeWidget(parent)
     , audioChannels(2)
+    , m_levelsTimer(new QTimer(this))
     , m_height(height)
     , m_channelHeight(height / 2)
     , m_channelDistance(2)
     , m_channelFillHeight(m_channelHeight)
 {
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Preferred);
+    m_levelsTimer->setInterval(40);
+    connect(m_levelsTimer, &QTimer::timeout, this, &MonitorAudioLevel::refreshLevels);
     m_filter = std::make_unique<Mlt::Filter>(pCore->getCurrentProfile()->profile(), "audiolevel");
     if (!m_filter->is_valid()) {
         isValid = false;
@@ -66,12 +70,20 @@ void MonitorAudioLevel::refreshScope(const QSize & /*size*/, bool /*full*/)
                 // There was an error processing audio from frame
                 continue;
             }
-            QVector<int> levels;
-            for (int i = 0; i < audioChannels; i++) {
-                QString s = QStringLiteral("meta.media.audio_level.%1").arg(i);
-                levels << int(levelToDB(mFrame.get_double(s.toLatin1().constData())));
+            const int channelCount = qBound(0, audioChannels, MeterLevels::maxChannels);
+            if (int(m_levelKeys.size()) != channelCount) {
+                m_levelKeys.clear();
+                for (int i = 0; i < channelCount; i++) {
+                    m_levelKeys.push_back(QStringLiteral("meta.media.audio_level.%1").arg(i).toLatin1());
+                }
             }
-            QMetaObject::invokeMethod(this, "setAudioValues", Qt::QueuedConnection, Q_ARG(QVector<int>, levels));
+            MeterLevels levels;
+            levels.position = sFrame.get_position();
+            levels.channels = channelCount;
+            for (int i = 0; i < channelCount; i++) {
+                levels.values[size_t(i)] = int(levelToDB(mFrame.get_double(m_levelKeys[size_t(i)].constData())));
+            }
+            m_levelQueue.push(levels);
         }
     }
 }
@@ -176,30 +188,43 @@ void MonitorAudioLevel::drawBackground(int channels)
     p.end();
 }
 
-// cppcheck-suppress unusedFunction
-void MonitorAudioLevel::setAudioValues(const QVector<int> &values)
+void MonitorAudioLevel::refreshLevels()
 {
-    m_values = values;
-    if (m_peaks.size() != m_values.size()) {
-        m_peaks = values;
-        drawBackground(values.size());
-    } else {
-        for (int i = 0; i < m_values.size(); i++) {
-            m_peaks[i]--;
-            if (m_values.at(i) > m_peaks.at(i)) {
-                m_peaks[i] = m_values.at(i);
+    MeterLevels levels;
+    bool changed = false;
+    while (m_levelQueue.pop(levels)) {
+        // Reuse the buffers, without allocating for each frame
+        if (m_values.size() != levels.channels) {
+            m_values.resize(levels.channels);
+            for (int i = 0; i < levels.channels; i++) {
+                m_values[i] = int(levels.values[size_t(i)]);
+            }
+            m_peaks = m_values;
+            drawBackground(levels.channels);
+        } else {
+            for (int i = 0; i < levels.channels; i++) {
+                m_values[i] = int(levels.values[size_t(i)]);
+                m_peaks[i]--;
+                if (m_values.at(i) > m_peaks.at(i)) {
+                    m_peaks[i] = m_values.at(i);
+                }
             }
         }
+        changed = true;
+    }
+    if (changed) {
+        update();
     }
-    update();
 }
 
 void MonitorAudioLevel::setVisibility(bool enable)
 {
     if (enable) {
+        m_levelsTimer->start();
         setVisible(true);
         setFixedHeight(m_height);
     } else {
+        m_levelsTimer->stop();
         // set height to 0 so the toolbar layout is not affected
         setFixedHeight(0);
         setVisible(false);
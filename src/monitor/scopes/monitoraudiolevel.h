@@ -9,12 +9,16 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #define MONITORAUDIOLEVEL_H
 
 #include "scopewidget.h"
+#include "utils/audiolevelqueue.hpp"
+#include <QByteArray>
 #include <QWidget>
 #include <memory>
+#include <vector>
 
 namespace Mlt {
 class Filter;
 } // namespace Mlt
+class QTimer;
 
 class MonitorAudioLevel : public ScopeWidget
 {
@@ -33,6 +37,11 @@ protected:
 
 private:
     std::unique_ptr<Mlt::Filter> m_filter;
+    /** @brief Levels computed in the scope thread, read by the GUI timer */
+    AudioLevelQueue m_levelQueue;
+    /** @brief Names of the audio level properties, only used in the scope thread */
+    std::vector<QByteArray> m_levelKeys;
+    QTimer *m_levelsTimer;
     int m_height;
     QPixmap m_pixmap;
     QVector<int> m_peaks;
@@ -43,8 +52,9 @@ private:
     void drawBackground(int channels = 2);
     void refreshScope(const QSize &size, bool full) override;
 
-public slots:
-    void setAudioValues(const QVector<int> &values);
+private slots:
+    /** @brief Display the levels received since the last refresh */
+    void refreshLevels();
 };
 
 #endif
@@ -7,7 +7,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "bin/bin.h"
 #include "bin/projectitemmodel.h"
 #include "core.h"
+#include "doc/docundostack.hpp"
 #include "doc/kdenlivedoc.h"
+#include "doc/undojournal.hpp"
 #include "kdenlivesettings.h"
 #include "mainwindow.h"
 #include "monitor/monitormanager.h"
@@ -16,6 +18,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "project/dialogs/backupwidget.h"
 #include "project/dialogs/noteswidget.h"
 #include "project/dialogs/projectsettings.h"
+#include "utils/filehashcache.hpp"
 #include "utils/thumbnailcache.hpp"
 #include "xml/xml.hpp"
 
@@ -45,6 +48,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QMimeType>
 #include <QProgressDialog>
 #include <QTimeZone>
+#include <QtConcurrent>
 #include <audiomixer/mixermanager.hpp>
 #include <lib/localeHandling.h>
 
@@ -92,7 +96,10 @@ ProjectManager::ProjectManager(QObject *parent)
     dir.mkdir(QStringLiteral("titles"));
 }
 
-ProjectManager::~ProjectManager() = default;
+ProjectManager::~ProjectManager()
+{
+    m_autoSaveTask.waitForFinished();
+}
 
 void ProjectManager::slotLoadOnOpen()
 {
@@ -284,6 +291,7 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
 {
     // Disable autosave
     m_autoSaveTimer.stop();
+    m_autoSaveTask.waitForFinished();
     if ((m_project != nullptr) && m_project->isModified() && saveChanges) {
         QString message;
         if (m_project->url().fileName().isEmpty()) {
@@ -328,11 +336,17 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
     pCore->mixer()->unsetModel();
     // Release model shared pointers
     m_mainTimelineModel.reset();
+    if (quit) {
+        // Keep the clip hashes for the next session, the singleton is destroyed too late to write them reliably
+        FileHashCache::get()->save();
+    }
     return true;
 }
 
 bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveACopy)
 {
+    // The autosave file may be replaced below
+    m_autoSaveTask.waitForFinished();
     pCore->monitorManager()->pauseActiveMonitor();
     QString oldProjectFolder = m_project->url().isEmpty()
             ? QString()
@@ -362,6 +376,7 @@ bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveACopy)
     // Save timeline thumbnails
     QStringList thumbKeys = pCore->window()->getMainTimeline()->controller()->getThumbKeys();
     ThumbnailCache::get()->saveCachedThumbs(thumbKeys);
+    FileHashCache::get()->save();
     if (!saveACopy) {
         m_project->setUrl(url);
         // setting up autosave file in ~/.kde/data/stalefiles/kdenlive/
@@ -380,6 +395,10 @@ bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveACopy)
 
         pCore->window()->setWindowTitle(m_project->description());
         m_project->setModified(false);
+        if (std::shared_ptr<UndoJournal> journal = m_project->commandStack()->journal()) {
+            // Recovery is only proposed if the autosave file is newer than the project, it must be written on the next edit
+            journal->invalidate();
+        }
     }
     m_recentFilesAction->addUrl(url);
     // remember folder for next project opening
@@ -540,6 +559,7 @@ bool ProjectManager::checkForBackupFile(const QUrl &url, bool newFile)
     // remove the stale files
     for (KAutoSaveFile *stale : qAsConst(staleFiles)) {
         stale->open(QIODevice::ReadWrite);
+        UndoJournal(UndoJournal::journalPath(stale->fileName())).remove();
         delete stale;
     }
     return false;
@@ -619,12 +639,15 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale)
                                        KdenliveSettings::default_profile().isEmpty() ? pCore->getCurrentProfile()->path() : KdenliveSettings::default_profile(),
                                        QMap<QString, QString>(), QMap<QString, QString>(),
                                        {KdenliveSettings::videotracks(), KdenliveSettings::audiotracks()}, audioChannels, &openBackup, pCore->window());
+    // Edits recorded after the backup was written
+    QVector<QJsonObject> journal;
     if (stale == nullptr) {
         const QString projectId = QCryptographicHash::hash(url.fileName().toUtf8(), QCryptographicHash::Md5).toHex();
         QUrl autosaveUrl = QUrl::fromLocalFile(QFileInfo(url.path()).absoluteDir().absoluteFilePath(projectId + QStringLiteral(".kdenlive")));
         stale = new KAutoSaveFile(autosaveUrl, doc);
         doc->m_autosave = stale;
     } else {
+        journal = UndoJournal::read(UndoJournal::journalPath(stale->fileName()));
         doc->m_autosave = stale;
         stale->setParent(doc);
         // if loading from an autosave of unnamed file, or restore failed then keep unnamed
@@ -659,12 +682,25 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale)
     pCore->window()->connectDocument();
     pCore->mixer()->setModel(m_mainTimelineModel);
     m_mainTimelineModel->updateFieldOrderFilter(pCore->getCurrentProfile());
+    int replayed = 0;
+    for (const QJsonObject &operation : qAsConst(journal)) {
+        if (!m_mainTimelineModel->replayJournal(operation)) {
+            qCDebug(KDENLIVE_LOG) << "// Cannot replay" << journal.size() - replayed << "edits from the undo journal";
+            break;
+        }
+        replayed++;
+    }
     emit docOpened(m_project);
     pCore->displayMessage(QString(), OperationCompletedMessage, 100);
     if (openBackup) {
         slotOpenBackup(url);
     }
     m_lastSave.start();
+    if (replayed > 0) {
+        // Save the recovered edits, the journal is kept until then
+        m_autoSaveTimer.stop();
+        slotAutoSave();
+    }
     delete m_progressDialog;
     m_progressDialog = nullptr;
 }
@@ -731,6 +767,15 @@ KRecentFilesAction *ProjectManager::recentFilesAction()
 
 void ProjectManager::slotStartAutoSave()
 {
+    if (std::shared_ptr<UndoJournal> journal = m_project->commandStack()->journal()) {
+        if (!m_project->commandStack()->isPushingJournaled()) {
+            // This change cannot be replayed from the journal, the whole project must be saved
+            journal->invalidate();
+        } else if (journal->isComplete() && journal->size() < 500 && m_lastSave.elapsed() < 300000) {
+            // The edit is recorded in the journal, the project is saved again once the journal is long enough
+            return;
+        }
+    }
     if (m_lastSave.elapsed() > 300000) {
         // If the project was not saved in the last 5 minute, force save
         m_autoSaveTimer.stop();
@@ -742,23 +787,48 @@ void ProjectManager::slotStartAutoSave()
 
 void ProjectManager::slotAutoSave()
 {
+    if (m_autoSaveTask.isRunning()) {
+        // The previous backup is still being written
+        m_autoSaveTimer.start(3000);
+        return;
+    }
     prepareSave();
     QString saveFolder = m_project->url().adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile();
-    QString scene = projectSceneList(saveFolder);
-    if (!m_replacementPattern.isEmpty()) {
-        QMapIterator<QString, QString> i(m_replacementPattern);
-        while (i.hasNext()) {
-            i.next();
-            scene.replace(i.key(), i.value());
+    // The edits made after the project state is captured are recorded in a new journal
+    std::shared_ptr<UndoJournal> journal = m_project->autoSaveJournal();
+    if (journal) {
+        journal->startSnapshot();
+    }
+    // The playlist is built on the GUI thread, where no edit can change the services while they are serialized.
+    // Only the path replacements and the file writing are left to a worker thread
+    const QString scene = projectSceneList(saveFolder);
+    KdenliveDoc *doc = m_project;
+    const QMap<QString, QString> patterns = m_replacementPattern;
+    m_autoSaveTask = QtConcurrent::run([doc, journal, scene, patterns]() {
+        bool written = writeAutoSave(doc, scene, patterns);
+        if (journal) {
+            journal->finishSnapshot(written);
         }
+    });
+    m_lastSave.start();
+}
+
+// static
+bool ProjectManager::writeAutoSave(KdenliveDoc *doc, QString scene, const QMap<QString, QString> &replacementPattern)
+{
+    QMapIterator<QString, QString> i(replacementPattern);
+    while (i.hasNext()) {
+        i.next();
+        scene.replace(i.key(), i.value());
     }
     if (!scene.contains(QLatin1String("<track "))) {
         // In some unexplained cases, the MLT playlist is corrupted and all tracks are deleted. Don't save in that case.
-        pCore->displayMessage(i18n("Project was corrupted, cannot backup. Please close and reopen your project file to recover last backup"), ErrorMessage);
-        return;
+        QMetaObject::invokeMethod(pCore.get(), [] {
+            pCore->displayMessage(i18n("Project was corrupted, cannot backup. Please close and reopen your project file to recover last backup"), ErrorMessage);
+        }, Qt::QueuedConnection);
+        return false;
     }
-    m_project->slotAutoSave(scene);
-    m_lastSave.start();
+    return doc->slotAutoSave(scene);
 }
 
 QString ProjectManager::projectSceneList(const QString &outputFolder, const QString &overlayData)
@@ -777,7 +847,7 @@ QString ProjectManager::projectSceneList(const QString &outputFolder, const QStr
         pCore->window()->getMainTimeline()->controller()->requestEndTrimmingMode();
     }
     pCore->mixer()->pauseMonitoring(true);
-    QString scene = m_mainTimelineModel->sceneList(outputFolder, QString(), overlayData);
+    QString scene = m_mainTimelineModel->lockedSceneList(outputFolder, overlayData);
     pCore->mixer()->pauseMonitoring(false);
     if (isMultiTrack) {
         pCore->window()->getMainTimeline()->controller()->slotMultitrackView(true, false);
@@ -9,6 +9,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kdenlivecore_export.h"
 #include <KRecentFilesAction>
 #include <QDir>
+#include <QFuture>
 #include <QObject>
 #include <QTime>
 #include <QTimer>
@@ -198,11 +199,16 @@ protected:
 private:
     /** @brief checks if autoback files exists, recovers from it if user says yes, returns true if files were recovered. */
     bool checkForBackupFile(const QUrl &url, bool newFile = false);
+    /** @brief Write a project playlist to the autosave file of a document, can be called from a worker thread.
+     * @return false if the playlist is corrupted */
+    static bool writeAutoSave(KdenliveDoc *doc, QString scene, const QMap<QString, QString> &replacementPattern);
 
     KdenliveDoc *m_project{nullptr};
     std::shared_ptr<TimelineItemModel> m_mainTimelineModel;
     QElapsedTimer m_lastSave;
     QTimer m_autoSaveTimer;
+    /** @brief The backup being written in the background, the document cannot be closed until it is done */
+    QFuture<void> m_autoSaveTask;
     QUrl m_startUrl;
     QString m_loadClipsOnOpen;
     QMap<QString, QString> m_replacementPattern;
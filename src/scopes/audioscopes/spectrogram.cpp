@@ -34,10 +34,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 Spectrogram::Spectrogram(QWidget *parent)
     : AbstractAudioScopeWidget(true, parent)
-    , m_fftTools()
-    , m_fftHistory()
-    , m_fftHistoryImg()
-
+    , m_generator(SPECTROGRAM_HISTORY_SIZE)
 {
     m_ui = new Ui::Spectrogram_UI;
     m_ui->setupUi(this);
@@ -85,6 +82,7 @@ Spectrogram::Spectrogram(QWidget *parent)
         m_colorMap[i + 3 * 255 / 5] = qRgb(i * 5, 255, 0);       // green to yellow
         m_colorMap[i + 4 * 255 / 5] = qRgb(255, 255 - i * 5, 0); // yellow to red
     }
+    m_generator.setColorMap(m_colorMap, AbstractScopeWidget::colHighlightDark.rgba());
 }
 
 Spectrogram::~Spectrogram()
@@ -324,20 +322,10 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
         m_ui->labelFFTSizeNumber->setText(QVariant(fftWindow).toString());
 
         if (newDataAvailable) {
-
-            auto *freqSpectrum = new float[uint(fftWindow / 2)];
-
             // Get the spectral power distribution of the input samples,
             // using the given window size and function
             FFTTools::WindowType windowType = FFTTools::WindowType(m_ui->windowFunction->itemData(m_ui->windowFunction->currentIndex()).toInt());
-            m_fftTools.fftNormalized(audioFrame, 0, uint(num_channels), freqSpectrum, windowType, uint(fftWindow), 0);
-
-            // This method might be called also when a simple refresh is required.
-            // In this case there is no data to append to the history. Only append new data.
-            QVector<float> spectrumVector(fftWindow / 2);
-            memcpy(spectrumVector.data(), &freqSpectrum[0], uint(fftWindow) / 2 * sizeof(float));
-            m_fftHistory.prepend(spectrumVector);
-            delete[] freqSpectrum;
+            m_generator.addFrame(audioFrame, uint(num_channels), windowType, uint(fftWindow));
         }
 #ifdef DEBUG_SPECTROGRAM
         else {
@@ -345,97 +333,24 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
         }
 #endif
 
-        // Limit the maximum history size to avoid wasting space
-        while (m_fftHistory.size() > SPECTROGRAM_HISTORY_SIZE) {
-            m_fftHistory.removeLast();
-        }
-
-        // Draw the spectrum
-        QImage spectrum(m_scopeRect.size(), QImage::Format_ARGB32);
-        spectrum.fill(qRgba(0, 0, 0, 0));
-
-        QPainter davinci;
-        bool ok = davinci.begin(&spectrum);
-        if (!ok) {
-            qDebug() << "Warning: Could not initialise QPainter for rendering spectrogram.";
-            return spectrum;
-        }
-
-        const int h = m_innerScopeRect.height();
-        const int leftDist = m_innerScopeRect.left() - m_scopeRect.left();
-        const int topDist = m_innerScopeRect.top() - m_scopeRect.top();
-        int y;
-        bool completeRedraw = true;
-
-        if (m_fftHistoryImg.size() == m_scopeRect.size() && !m_parameterChanged) {
-            // The size of the widget and the parameters (like min/max dB) have not changed since last time,
-            // so we can re-use it, shift it by one pixel, and render the single remaining line. Usually about
-            // 10 times faster for a widget height of around 400 px.
-            if (newDataAvailable) {
-                davinci.drawImage(0, -1, m_fftHistoryImg);
-            } else {
-                // spectrum = m_fftHistoryImg does NOT work, leads to segfaults (anyone knows why, please tell me)
-                davinci.drawImage(0, 0, m_fftHistoryImg);
-            }
-            completeRedraw = false;
-        }
-
-        y = 0;
-        if ((newData != 0) || m_parameterChanged) {
+        if (m_parameterChanged) {
             m_parameterChanged = false;
-
-            QVector<float> dbMap;
-            uint right;
-            ////////////////FIXME
-            for (auto &it : m_fftHistory) {
-
-                int windowSize = it.size();
-
-                // Interpolate the frequency data to match the pixel coordinates
-                right = uint(m_freqMax / (m_freq / 2.f) * (windowSize - 1));
-                dbMap = FFTTools::interpolatePeakPreserving(it, uint(m_innerScopeRect.width()), 0, right, -180);
-
-                for (int i = 0; i < dbMap.size(); ++i) {
-                    float val;
-                    val = dbMap[i];
-                    bool peak = val > m_dBmax;
-
-                    // Normalize dB value to [0 1], 1 corresponding to dbMax dB and 0 to dbMin dB
-                    val = (val - m_dBmax) / (m_dBmax - m_dBmin) + 1.f;
-                    if (val < 0) {
-                        val = 0;
-                    } else if (val > 1) {
-                        val = 1;
-                    }
-                    if (!peak || !m_aHighlightPeaks->isChecked()) {
-                        spectrum.setPixel(leftDist + i, topDist + h - 1 - y, m_colorMap[int(val * 255)]);
-                    } else {
-                        spectrum.setPixel(leftDist + i, topDist + h - 1 - y, AbstractScopeWidget::colHighlightDark.rgba());
-                    }
-                }
-
-                y++;
-                if (y >= topDist + m_innerScopeRect.height()) {
-                    break;
-                }
-                if (!completeRedraw) {
-                    break;
-                }
-            }
+            m_generator.invalidate();
         }
+        // Only the new lines are drawn, unless the size or the parameters (like min/max dB) changed
+        SpectrogramGenerator::Settings settings;
+        settings.size = m_scopeRect.size();
+        settings.rect = m_innerScopeRect.translated(-m_scopeRect.topLeft());
+        settings.dBmin = m_dBmin;
+        settings.dBmax = m_dBmax;
+        settings.maxFrequency = m_freqMax / (m_freq / 2.f);
+        settings.highlightPeaks = m_aHighlightPeaks->isChecked();
+        QImage spectrum = m_generator.render(settings);
 
 #ifdef DEBUG_SPECTROGRAM
-        qCDebug(KDENLIVE_LOG) << "Rendered " << y - topDist << "lines from " << m_fftHistory.size() << " available samples in " << start.elapsed() << " ms"
-                              << (completeRedraw ? "" : " (re-used old image)");
-        uint storedBytes = 0;
-        for (QList<QVector<float>>::iterator it = m_fftHistory.begin(); it != m_fftHistory.end(); ++it) {
-            storedBytes += (*it).size() * sizeof((*it)[0]);
-        }
-        qCDebug(KDENLIVE_LOG) << QString("Total storage used: %1 kB").arg((double)storedBytes / 1000, 0, 'f', 2);
+        qCDebug(KDENLIVE_LOG) << "Rendered spectrogram from " << m_generator.historyCount() << " available samples in " << timer.elapsed() << " ms";
 #endif
 
-        m_fftHistoryImg = spectrum;
-
         emit signalScopeRenderingFinished(uint(timer.elapsed()), 1);
         return spectrum;
     }
@@ -9,7 +9,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #define SPECTROGRAM_H
 
 #include "abstractaudioscopewidget.h"
-#include "lib/audio/fftTools.h"
+#include "spectrogramgenerator.h"
 #include "ui_spectrogram_ui.h"
 
 class Spectrogram_UI;
@@ -18,7 +18,7 @@ class Spectrogram_UI;
     @brief This Spectrogram shows the spectral power distribution of incoming audio samples
     over time. See https://en.wikipedia.org/wiki/Spectrogram.
 
-    The Spectrogram makes use of two caches:
+    The Spectrogram makes use of two caches, see SpectrogramGenerator:
     * A cached image where only the most recent line needs to be appended instead of
       having to recalculate the whole image. A typical speedup factor is 10x.
     * A FFT cache storing a history of previous spectral power distributions (i.e.
@@ -55,15 +55,12 @@ protected:
 
 private:
     Ui::Spectrogram_UI *m_ui;
-    FFTTools m_fftTools;
+    SpectrogramGenerator m_generator;
     QAction *m_aResetHz;
     QAction *m_aGrid;
     QAction *m_aTrackMouse;
     QAction *m_aHighlightPeaks;
 
-    QList<QVector<float>> m_fftHistory;
-    QImage m_fftHistoryImg;
-
     int m_dBmin{-70};
     int m_dBmax{0};
 
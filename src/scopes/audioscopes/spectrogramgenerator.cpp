@@ -0,0 +1,136 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "spectrogramgenerator.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool SpectrogramGenerator::Settings::operator==(const Settings &other) const
+{
+    return size == other.size && rect == other.rect && dBmin == other.dBmin && dBmax == other.dBmax && qFuzzyCompare(1 + maxFrequency, 1 + other.maxFrequency) &&
+           highlightPeaks == other.highlightPeaks;
+}
+
+bool SpectrogramGenerator::Settings::operator!=(const Settings &other) const
+{
+    return !(*this == other);
+}
+
+SpectrogramGenerator::SpectrogramGenerator(int historySize)
+    : m_history(size_t(qMax(1, historySize)))
+{
+    std::fill(m_colorMap, m_colorMap + 256, qRgb(0, 0, 0));
+}
+
+void SpectrogramGenerator::setColorMap(const QRgb *colorMap, QRgb highlightColor)
+{
+    std::copy(colorMap, colorMap + 256, m_colorMap);
+    m_highlightColor = highlightColor;
+    m_valid = false;
+}
+
+void SpectrogramGenerator::addFrame(const audioShortVector &audioFrame, uint numChannels, FFTTools::WindowType windowType, uint windowSize)
+{
+    if (numChannels == 0 || windowSize < 2 || (windowSize & 1) == 1) {
+        return;
+    }
+    // Reuse the slot of the oldest spectrum, its memory is kept as long as the window size does not grow
+    const int historySize = int(m_history.size());
+    m_newest = (m_newest + 1) % historySize;
+    std::vector<float> &slot = m_history[size_t(m_newest)];
+    slot.resize(windowSize / 2);
+    m_fftTools.fftNormalized(audioFrame, 0, numChannels, slot.data(), windowType, windowSize, 0);
+    m_count = qMin(m_count + 1, historySize);
+    m_unpainted = qMin(m_unpainted + 1, historySize);
+}
+
+int SpectrogramGenerator::historyCount() const
+{
+    return m_count;
+}
+
+const std::vector<float> &SpectrogramGenerator::spectrum(int age) const
+{
+    Q_ASSERT(age >= 0 && age < m_count);
+    const int historySize = int(m_history.size());
+    return m_history[size_t((m_newest - age + historySize) % historySize)];
+}
+
+void SpectrogramGenerator::invalidate()
+{
+    m_valid = false;
+}
+
+QImage SpectrogramGenerator::render(const Settings &settings)
+{
+    const bool complete = !m_valid || settings != m_settings || m_images[m_current].size() != settings.size;
+    if (!complete && m_unpainted == 0) {
+        // Nothing changed since the last render
+        return m_images[m_current];
+    }
+    const int target = 1 - m_current;
+    QImage &image = m_images[target];
+    if (image.size() != settings.size || image.format() != QImage::Format_ARGB32) {
+        image = QImage(settings.size, QImage::Format_ARGB32);
+        m_cleared[target] = false;
+    }
+    if (complete) {
+        // The drawing area may have moved, the previous buffer has to be cleared again
+        m_cleared[m_current] = false;
+    }
+    if (complete || !m_cleared[target]) {
+        image.fill(qRgba(0, 0, 0, 0));
+        m_cleared[target] = true;
+    }
+
+    const QRect area = settings.rect.intersected(QRect(QPoint(0, 0), settings.size));
+    if (area.width() > 1 && area.height() > 0 && !image.isNull()) {
+        const int offset = area.left() * int(sizeof(QRgb));
+        int lines;
+        if (complete) {
+            lines = qMin(m_count, area.height());
+        } else {
+            // Scroll the previous image up by the number of new spectra
+            lines = qMin(m_unpainted, area.height());
+            const QImage &previous = m_images[m_current];
+            const size_t bytes = size_t(area.width()) * sizeof(QRgb);
+            for (int y = area.top(); y <= area.bottom() - lines; ++y) {
+                memcpy(image.scanLine(y) + offset, previous.constScanLine(y + lines) + offset, bytes);
+            }
+        }
+        for (int age = 0; age < lines; ++age) {
+            paintLine(reinterpret_cast<QRgb *>(image.scanLine(area.bottom() - age) + offset), spectrum(age), area.width(), settings);
+        }
+    }
+
+    m_current = target;
+    m_settings = settings;
+    m_valid = true;
+    m_unpainted = 0;
+    return image;
+}
+
+void SpectrogramGenerator::paintLine(QRgb *line, const std::vector<float> &spectrum, int width, const Settings &settings)
+{
+    m_interpolated.resize(size_t(width));
+    // Interpolate the frequency data to match the pixel coordinates
+    const uint right = uint(settings.maxFrequency * (spectrum.size() - 1));
+    FFTTools::interpolatePeakPreserving(spectrum.data(), int(spectrum.size()), m_interpolated.data(), uint(width), 0, right, -180);
+
+    const float range = settings.dBmax > settings.dBmin ? float(settings.dBmax - settings.dBmin) : 1.f;
+    for (int i = 0; i < width; ++i) {
+        const float dB = m_interpolated[size_t(i)];
+        if (dB > settings.dBmax && settings.highlightPeaks) {
+            line[i] = m_highlightColor;
+            continue;
+        }
+        // Normalize dB value to [0 1], 1 corresponding to dbMax dB and 0 to dbMin dB
+        const float val = qBound(0.f, (dB - settings.dBmax) / range + 1.f, 1.f);
+        line[i] = m_colorMap[int(val * 255)];
+    }
+}
@@ -0,0 +1,85 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef SPECTROGRAMGENERATOR_H
+#define SPECTROGRAMGENERATOR_H
+
+#include "definitions.h"
+#include "lib/audio/fftTools.h"
+
+#include <QImage>
+#include <QRect>
+#include <QRgb>
+#include <QSize>
+#include <vector>
+
+/** @class SpectrogramGenerator
+    @brief Computes and draws the spectrogram history, independently from the widget.
+
+    Spectra are stored in a ring buffer of preallocated slots, so that adding a frame does not allocate once the
+    history is full. The image is kept between frames: new spectra scroll it up and only their lines are painted.
+    The whole image is only painted again when the display settings change.
+*/
+class SpectrogramGenerator
+{
+public:
+    struct Settings
+    {
+        /** @brief Size of the rendered image */
+        QSize size;
+        /** @brief Area of the image where the spectrogram is drawn, the rest is transparent */
+        QRect rect;
+        int dBmin{-70};
+        int dBmax{0};
+        /** @brief Displayed part of the spectrum, 1 to display up to the Nyquist frequency */
+        float maxFrequency{1};
+        bool highlightPeaks{true};
+
+        bool operator==(const Settings &other) const;
+        bool operator!=(const Settings &other) const;
+    };
+
+    explicit SpectrogramGenerator(int historySize);
+
+    /** @brief Set the 256 colors used from the minimum to the maximum dB value, and the color of values above the maximum */
+    void setColorMap(const QRgb *colorMap, QRgb highlightColor);
+
+    /** @brief Computes the spectrum of the first channel of the frame and appends it to the history */
+    void addFrame(const audioShortVector &audioFrame, uint numChannels, FFTTools::WindowType windowType, uint windowSize);
+    int historyCount() const;
+    /** @brief Returns a spectrum of the history, 0 being the most recent one */
+    const std::vector<float> &spectrum(int age) const;
+
+    /** @brief Paint the whole image on next render */
+    void invalidate();
+    /** @brief Returns the spectrogram image, the most recent spectrum being at the bottom of the drawing area */
+    QImage render(const Settings &settings);
+
+private:
+    void paintLine(QRgb *line, const std::vector<float> &spectrum, int width, const Settings &settings);
+
+    FFTTools m_fftTools;
+    std::vector<std::vector<float>> m_history;
+    int m_newest{-1};
+    int m_count{0};
+    // Spectra added since the last render
+    int m_unpainted{0};
+    std::vector<float> m_interpolated;
+
+    // The rendered image is shared with the widget, the next one is drawn in the other buffer to avoid a copy
+    QImage m_images[2];
+    // The buffer is transparent outside of the drawing area
+    bool m_cleared[2]{false, false};
+    int m_current{0};
+    Settings m_settings;
+    bool m_valid{false};
+
+    QRgb m_colorMap[256];
+    QRgb m_highlightColor{0};
+};
+
+#endif // SPECTROGRAMGENERATOR_H
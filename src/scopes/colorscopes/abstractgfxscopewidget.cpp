@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "abstractgfxscopewidget.h"
 #include "monitor/monitormanager.h"
+#include "scopestatistics.h"
 
 #include <QMouseEvent>
 
@@ -29,6 +30,27 @@ QImage AbstractGfxScopeWidget::renderScope(uint accelerationFactor)
     return renderGfxScope(accelerationFactor, m_scopeImage);
 }
 
+void AbstractGfxScopeWidget::setStatistics(std::shared_ptr<ScopeStatistics> statistics)
+{
+    m_statistics = std::move(statistics);
+}
+
+void AbstractGfxScopeWidget::releaseStatistics()
+{
+    if (m_statistics) {
+        m_statistics->removeRequest(widgetName());
+    }
+}
+
+std::shared_ptr<const ScopeAccumulation> AbstractGfxScopeWidget::frameStatistics(const QImage &frame, const ScopeRequest &request)
+{
+    if (!m_statistics) {
+        return ScopeStatistics::compute(frame, request);
+    }
+    m_statistics->setRequest(widgetName(), request);
+    return m_statistics->statistics(frame, request);
+}
+
 void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
 {
     AbstractScopeWidget::mouseReleaseEvent(event);
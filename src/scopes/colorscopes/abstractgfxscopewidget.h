@@ -10,9 +10,14 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QString>
 #include <QWidget>
+#include <memory>
 
 #include "../abstractscopewidget.h"
 
+class ScopeStatistics;
+struct ScopeAccumulation;
+struct ScopeRequest;
+
 /**
 * @brief Abstract class for scopes analyzing image frames.
 */
@@ -24,6 +29,11 @@ public:
     explicit AbstractGfxScopeWidget(bool trackMouse = false, QWidget *parent = nullptr);
     ~AbstractGfxScopeWidget() override; // Must be virtual because of inheritance, to avoid memory leaks
 
+    /** @brief Share the frame accumulations with the other color scopes */
+    void setStatistics(std::shared_ptr<ScopeStatistics> statistics);
+    /** @brief The scope will not render the next frames, its accumulations are not needed anymore */
+    void releaseStatistics();
+
 protected:
     ///// Variables /////
 
@@ -34,11 +44,16 @@ protected:
 
     QImage renderScope(uint accelerationFactor) override;
 
+    /** @brief Returns the accumulations of @param frame. If the statistics are shared, they are
+     *  computed once per frame for all visible color scopes. */
+    std::shared_ptr<const ScopeAccumulation> frameStatistics(const QImage &frame, const ScopeRequest &request);
+
     void mouseReleaseEvent(QMouseEvent *) override;
 
 private:
     QImage m_scopeImage;
     QMutex m_mutex;
+    std::shared_ptr<ScopeStatistics> m_statistics;
 
 public slots:
     /** @brief Must be called when the active monitor has shown a new frame.
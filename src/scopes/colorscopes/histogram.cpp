@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "histogram.h"
 #include "histogramgenerator.h"
+#include "scopestatistics.h"
 #include <QElapsedTimer>
 
 #include "klocalizedstring.h"
@@ -138,7 +139,12 @@ QImage Histogram::renderGfxScope(uint accelFactor, const QImage &qimage)
 
     ITURec rec = m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709;
 
-    QImage histogram = m_histogramGenerator->calculateHistogram(m_scopeRect.size(), qimage, componentFlags, rec, m_aUnscaled->isChecked(), m_ui->rbLogarithmic->isChecked(), accelFactor);
+    ScopeRequest request;
+    request.accumulations = ScopeRequest::Histogram;
+    request.accelFactor = accelFactor;
+    request.histogramRec = rec;
+    QImage histogram = m_histogramGenerator->drawHistogram(m_scopeRect.size(), *frameStatistics(qimage, request), componentFlags, m_aUnscaled->isChecked(),
+                                                           m_ui->rbLogarithmic->isChecked());
 
     emit signalScopeRenderingFinished(uint(timer.elapsed()), accelFactor);
     return histogram;
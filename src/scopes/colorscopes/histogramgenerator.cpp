@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "histogramgenerator.h"
 #include "colorconstants.h"
+#include "scopestatistics.h"
 
 #include "klocalizedstring.h"
 #include <QDebug>
@@ -24,6 +25,19 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || image.width() <= 0 || image.height() <= 0) {
         return QImage();
     }
+    ScopeRequest request;
+    request.accumulations = ScopeRequest::Histogram;
+    request.accelFactor = accelFactor;
+    request.histogramRec = rec;
+    return drawHistogram(paradeSize, *ScopeStatistics::compute(image, request), components, unscaled, logScale);
+}
+
+QImage HistogramGenerator::drawHistogram(const QSize &paradeSize, const ScopeAccumulation &statistics, const int &components, bool unscaled,
+                                         bool logScale) const
+{
+    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || statistics.red.size() != 256 || statistics.luma.size() != 256) {
+        return QImage();
+    }
 
     bool drawY = (components & HistogramGenerator::ComponentY) != 0;
     bool drawR = (components & HistogramGenerator::ComponentR) != 0;
@@ -32,43 +46,20 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     bool drawSum = (components & HistogramGenerator::ComponentSum) != 0;
 
     int r[256], g[256], b[256], y[256], s[766];
-    // Initialize the values to zero
-    std::fill(r, r + 256, 0);
-    std::fill(g, g + 256, 0);
-    std::fill(b, b + 256, 0);
-    std::fill(y, y + 256, 0);
+    std::copy(statistics.red.cbegin(), statistics.red.cend(), r);
+    std::copy(statistics.green.cbegin(), statistics.green.cend(), g);
+    std::copy(statistics.blue.cbegin(), statistics.blue.cend(), b);
+    std::copy(statistics.luma.cbegin(), statistics.luma.cend(), y);
     std::fill(s, s + 766, 0);
+    if (drawSum) {
+        for (int i = 0; i < 256; ++i) {
+            s[i] = r[i] + g[i] + b[i];
+        }
+    }
 
     const int ww = paradeSize.width();
     const int wh = paradeSize.height();
 
-    // Read the stats from the input image
-    for (int Y = 0; Y < image.height(); ++Y) {
-        for (int X = 0; X < image.width(); X += accelFactor) {
-
-            QRgb col = image.pixel(X, Y);
-            r[qRed(col)]++;
-            g[qGreen(col)]++;
-            b[qBlue(col)]++;
-
-            if (drawY) {
-                // Use if branch to avoid expensive multiplication if Y disabled
-                if (rec == ITURec::Rec_601) {
-                    y[int(REC_601_R * qRed(col) + REC_601_G * qGreen(col) + REC_601_B * qBlue(col))]++;
-                } else {
-                    y[int(REC_709_R * qRed(col) + REC_709_G * qGreen(col) + REC_709_B * qBlue(col))]++;
-                }
-            }
-
-            if (drawSum) {
-                // Use an if branch here because the sum takes more operations than rgb
-                s[qRed(col)]++;
-                s[qGreen(col)]++;
-                s[qBlue(col)]++;
-            }
-        }
-    }
-
     const int nParts = (drawY ? 1 : 0) + (drawR ? 1 : 0) + (drawG ? 1 : 0) + (drawB ? 1 : 0) + (drawSum ? 1 : 0);
     if (nParts == 0) {
         // Nothing to draw
@@ -82,7 +73,7 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     const int partH = (wh - nParts * d) / nParts;
 
     // Total number of bytes of the image
-    const int byteCount = int(image.sizeInBytes());
+    const int byteCount = int(statistics.byteCount);
 
     // Factor for scaling the measured value to the histogram.
     // This factor is used for linear scaling and does not depend
@@ -16,6 +16,7 @@ class QImage;
 class QPainter;
 class QRect;
 class QSize;
+struct ScopeAccumulation;
 
 class HistogramGenerator : public QObject
 {
@@ -37,6 +38,8 @@ public:
     QImage calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components, const ITURec rec, bool unscaled,
                               bool logScale,
                               uint accelFactor = 1) const;
+    /** @brief Draws the histogram from the Histogram accumulation of a frame, see ScopeStatistics */
+    QImage drawHistogram(const QSize &paradeSize, const ScopeAccumulation &statistics, const int &components, bool unscaled, bool logScale) const;
 
     /**
      * Draws the histogram of a single component.
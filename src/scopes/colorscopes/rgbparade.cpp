@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "rgbparade.h"
 #include "rgbparadegenerator.h"
+#include "scopestatistics.h"
 #include <QDebug>
 #include <QElapsedTimer>
 #include <QPainter>
@@ -139,8 +140,15 @@ QImage RGBParade::renderGfxScope(uint accelerationFactor, const QImage &qimage)
     timer.start();
 
     int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
-    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), qimage, RGBParadeGenerator::PaintMode(paintmode), m_aAxis->isChecked(),
-                                                             m_aGradRef->isChecked(), accelerationFactor);
+    ScopeRequest request;
+    request.accumulations = ScopeRequest::Parade;
+    request.accelFactor = accelerationFactor;
+    request.paradeColumns = RGBParadeGenerator::paradeColumns(m_scopeRect.size());
+    QImage parade;
+    if (request.paradeColumns > 0) {
+        parade = m_rgbParadeGenerator->drawRGBParade(m_scopeRect.size(), *frameStatistics(qimage, request), RGBParadeGenerator::PaintMode(paintmode),
+                                                         m_aAxis->isChecked(), m_aGradRef->isChecked());
+    }
     emit signalScopeRenderingFinished(uint(timer.elapsed()), accelerationFactor);
     return parade;
 }
@@ -6,10 +6,12 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "rgbparadegenerator.h"
+#include "scopestatistics.h"
 #include "klocalizedstring.h"
 #include <QColor>
 #include <QDebug>
 #include <QPainter>
+#include <algorithm>
 
 #define CHOP255(a) ((255) < (a) ? (255) : int(a))
 #define CHOP1255(a) ((a) < (1) ? (1) : ((a) > (255) ? (255) : (a)))
@@ -20,22 +22,36 @@ const QColor RGBParadeGenerator::colSoft(150, 150, 150, 255);
 
 const uchar RGBParadeGenerator::distRight(40);
 const uchar RGBParadeGenerator::distBottom(40);
-
-struct StructRGB
-{
-    uint r;
-    uint g;
-    uint b;
-};
+const uchar RGBParadeGenerator::paradeOffset(10);
 
 RGBParadeGenerator::RGBParadeGenerator() = default;
 
+int RGBParadeGenerator::paradeColumns(const QSize &paradeSize)
+{
+    return (paradeSize.width() - 2 * paradeOffset - distRight) / 3;
+}
+
 QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
                                               bool drawGradientRef, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
 
-    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (paradeColumns(paradeSize) <= 0 || paradeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+        return QImage();
+    }
+    ScopeRequest request;
+    request.accumulations = ScopeRequest::Parade;
+    request.accelFactor = accelFactor;
+    request.paradeColumns = paradeColumns(paradeSize);
+    return drawRGBParade(paradeSize, *ScopeStatistics::compute(image, request), paintMode, drawAxis, drawGradientRef);
+}
+
+QImage RGBParadeGenerator::drawRGBParade(const QSize &paradeSize, const ScopeAccumulation &statistics, const RGBParadeGenerator::PaintMode paintMode,
+                                         bool drawAxis, bool drawGradientRef)
+{
+    const int columns = paradeColumns(paradeSize);
+    if (columns <= 0 || paradeSize.height() <= 0 || statistics.request.paradeColumns != columns ||
+        statistics.paradeRed.size() != 256 * size_t(columns)) {
         return QImage();
     }
     QImage parade(paradeSize, QImage::Format_ARGB32);
@@ -50,16 +66,22 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     const uint ww = uint(paradeSize.width());
     const uint wh = uint(paradeSize.height());
-    const uint iw = uint(image.bytesPerLine());
-    const uint ih = uint(image.height());
-    const uint byteCount = iw * ih; // Note that 1 px = 4 B
+    const uint byteCount = uint(statistics.byteCount); // Note that 1 px = 4 B
+    const uint accelFactor = statistics.request.accelFactor;
 
-    const uchar offset = 10;
-    const uint partW = (ww - 2 * offset - distRight) / 3;
+    const uchar offset = paradeOffset;
+    const uint partW = uint(columns);
     const uint partH = wh - distBottom;
 
     // Statistics
-    uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0;
+    const auto firstUsed = [](const std::vector<uint> &bins) {
+        return uchar(std::find_if(bins.cbegin(), bins.cend(), [](uint count) { return count > 0; }) - bins.cbegin());
+    };
+    const auto lastUsed = [](const std::vector<uint> &bins) {
+        return uchar(255 - (std::find_if(bins.crbegin(), bins.crend(), [](uint count) { return count > 0; }) - bins.crbegin()));
+    };
+    const uchar minR = firstUsed(statistics.red), minG = firstUsed(statistics.green), minB = firstUsed(statistics.blue);
+    const uchar maxR = lastUsed(statistics.red), maxG = lastUsed(statistics.green), maxB = lastUsed(statistics.blue);
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
@@ -70,70 +92,20 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
     QImage unscaled(int(ww) - distRight, 256, QImage::Format_ARGB32);
     unscaled.fill(qRgba(0, 0, 0, 0));
 
-    const float wPrediv = float(partW - 1) / (iw - 1);
-
-    std::vector<std::vector<StructRGB>> paradeVals(partW, std::vector<StructRGB>(256, {0, 0, 0}));
-
-    const uchar *bits = image.bits();
-    const uint stepsize = uint(uint(image.depth() / 8) * accelFactor);
-
-    for (uint i = 0, x = 0; i < byteCount; i += stepsize) {
-        auto *col = reinterpret_cast<const QRgb *>(bits);
-        auto r = uchar(qRed(*col));
-        auto g = uchar(qGreen(*col));
-        auto b = uchar(qBlue(*col));
-
-        double dx = x * double(wPrediv);
-
-        paradeVals[size_t(dx)][r].r++;
-        paradeVals[size_t(dx)][g].g++;
-        paradeVals[size_t(dx)][b].b++;
-
-        if (r < minR) {
-            minR = r;
-        }
-        if (g < minG) {
-            minG = g;
-        }
-        if (b < minB) {
-            minB = b;
-        }
-        if (r > maxR) {
-            maxR = r;
-        }
-        if (g > maxG) {
-            maxG = g;
-        }
-        if (b > maxB) {
-            maxB = b;
-        }
-
-        bits += stepsize;
-        x += stepsize;
-        x %= iw; // Modulo image width, to represent the current x position in the image
-    }
-
     const int offset1 = int(partW + offset);
     const int offset2 = int(2 * partW + 2 * offset);
-    switch (paintMode) {
-    case PaintMode_RGB:
+    const QRgb red = paintMode == PaintMode_RGB ? qRgb(255, 10, 10) : qRgb(255, 255, 255);
+    const QRgb green = paintMode == PaintMode_RGB ? qRgb(10, 255, 10) : qRgb(255, 255, 255);
+    const QRgb blue = paintMode == PaintMode_RGB ? qRgb(10, 10, 255) : qRgb(255, 255, 255);
+    const auto alpha = [gain](QRgb color, uint count) { return (color & RGB_MASK) | (uint(CHOP255(gain * float(count))) << 24); };
+    for (int j = 0; j < 256; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(unscaled.scanLine(j));
+        const size_t row = size_t(j) * partW;
         for (int i = 0; i < int(partW); ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i,           j, qRgba(255, 10, 10, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].r))));
-                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].g))));
-                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].b))));
-            }
-        }
-        break;
-    default:
-        for (int i = 0; i < int(partW); ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i,           j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].r))));
-                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].g))));
-                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].b))));
-            }
+            line[i] = alpha(red, statistics.paradeRed[row + size_t(i)]);
+            line[i + offset1] = alpha(green, statistics.paradeGreen[row + size_t(i)]);
+            line[i + offset2] = alpha(blue, statistics.paradeBlue[row + size_t(i)]);
         }
-        break;
     }
 
     // Scale the image to the target height. Scaling is not accomplished before because
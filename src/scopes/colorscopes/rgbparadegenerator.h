@@ -13,6 +13,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 class QColor;
 class QImage;
 class QSize;
+struct ScopeAccumulation;
+
 class RGBParadeGenerator : public QObject
 {
     Q_OBJECT
@@ -22,6 +24,11 @@ public:
     RGBParadeGenerator();
     QImage calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis, bool drawGradientRef,
                               uint accelFactor = 1);
+    /** @brief Draws the parade from the Parade accumulation of a frame, see ScopeStatistics */
+    static QImage drawRGBParade(const QSize &paradeSize, const ScopeAccumulation &statistics, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
+                                bool drawGradientRef);
+    /** @brief Number of accumulation columns of each component for a parade of the given size */
+    static int paradeColumns(const QSize &paradeSize);
 
     static const QColor colHighlight;
     static const QColor colLight;
@@ -29,6 +36,7 @@ public:
 
     static const uchar distRight;
     static const uchar distBottom;
+    static const uchar paradeOffset;
 };
 
 #endif // RGBPARADEGENERATOR_H
@@ -0,0 +1,324 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "scopestatistics.h"
+
+#include <QImage>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+// Luminance factors in 16.16 fixed point, so that the luma of a row can be computed with integer arithmetic
+struct LumaFactors
+{
+    uint r, g, b;
+};
+constexpr LumaFactors rec601Factors{uint(REC_601_R * 65536 + .5f), uint(REC_601_G * 65536 + .5f), uint(REC_601_B * 65536 + .5f)};
+constexpr LumaFactors rec709Factors{uint(REC_709_R * 65536 + .5f), uint(REC_709_G * 65536 + .5f), uint(REC_709_B * 65536 + .5f)};
+// Rows are processed by stripes of at least this height, each stripe filling its own accumulations
+const int minStripeHeight = 64;
+const size_t bins = 256;
+
+const LumaFactors &lumaFactors(ITURec rec)
+{
+    return rec == ITURec::Rec_601 ? rec601Factors : rec709Factors;
+}
+
+void addBins(std::vector<uint> &target, const std::vector<uint> &source)
+{
+    for (size_t i = 0; i < target.size(); ++i) {
+        target[i] += source[i];
+    }
+}
+} // namespace
+
+void ScopeRequest::merge(const ScopeRequest &other)
+{
+    accumulations |= other.accumulations;
+    accelFactor = std::min(accelFactor, other.accelFactor);
+    if (other.accumulations & Histogram) {
+        histogramRec = other.histogramRec;
+    }
+    if (other.accumulations & Parade) {
+        paradeColumns = other.paradeColumns;
+    }
+    if (other.accumulations & Waveform) {
+        waveformSize = other.waveformSize;
+        waveformRec = other.waveformRec;
+    }
+    if (other.accumulations & Vectorscope) {
+        vectorscopeSize = other.vectorscopeSize;
+        vectorscopeGain = other.vectorscopeGain;
+        vectorscopeColorSpace = other.vectorscopeColorSpace;
+    }
+}
+
+bool ScopeRequest::covers(const ScopeRequest &other) const
+{
+    if ((accumulations & other.accumulations) != other.accumulations || accelFactor > other.accelFactor) {
+        return false;
+    }
+    if ((other.accumulations & Histogram) && histogramRec != other.histogramRec) {
+        return false;
+    }
+    if ((other.accumulations & Parade) && paradeColumns != other.paradeColumns) {
+        return false;
+    }
+    if ((other.accumulations & Waveform) && (waveformSize != other.waveformSize || waveformRec != other.waveformRec)) {
+        return false;
+    }
+    if ((other.accumulations & Vectorscope) &&
+        (vectorscopeSize != other.vectorscopeSize || !qFuzzyCompare(vectorscopeGain, other.vectorscopeGain) || vectorscopeColorSpace != other.vectorscopeColorSpace)) {
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const ScopeAccumulation> ScopeStatistics::compute(const QImage &frame, const ScopeRequest &request)
+{
+    // The pass reads the pixels as QRgb
+    const QImage image = frame.depth() == 32 ? frame : frame.convertToFormat(QImage::Format_RGB32);
+    auto result = std::make_shared<ScopeAccumulation>();
+    result->request = request;
+    result->request.accelFactor = std::max(1u, request.accelFactor);
+    result->byteCount = qint64(image.bytesPerLine()) * image.height();
+    result->depth = image.depth();
+    const int iw = image.width();
+    const int ih = image.height();
+    if (iw <= 0 || ih <= 0) {
+        return result;
+    }
+    const int accelFactor = int(result->request.accelFactor);
+    const bool histogram = (request.accumulations & ScopeRequest::Histogram) != 0;
+    const bool parade = (request.accumulations & ScopeRequest::Parade) != 0 && request.paradeColumns > 0;
+    const bool components = histogram || parade;
+    const bool waveform = (request.accumulations & ScopeRequest::Waveform) != 0 && !request.waveformSize.isEmpty();
+    const bool vectorscope = (request.accumulations & ScopeRequest::Vectorscope) != 0 && !request.vectorscopeSize.isEmpty();
+    const int bpp = image.depth() / 8;
+
+    // Lookup tables shared by all stripes
+    const LumaFactors histogramFactors = lumaFactors(request.histogramRec);
+    const LumaFactors waveformFactors = lumaFactors(request.waveformRec);
+    const size_t paradeColumns = parade ? size_t(request.paradeColumns) : 0;
+    std::vector<uint> paradeX;
+    if (parade) {
+        paradeX.resize(size_t(iw));
+        const float wPrediv = iw > 1 ? float(paradeColumns - 1) / float(iw - 1) : 0.f;
+        for (int x = 0; x < iw; ++x) {
+            paradeX[size_t(x)] = uint(x * wPrediv);
+        }
+    }
+    const uint ww = waveform ? uint(request.waveformSize.width()) : 0;
+    const uint wh = waveform ? uint(request.waveformSize.height()) : 0;
+    // Waveform rows are looked up from the luma in 8.8 fixed point
+    const uint maxLuma = (255u << 16) >> 8;
+    std::vector<uint> waveformX;
+    std::vector<uint> lumaRows;
+    if (waveform) {
+        // Subtract 1 from sizes because we start counting from 0.
+        // Not doing it would result in attempts to paint outside of the image.
+        lumaRows.resize(maxLuma + 1);
+        for (uint l = 0; l <= maxLuma; ++l) {
+            lumaRows[l] = uint(double(l) * (wh - 1) / maxLuma) * ww;
+        }
+        waveformX.resize(size_t(iw));
+        const float wPrediv = iw > 1 ? (ww - 1) / float(iw - 1) : 0.f;
+        for (int x = 0; x < iw; ++x) {
+            waveformX[size_t(x)] = uint(x * wPrediv);
+        }
+    }
+    // The vectorscope position of a pixel is the sum of one term per component, see VectorscopeGenerator::mapToCircle
+    const int cw = vectorscope ? std::min(request.vectorscopeSize.width(), request.vectorscopeSize.height()) : 0;
+    std::vector<double> vectorscopeX;
+    std::vector<double> vectorscopeY;
+    double centerX = 0;
+    double centerY = 0;
+    if (vectorscope) {
+        double uFactors[3], vFactors[3];
+        VectorscopeGenerator::chromaFactors(request.vectorscopeColorSpace, uFactors, vFactors);
+        const double gain = VectorscopeGenerator::scaling * double(request.vectorscopeGain);
+        centerX = (request.vectorscopeSize.width() - 1) / 2.;
+        centerY = (request.vectorscopeSize.height() - 1) / 2.;
+        vectorscopeX.resize(3 * bins);
+        vectorscopeY.resize(3 * bins);
+        for (size_t c = 0; c < 3; ++c) {
+            for (size_t v = 0; v < bins; ++v) {
+                vectorscopeX[c * bins + v] = centerX * gain * uFactors[c] * double(v);
+                vectorscopeY[c * bins + v] = -centerY * gain * vFactors[c] * double(v);
+            }
+        }
+    }
+
+    // Split the processed rows in stripes, each one accumulating on its own
+    const int rows = (ih + accelFactor - 1) / accelFactor;
+    const int stripeCount = qBound(1, rows / minStripeHeight, QThread::idealThreadCount());
+    std::vector<ScopeAccumulation> partials(size_t(stripeCount));
+    QVector<int> stripes(stripeCount);
+    std::iota(stripes.begin(), stripes.end(), 0);
+    QtConcurrent::blockingMap(stripes, [&](const int &stripe) {
+        ScopeAccumulation &partial = partials[size_t(stripe)];
+        if (components) {
+            partial.red.assign(bins, 0);
+            partial.green.assign(bins, 0);
+            partial.blue.assign(bins, 0);
+        }
+        if (histogram) {
+            partial.luma.assign(bins, 0);
+        }
+        if (parade) {
+            partial.paradeRed.assign(bins * paradeColumns, 0);
+            partial.paradeGreen.assign(bins * paradeColumns, 0);
+            partial.paradeBlue.assign(bins * paradeColumns, 0);
+        }
+        if (waveform) {
+            partial.waveform.assign(size_t(ww) * wh, 0);
+        }
+        if (vectorscope) {
+            partial.vectorscope.assign(size_t(cw) * size_t(cw), 0);
+            partial.vectorscopeColors.assign(size_t(cw) * size_t(cw), 0);
+        }
+        // The row is unpacked once, each accumulation then reads it from the cache
+        std::vector<QRgb> pixels(size_t(iw));
+        std::vector<uchar> red(size_t(iw)), green(size_t(iw)), blue(size_t(iw));
+        std::vector<uint> luma(size_t(iw));
+        const int firstRow = rows * stripe / stripeCount;
+        const int lastRow = rows * (stripe + 1) / stripeCount;
+        for (int row = firstRow; row < lastRow; ++row) {
+            const uchar *bits = image.constScanLine(row * accelFactor);
+            for (int x = 0; x < iw; ++x) {
+                const QRgb col = *reinterpret_cast<const QRgb *>(bits + x * bpp);
+                pixels[size_t(x)] = col;
+                red[size_t(x)] = uchar(qRed(col));
+                green[size_t(x)] = uchar(qGreen(col));
+                blue[size_t(x)] = uchar(qBlue(col));
+            }
+            if (components) {
+                for (int x = 0; x < iw; ++x) {
+                    partial.red[red[size_t(x)]]++;
+                    partial.green[green[size_t(x)]]++;
+                    partial.blue[blue[size_t(x)]]++;
+                }
+            }
+            if (histogram) {
+                // Luma pass, written without branches so that it gets vectorized
+                for (int x = 0; x < iw; ++x) {
+                    luma[size_t(x)] = histogramFactors.r * red[size_t(x)] + histogramFactors.g * green[size_t(x)] + histogramFactors.b * blue[size_t(x)];
+                }
+                for (int x = 0; x < iw; ++x) {
+                    partial.luma[std::min(luma[size_t(x)] >> 16, 255u)]++;
+                }
+            }
+            if (parade) {
+                for (int x = 0; x < iw; ++x) {
+                    const size_t column = paradeX[size_t(x)];
+                    partial.paradeRed[red[size_t(x)] * paradeColumns + column]++;
+                    partial.paradeGreen[green[size_t(x)] * paradeColumns + column]++;
+                    partial.paradeBlue[blue[size_t(x)] * paradeColumns + column]++;
+                }
+            }
+            if (waveform) {
+                for (int x = 0; x < iw; ++x) {
+                    luma[size_t(x)] = waveformFactors.r * red[size_t(x)] + waveformFactors.g * green[size_t(x)] + waveformFactors.b * blue[size_t(x)];
+                }
+                for (int x = 0; x < iw; ++x) {
+                    partial.waveform[lumaRows[std::min(luma[size_t(x)] >> 8, maxLuma)] + waveformX[size_t(x)]]++;
+                }
+            }
+            if (vectorscope) {
+                for (int x = 0; x < iw; ++x) {
+                    const int px = int(centerX + vectorscopeX[red[size_t(x)]] + vectorscopeX[bins + green[size_t(x)]] + vectorscopeX[2 * bins + blue[size_t(x)]]);
+                    const int py = int(centerY + vectorscopeY[red[size_t(x)]] + vectorscopeY[bins + green[size_t(x)]] + vectorscopeY[2 * bins + blue[size_t(x)]]);
+                    if (px < 0 || px >= cw || py < 0 || py >= cw) {
+                        // Point lies outside (because of scaling), don't plot it
+                        continue;
+                    }
+                    const size_t index = size_t(py) * size_t(cw) + size_t(px);
+                    partial.vectorscope[index]++;
+                    partial.vectorscopeColors[index] = pixels[size_t(x)];
+                }
+            }
+            partial.samples += iw;
+        }
+    });
+
+    // Merge the stripes in order, so that the last mapped vectorscope colors come from the last stripe
+    ScopeAccumulation &merged = partials.front();
+    for (size_t i = 1; i < partials.size(); ++i) {
+        const ScopeAccumulation &partial = partials[i];
+        merged.samples += partial.samples;
+        if (components) {
+            addBins(merged.red, partial.red);
+            addBins(merged.green, partial.green);
+            addBins(merged.blue, partial.blue);
+        }
+        if (histogram) {
+            addBins(merged.luma, partial.luma);
+        }
+        if (parade) {
+            addBins(merged.paradeRed, partial.paradeRed);
+            addBins(merged.paradeGreen, partial.paradeGreen);
+            addBins(merged.paradeBlue, partial.paradeBlue);
+        }
+        if (waveform) {
+            addBins(merged.waveform, partial.waveform);
+        }
+        if (vectorscope) {
+            for (size_t j = 0; j < merged.vectorscope.size(); ++j) {
+                if (partial.vectorscope[j] > 0) {
+                    merged.vectorscope[j] += partial.vectorscope[j];
+                    merged.vectorscopeColors[j] = partial.vectorscopeColors[j];
+                }
+            }
+        }
+    }
+    result->samples = merged.samples;
+    result->red = std::move(merged.red);
+    result->green = std::move(merged.green);
+    result->blue = std::move(merged.blue);
+    result->luma = std::move(merged.luma);
+    result->paradeRed = std::move(merged.paradeRed);
+    result->paradeGreen = std::move(merged.paradeGreen);
+    result->paradeBlue = std::move(merged.paradeBlue);
+    result->waveform = std::move(merged.waveform);
+    result->vectorscopeWidth = cw;
+    result->vectorscope = std::move(merged.vectorscope);
+    result->vectorscopeColors = std::move(merged.vectorscopeColors);
+    return result;
+}
+
+void ScopeStatistics::setRequest(const QString &scope, const ScopeRequest &request)
+{
+    QMutexLocker lock(&m_mutex);
+    m_requests.insert(scope, request);
+}
+
+void ScopeStatistics::removeRequest(const QString &scope)
+{
+    QMutexLocker lock(&m_mutex);
+    m_requests.remove(scope);
+}
+
+std::shared_ptr<const ScopeAccumulation> ScopeStatistics::statistics(const QImage &frame, const ScopeRequest &request)
+{
+    // Scopes rendering the same frame wait here while the first one computes the accumulations for all of them
+    QMutexLocker lock(&m_mutex);
+    if (m_accumulation && m_frameKey == frame.cacheKey() && m_accumulation->request.covers(request)) {
+        return m_accumulation;
+    }
+    ScopeRequest combined;
+    combined.accelFactor = request.accelFactor;
+    for (const ScopeRequest &registered : qAsConst(m_requests)) {
+        combined.merge(registered);
+    }
+    combined.merge(request);
+    m_accumulation = compute(frame, combined);
+    m_frameKey = frame.cacheKey();
+    return m_accumulation;
+}
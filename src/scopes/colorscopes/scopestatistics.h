@@ -0,0 +1,100 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef SCOPESTATISTICS_H
+#define SCOPESTATISTICS_H
+
+#include "colorconstants.h"
+#include "vectorscopegenerator.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QRgb>
+#include <QSize>
+#include <QString>
+#include <memory>
+#include <vector>
+
+class QImage;
+
+/** @brief Describes the accumulations a color scope needs from a frame, and at which resolution */
+struct ScopeRequest
+{
+    enum Accumulation { Histogram = 1 << 0, Parade = 1 << 1, Waveform = 1 << 2, Vectorscope = 1 << 3 };
+
+    /** @brief OR-ed Accumulation flags */
+    int accumulations{0};
+    /** @brief Only every accelFactor-th image row is sampled */
+    uint accelFactor{1};
+    ITURec histogramRec{ITURec::Rec_709};
+    int paradeColumns{0};
+    QSize waveformSize;
+    ITURec waveformRec{ITURec::Rec_709};
+    QSize vectorscopeSize;
+    float vectorscopeGain{1};
+    VectorscopeGenerator::ColorSpace vectorscopeColorSpace{VectorscopeGenerator::ColorSpace_YUV};
+
+    /** @brief Adds the accumulations of @param other. If both request the same accumulation, the parameters of other are used */
+    void merge(const ScopeRequest &other);
+    /** @brief True if the accumulations computed for this request can be used for @param other */
+    bool covers(const ScopeRequest &other) const;
+};
+
+/** @brief The accumulated statistics of a frame, as computed for a ScopeRequest */
+struct ScopeAccumulation
+{
+    ScopeRequest request;
+    /** @brief Size in bytes and depth of the analysed image, used by the scopes to compute their gain */
+    qint64 byteCount{0};
+    int depth{0};
+    /** @brief Number of image pixels that were sampled */
+    qint64 samples{0};
+    /** @brief 256 bins per component, filled for the Histogram and Parade accumulations */
+    std::vector<uint> red, green, blue;
+    /** @brief 256 luma bins using request.histogramRec */
+    std::vector<uint> luma;
+    /** @brief 256 rows of request.paradeColumns bins per component, row 0 is value 0 */
+    std::vector<uint> paradeRed, paradeGreen, paradeBlue;
+    /** @brief request.waveformSize bins stored row by row, row 0 is luma 0 */
+    std::vector<uint> waveform;
+    /** @brief Width of the square vectorscope */
+    int vectorscopeWidth{0};
+    /** @brief Number of pixels mapped on each vectorscope point, stored row by row */
+    std::vector<uint> vectorscope;
+    /** @brief Color of the last image pixel mapped on each vectorscope point */
+    std::vector<QRgb> vectorscopeColors;
+};
+
+/**
+  Computes the accumulations needed by the color scopes with a single pass over a frame.
+
+  Each scope renders in its own thread, but all of them analyse the same monitor frame.
+  Scopes register what they need with setRequest(). The first scope asking for the
+  statistics of a new frame computes the accumulations of all registered scopes in one
+  pass, the other scopes then reuse the result.
+  */
+class ScopeStatistics
+{
+public:
+    /** @brief Computes the requested accumulations with a single pass over the image */
+    static std::shared_ptr<const ScopeAccumulation> compute(const QImage &frame, const ScopeRequest &request);
+
+    /** @brief Register the accumulations needed by a scope for the next frames */
+    void setRequest(const QString &scope, const ScopeRequest &request);
+    /** @brief The scope does not need accumulations anymore, for example because it is hidden */
+    void removeRequest(const QString &scope);
+    /** @brief Returns the accumulations of @param frame, computing them for all registered scopes if not done yet */
+    std::shared_ptr<const ScopeAccumulation> statistics(const QImage &frame, const ScopeRequest &request);
+
+private:
+    QMutex m_mutex;
+    QMap<QString, ScopeRequest> m_requests;
+    qint64 m_frameKey{0};
+    std::shared_ptr<const ScopeAccumulation> m_accumulation;
+};
+
+#endif // SCOPESTATISTICS_H
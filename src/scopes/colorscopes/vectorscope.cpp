@@ -8,6 +8,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "vectorscope.h"
 #include "colorplaneexport.h"
 #include "utils/colortools.h"
+#include "scopestatistics.h"
 #include "vectorscopegenerator.h"
 
 #include "kdenlive_debug.h"
@@ -276,8 +277,13 @@ QImage Vectorscope::renderGfxScope(uint accelerationFactor, const QImage &qimage
         VectorscopeGenerator::ColorSpace colorSpace =
             m_aColorSpace_YPbPr->isChecked() ? VectorscopeGenerator::ColorSpace_YPbPr : VectorscopeGenerator::ColorSpace_YUV;
         VectorscopeGenerator::PaintMode paintMode = VectorscopeGenerator::PaintMode(m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt());
-        scope = m_vectorscopeGenerator->calculateVectorscope(m_scopeRect.size(), qimage, m_gain, paintMode, colorSpace, m_aAxisEnabled->isChecked(),
-                                                             accelerationFactor);
+        ScopeRequest request;
+        request.accumulations = ScopeRequest::Vectorscope;
+        request.accelFactor = accelerationFactor;
+        request.vectorscopeSize = m_scopeRect.size();
+        request.vectorscopeGain = m_gain;
+        request.vectorscopeColorSpace = colorSpace;
+        scope = m_vectorscopeGenerator->drawVectorscope(*frameStatistics(qimage, request), paintMode);
     }
     emit signalScopeRenderingFinished(uint(timer.elapsed()), accelerationFactor);
     return scope;
@@ -61,13 +61,13 @@ mRgb2YPbPr =                        r =
  */
 
 #include "vectorscopegenerator.h"
+#include "scopestatistics.h"
 #include <QImage>
+#include <algorithm>
 #include <cmath>
 
 // The maximum distance from the center for any RGB color is 0.63, so
 // no need to make the circle bigger than required.
-const double SCALING = 1 / .7;
-
 const double VectorscopeGenerator::scaling = 1 / .7;
 
 /**
@@ -105,6 +105,31 @@ QPoint VectorscopeGenerator::mapToCircle(const QSize &targetSize, const QPointF
     return {int((targetSize.width() - 1) * (point.x() + 1) / 2), int((targetSize.height() - 1) * (1 - (point.y() + 1) / 2))};
 }
 
+void VectorscopeGenerator::chromaFactors(ColorSpace colorSpace, double uFactors[3], double vFactors[3])
+{
+    switch (colorSpace) {
+    case VectorscopeGenerator::ColorSpace_YUV:
+        //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
+        uFactors[0] = -0.0005781;
+        uFactors[1] = -0.001135;
+        uFactors[2] = 0.001713;
+        vFactors[0] = 0.002411;
+        vFactors[1] = -0.002019;
+        vFactors[2] = -0.0003921;
+        break;
+    case VectorscopeGenerator::ColorSpace_YPbPr:
+    default:
+        //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
+        uFactors[0] = -0.0006671;
+        uFactors[1] = -0.001299;
+        uFactors[2] = 0.0019608;
+        vFactors[0] = 0.001961;
+        vFactors[1] = -0.001642;
+        vFactors[2] = -0.0003189;
+        break;
+    }
+}
+
 QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain,
                                                   const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
                                                   uint accelFactor) const
@@ -113,53 +138,81 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
         // Invalid size
         return QImage();
     }
+    ScopeRequest request;
+    request.accumulations = ScopeRequest::Vectorscope;
+    request.accelFactor = accelFactor;
+    request.vectorscopeSize = vectorscopeSize;
+    request.vectorscopeGain = gain;
+    request.vectorscopeColorSpace = colorSpace;
+    return drawVectorscope(*ScopeStatistics::compute(image, request), paintMode);
+}
+
+QImage VectorscopeGenerator::drawVectorscope(const ScopeAccumulation &statistics, const VectorscopeGenerator::PaintMode &paintMode) const
+{
+    const int cw = statistics.vectorscopeWidth;
+    if (cw <= 0 || statistics.vectorscope.size() != size_t(cw) * size_t(cw)) {
+        return QImage();
+    }
 
     // Prepare the vectorscope data
-    const int cw = (vectorscopeSize.width() < vectorscopeSize.height()) ? vectorscopeSize.width() : vectorscopeSize.height();
     QImage scope = QImage(cw, cw, QImage::Format_ARGB32);
     scope.fill(qRgba(0, 0, 0, 0));
 
-    const uchar *bits = image.bits();
-
-    double dy, dr, dg, db, dmax;
-    double /*y,*/ u, v;
-    QPoint pt;
-    QRgb px;
-
-    const int stepsize = int(uint(image.depth() / 8) * accelFactor);
+    const VectorscopeGenerator::ColorSpace colorSpace = statistics.request.vectorscopeColorSpace;
+    double uFactors[3], vFactors[3];
+    chromaFactors(colorSpace, uFactors, vFactors);
 
     // Just an average for the number of image pixels per scope pixel.
-    // NOTE: byteCount() has to be replaced by (img.bytesPerLine()*img.height()) for Qt 4.5 to compile, see:
-    // https://doc.qt.io/qt-5/qimage.html#bytesPerLine
-    double avgPxPerPx = double(image.depth()) / 8 * (image.bytesPerLine() * image.height()) / scope.size().width() / scope.size().height() / accelFactor;
-
-    for (int i = 0; i < (image.bytesPerLine() * image.height()); i += stepsize) {
-        auto *col = reinterpret_cast<const QRgb *>(bits);
-
-        int r = qRed(*col);
-        int g = qGreen(*col);
-        int b = qBlue(*col);
-
-        switch (colorSpace) {
-        case VectorscopeGenerator::ColorSpace_YUV:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = -0.0005781 * r - 0.001135 * g + 0.001713 * b;
-            v = 0.002411 * r - 0.002019 * g - 0.0003921 * b;
-            break;
-        case VectorscopeGenerator::ColorSpace_YPbPr:
-        default:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = -0.0006671 * r - 0.001299 * g + 0.0019608 * b;
-            v = 0.001961 * r - 0.001642 * g - 0.0003189 * b;
-            break;
+    const double avgPxPerPx = double(statistics.depth) / 8 * double(statistics.byteCount) / cw / cw / statistics.request.accelFactor;
+
+    // In the accumulating paint modes, each image pixel blends the scope pixel further. The result only
+    // depends on the number of pixels mapped on a scope pixel, so it is computed once for each count.
+    std::vector<QRgb> blended;
+    if (paintMode != PaintMode_YUV && paintMode != PaintMode_Chroma && paintMode != PaintMode_Original) {
+        const uint maxCount = *std::max_element(statistics.vectorscope.cbegin(), statistics.vectorscope.cend());
+        QRgb px = qRgba(0, 0, 0, 0);
+        blended.push_back(px);
+        for (uint count = 1; count <= std::min(maxCount, 65535u); ++count) {
+            QRgb next;
+            switch (paintMode) {
+            case PaintMode_Green:
+                next = qRgba(qRed(px) + int((255 - qRed(px)) / (3 * avgPxPerPx)), qGreen(px) + int(20 * (255 - qGreen(px)) / (avgPxPerPx)),
+                             qBlue(px) + int((255 - qBlue(px)) / (avgPxPerPx)), qAlpha(px) + int((255 - qAlpha(px)) / (avgPxPerPx)));
+                break;
+            case PaintMode_Green2:
+                next = qRgba(qRed(px) + int(ceil((255 - qRed(px)) / (4 * avgPxPerPx))), 255, qBlue(px) + int(ceil((255 - qBlue(px)) / (avgPxPerPx))),
+                             qAlpha(px) + int(ceil((255 - qAlpha(px)) / (avgPxPerPx))));
+                break;
+            case PaintMode_Black:
+            default:
+                next = qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20);
+                break;
+            }
+            if (next == px) {
+                // Saturated, all larger counts give the same color
+                break;
+            }
+            px = next;
+            blended.push_back(px);
         }
+    }
 
-        pt = mapToCircle(vectorscopeSize, QPointF(SCALING * double(gain) * u, SCALING * double(gain) * v));
-
-        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
-            // Point lies outside (because of scaling), don't plot it
-
-        } else {
+    double dy, dr, dg, db, dmax;
+    double u, v;
+    for (int y = 0; y < cw; ++y) {
+        auto *line = reinterpret_cast<QRgb *>(scope.scanLine(y));
+        const uint *counts = statistics.vectorscope.data() + size_t(y) * size_t(cw);
+        const QRgb *colors = statistics.vectorscopeColors.data() + size_t(y) * size_t(cw);
+        for (int x = 0; x < cw; ++x) {
+            if (counts[x] == 0) {
+                continue;
+            }
+            const QRgb col = colors[x];
+            const int r = qRed(col);
+            const int g = qGreen(col);
+            const int b = qBlue(col);
+            u = uFactors[0] * r + uFactors[1] * g + uFactors[2] * b;
+            v = vFactors[0] * r + vFactors[1] * g + vFactors[2] * b;
 
             // Draw the pixel using the chosen draw mode.
             switch (paintMode) {
@@ -182,26 +235,7 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
                     break;
                 }
 
-                if (dr < 0) {
-                    dr = 0;
-                }
-                if (dg < 0) {
-                    dg = 0;
-                }
-                if (db < 0) {
-                    db = 0;
-                }
-                if (dr > 255) {
-                    dr = 255;
-                }
-                if (dg > 255) {
-                    dg = 255;
-                }
-                if (db > 255) {
-                    db = 255;
-                }
-
-                scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
+                line[x] = qRgba(int(qBound(0., dr, 255.)), int(qBound(0., dg, 255.)), int(qBound(0., db, 255.)), 255);
                 break;
 
             case PaintMode_Chroma:
@@ -223,48 +257,19 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
                 }
 
                 // Scale the RGB values back to max 255
-                dmax = dr;
-                if (dg > dmax) {
-                    dmax = dg;
-                }
-                if (db > dmax) {
-                    dmax = db;
-                }
+                dmax = std::max({dr, dg, db});
                 dmax = 255 / dmax;
 
-                dr *= dmax;
-                dg *= dmax;
-                db *= dmax;
-
-                scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
+                line[x] = qRgba(int(dr * dmax), int(dg * dmax), int(db * dmax), 255);
                 break;
             case PaintMode_Original:
-                scope.setPixel(pt, *col);
+                line[x] = col;
                 break;
-            case PaintMode_Green:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + int((255 - qRed(px)) / (3 * avgPxPerPx)),
-                                         qGreen(px) + int(20 * (255 - qGreen(px)) / (avgPxPerPx)),
-                                         qBlue(px) + int((255 - qBlue(px)) / (avgPxPerPx)),
-                                         qAlpha(px) + int((255 - qAlpha(px)) / (avgPxPerPx))));
-                break;
-            case PaintMode_Green2:
-                px = scope.pixel(pt);
-                scope.setPixel(pt,
-                               qRgba(qRed(px) + int(ceil((255 - qRed(px)) / (4 * avgPxPerPx))),
-                                     255,
-                                     qBlue(px) + int(ceil((255 - qBlue(px)) / (avgPxPerPx))),
-                                     qAlpha(px) + int(ceil((255 - qAlpha(px)) / (avgPxPerPx)))));
-                break;
-            case PaintMode_Black:
             default:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
+                line[x] = blended[std::min(size_t(counts[x]), blended.size() - 1)];
                 break;
             }
         }
-
-        bits += stepsize;
     }
     return scope;
 }
@@ -13,6 +13,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 class QImage;
 class QPoint;
+struct ScopeAccumulation;
 class QPointF;
 class QSize;
 
@@ -26,6 +27,10 @@ public:
 
     QImage calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain, const VectorscopeGenerator::PaintMode &paintMode,
                                 const VectorscopeGenerator::ColorSpace &colorSpace, bool, uint accelFactor = 1) const;
+    /** @brief Draws the vectorscope from the Vectorscope accumulation of a frame, see ScopeStatistics */
+    QImage drawVectorscope(const ScopeAccumulation &statistics, const VectorscopeGenerator::PaintMode &paintMode) const;
+    /** @brief Factors converting an RGB value in {0,...,255} to U and V, in the order R, G, B */
+    static void chromaFactors(ColorSpace colorSpace, double uFactors[3], double vFactors[3]);
 
     QPoint mapToCircle(const QSize &targetSize, const QPointF &point) const;
     static const double scaling;
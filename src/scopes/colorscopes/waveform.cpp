@@ -6,6 +6,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "waveform.h"
+#include "scopestatistics.h"
 #include "waveformgenerator.h"
 // For reading out the project resolution
 #include "core.h"
@@ -184,8 +185,15 @@ QImage Waveform::renderGfxScope(uint accelFactor, const QImage &qimage)
 
     const int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
     ITURec rec = m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709;
-    QImage wave = m_waveformGenerator->calculateWaveform(scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom), qimage,
-                                                         WaveformGenerator::PaintMode(paintmode), true, rec, accelFactor);
+    ScopeRequest request;
+    request.accumulations = ScopeRequest::Waveform;
+    request.accelFactor = accelFactor;
+    request.waveformSize = scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom);
+    request.waveformRec = rec;
+    QImage wave;
+    if (!request.waveformSize.isEmpty()) {
+        wave = m_waveformGenerator->drawWaveform(*frameStatistics(qimage, request), WaveformGenerator::PaintMode(paintmode), true);
+    }
 
     emit signalScopeRenderingFinished(uint(timer.elapsed()), 1);
     return wave;
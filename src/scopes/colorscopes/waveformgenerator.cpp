@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "waveformgenerator.h"
 #include "colorconstants.h"
+#include "scopestatistics.h"
 
 #include <cmath>
 
@@ -15,9 +16,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QImage>
 #include <QPainter>
 #include <QSize>
+#include <algorithm>
 #include <vector>
 
-#define CHOP255(a) int((255) < (a) ? (255) : (a))
+#define CHOP255(a) qBound(0, int(a), 255)
 
 WaveformGenerator::WaveformGenerator() = default;
 
@@ -28,100 +30,48 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
 {
     Q_ASSERT(accelFactor >= 1);
 
-    // QTime time;
-    // time.start();
-
-    QImage wave(waveformSize, QImage::Format_ARGB32);
-
     if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
         return QImage();
     }
+    ScopeRequest request;
+    request.accumulations = ScopeRequest::Waveform;
+    request.accelFactor = accelFactor;
+    request.waveformSize = waveformSize;
+    request.waveformRec = rec;
+    return drawWaveform(*ScopeStatistics::compute(image, request), paintMode, drawAxis);
+}
+
+QImage WaveformGenerator::drawWaveform(const ScopeAccumulation &statistics, WaveformGenerator::PaintMode paintMode, bool drawAxis)
+{
+    const QSize &waveformSize = statistics.request.waveformSize;
+    if (waveformSize.isEmpty() || statistics.waveform.size() != size_t(waveformSize.width()) * size_t(waveformSize.height())) {
+        return QImage();
+    }
 
-    // Fill with transparent color
-    wave.fill(qRgba(0, 0, 0, 0));
+    QImage wave(waveformSize, QImage::Format_ARGB32);
 
     const uint ww = uint(waveformSize.width());
     const uint wh = uint(waveformSize.height());
-    const uint iw = uint(image.bytesPerLine());
-    const uint ih = uint(image.height());
-    const uint byteCount = iw * ih;
-
-    std::vector<std::vector<uint>> waveValues(size_t(waveformSize.width()), std::vector<uint>(size_t(waveformSize.height()), 0));
+    const uint byteCount = uint(statistics.byteCount);
+    const uint accelFactor = statistics.request.accelFactor;
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
     const float pixelDepth = float((byteCount >> 2) / accelFactor) / (ww * wh);
     const float gain = 255.f / (8 * pixelDepth);
-    // qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
-
-    // Subtract 1 from sizes because we start counting from 0.
-    // Not doing it would result in attempts to paint outside of the image.
-    const float hPrediv = (wh - 1) / 255.f;
-    const float wPrediv = (ww - 1) / float(iw - 1);
-
-    const uchar *bits = image.bits();
-    const int bpp = image.depth() / 8;
 
-    for (uint i = 0, x = 0; i < byteCount; i += uint(bpp)) {
-
-        Q_ASSERT(bits < image.bits() + byteCount);
-
-        float dY, dx, dy;
-        auto *col = reinterpret_cast<const QRgb *>(bits);
-
-        if (rec == ITURec::Rec_601) {
-            // CIE 601 Luminance
-            dY = REC_601_R * qRed(*col) + REC_601_G * qGreen(*col) + REC_601_B * qBlue(*col);
-        } else {
-            // CIE 709 Luminance
-            dY = REC_709_R * qRed(*col) + REC_709_G * qGreen(*col) + REC_709_B * qBlue(*col);
-        }
-        // dY is on [0,255] now.
-
-        dy = dY * hPrediv;
-        dx = x * wPrediv;
-        waveValues[size_t(dx)][size_t(dy)]++;
-
-        bits += bpp;
-        x += uint(bpp);
-        if (x > iw) {
-            x -= iw;
-            if (accelFactor > 1) {
-                bits += bpp * int(iw * (accelFactor - 1));
-                i += uint(bpp) * iw * (accelFactor - 1);
-            }
+    // The color of a scope pixel only depends on its count, precompute it for all counts
+    // below the one where the color saturates
+    const std::vector<QRgb> colors = colorTable(paintMode, gain);
+    const uint maxCount = uint(colors.size() - 1);
+    for (uint j = 0; j < wh; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(wave.scanLine(int(wh - j - 1)));
+        const uint *counts = statistics.waveform.data() + j * ww;
+        for (uint i = 0; i < ww; ++i) {
+            line[i] = colors[std::min(counts[i], maxCount)];
         }
     }
 
-    switch (paintMode) {
-    case PaintMode_Green:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                // Logarithmic scale. Needs fine tuning by hand, but looks great.
-                wave.setPixel(i, waveformSize.height() - j - 1,
-                              qRgba(CHOP255(52 * logf(0.1f * gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(52 * logf(      gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(52 * logf(.25f * gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(64 * logf(      gain * float(waveValues[size_t(i)][size_t(j)])))));
-            }
-        }
-        break;
-    case PaintMode_Yellow:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 242, 0, CHOP255(gain * float(waveValues[size_t(i)][size_t(j)]))));
-            }
-        }
-        break;
-    default:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 255, 255, CHOP255(2.f * gain * float(waveValues[size_t(i)][size_t(j)]))));
-            }
-        }
-        break;
-    }
-
     if (drawAxis) {
         QPainter davinci;
         bool ok = davinci.begin(&wave);
@@ -142,9 +92,32 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
         }
     }
 
-    // uint diff = time.elapsed();
-    // emit signalCalculationFinished(wave, diff);
-
     return wave;
 }
+
+std::vector<QRgb> WaveformGenerator::colorTable(PaintMode paintMode, float gain)
+{
+    // Largest count that does not saturate all components, the table stays small for usual gains
+    const float saturation = paintMode == PaintMode_Green ? std::exp(255.f / 52) / (.1f * gain) : 255.f / gain;
+    const size_t size = size_t(qBound(1.f, std::ceil(saturation) + 1, 65536.f));
+    std::vector<QRgb> colors(size);
+    for (size_t v = 0; v < size; ++v) {
+        const float count = float(v);
+        switch (paintMode) {
+        case PaintMode_Green:
+            // Logarithmic scale. Needs fine tuning by hand, but looks great.
+            colors[v] = v == 0 ? qRgba(0, 0, 0, 0)
+                               : qRgba(CHOP255(52 * logf(0.1f * gain * count)), CHOP255(52 * logf(gain * count)), CHOP255(52 * logf(.25f * gain * count)),
+                                       CHOP255(64 * logf(gain * count)));
+            break;
+        case PaintMode_Yellow:
+            colors[v] = qRgba(255, 242, 0, CHOP255(gain * count));
+            break;
+        default:
+            colors[v] = qRgba(255, 255, 255, CHOP255(2.f * gain * count));
+            break;
+        }
+    }
+    return colors;
+}
 #undef CHOP255
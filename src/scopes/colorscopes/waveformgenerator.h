@@ -9,10 +9,13 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #define WAVEFORMGENERATOR_H
 
 #include <QObject>
+#include <QRgb>
 #include "colorconstants.h"
+#include <vector>
 
 class QImage;
 class QSize;
+struct ScopeAccumulation;
 
 class WaveformGenerator : public QObject
 {
@@ -26,6 +29,12 @@ public:
 
     QImage calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
                              const ITURec rec, uint accelFactor = 1);
+    /** @brief Draws the waveform from the Waveform accumulation of a frame, see ScopeStatistics */
+    static QImage drawWaveform(const ScopeAccumulation &statistics, WaveformGenerator::PaintMode paintMode, bool drawAxis);
+
+private:
+    /** @brief Scope pixel color for each count, the last entry is used for all larger counts */
+    static std::vector<QRgb> colorTable(PaintMode paintMode, float gain);
 };
 
 #endif // WAVEFORMGENERATOR_H
@@ -11,6 +11,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "audioscopes/spectrogram.h"
 #include "colorscopes/histogram.h"
 #include "colorscopes/rgbparade.h"
+#include "colorscopes/scopestatistics.h"
 #include "colorscopes/vectorscope.h"
 #include "colorscopes/waveform.h"
 #include "core.h"
@@ -30,7 +31,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 ScopeManager::ScopeManager(QObject *parent)
     : QObject(parent)
-
+    , m_statistics(std::make_shared<ScopeStatistics>())
 {
     connect(pCore->monitorManager(), &MonitorManager::checkColorScopes, this, &ScopeManager::slotUpdateActiveRenderer);
     connect(pCore->monitorManager(), &MonitorManager::clearScopes, this, &ScopeManager::slotClearColorScopes);
@@ -90,6 +91,7 @@ bool ScopeManager::addScope(AbstractGfxScopeWidget *colorScope, QDockWidget *col
         GfxScopeData gsd;
         gsd.scope = colorScope;
         m_colorScopes.append(gsd);
+        colorScope->setStatistics(m_statistics);
 
         connect(colorScope, &AbstractScopeWidget::requestAutoRefresh, this, &ScopeManager::slotCheckActiveScopes);
         connect(colorScope, &AbstractGfxScopeWidget::signalFrameRequest, this, &ScopeManager::slotRequestFrame);
@@ -127,6 +129,10 @@ void ScopeManager::slotDistributeFrame(const QImage &image)
     qCDebug(KDENLIVE_LOG) << "ScopeManager: Starting to distribute frame.";
 #endif
     for (auto &m_colorScope : m_colorScopes) {
+        if (m_colorScope.scope->visibleRegion().isEmpty() || (!m_colorScope.scope->autoRefreshEnabled() && !m_colorScope.singleFrameRequested)) {
+            // Do not analyse the frame for scopes that will not render it
+            m_colorScope.scope->releaseStatistics();
+        }
         if (!m_colorScope.scope->visibleRegion().isEmpty()) {
             if (m_colorScope.scope->autoRefreshEnabled()) {
                 m_colorScope.scope->slotRenderZoneUpdated(image);
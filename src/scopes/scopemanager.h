@@ -12,8 +12,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "colorscopes/abstractgfxscopewidget.h"
 
 #include <QList>
+#include <memory>
 
 class QDockWidget;
+class ScopeStatistics;
 class AbstractMonitor;
 class QSignalMapper;
 
@@ -68,6 +70,8 @@ public:
 private:
     QList<AudioScopeData> m_audioScopes;
     QList<GfxScopeData> m_colorScopes;
+    /** @brief Frame accumulations shared by the color scopes, so that a frame is only analysed once */
+    std::shared_ptr<ScopeStatistics> m_statistics;
 
     AbstractMonitor *m_lastConnectedRenderer{nullptr};
 
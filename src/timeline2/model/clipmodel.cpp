@@ -1142,6 +1142,12 @@ void ClipModel::setInOut(int in, int out)
 {
     MoveableItem::setInOut(in, out);
     m_clipMarkerModel->updateSnapModelInOut({in, out, qMax(0, m_mixDuration - m_mixCutPos)});
+    if (m_currentTrackId != -1) {
+        if (auto ptr = m_parent.lock()) {
+            // The track bounds its range queries with the playtime of its clips
+            ptr->getTrackById(m_currentTrackId)->updateClipPlaytime(m_id);
+        }
+    }
 }
 
 void ClipModel::setCurrentTrackId(int tid, bool finalMove)
@@ -4,6 +4,7 @@
 */
 
 #include "timelinemodel.hpp"
+#include "assets/model/assetcommand.hpp"
 #include "assets/model/assetparametermodel.hpp"
 #include "bin/model/subtitlemodel.hpp"
 #include "bin/projectclip.h"
@@ -14,6 +15,7 @@
 #include "doc/docundostack.hpp"
 #include "doc/kdenlivedoc.h"
 #include "effects/effectsrepository.hpp"
+#include "effects/effectstack/model/effectitemmodel.hpp"
 #include "effects/effectstack/model/effectstackmodel.hpp"
 #include "groupsmodel.hpp"
 #include "kdenlivesettings.h"
@@ -37,6 +39,7 @@
 #include <mlt++/MltProfile.h>
 #include <mlt++/MltTractor.h>
 #include <mlt++/MltTransition.h>
+#include <algorithm>
 #include <queue>
 #include <set>
 
@@ -376,13 +379,7 @@ int TimelineModel::getSubtitleByStartPosition(int position) const
 {
     READ_LOCK();
     GenTime startTime(position, pCore->getCurrentFps());
-    auto findResult = std::find_if(std::begin(m_allSubtitles), std::end(m_allSubtitles), [&](const std::pair<int, GenTime> &pair) {
-        return pair.second == startTime;
-    });
-    if (findResult != std::end(m_allSubtitles)) {
-        return findResult->first;
-    }
-    return -1;
+    return getSubtitleIdForStart(startTime);
 }
 
 int TimelineModel::getSubtitleByPosition(int position) const
@@ -1163,11 +1160,18 @@ bool TimelineModel::requestClipMove(int clipId, int trackId, int position, bool
         int delta_pos = position - m_allClips[clipId]->getPosition();
         return requestGroupMove(clipId, groupId, delta_track, delta_pos, moveMirrorTracks, updateView, logUndo, revertMove);
     }
+    const QJsonObject address = logUndo ? journalAddress(clipId) : QJsonObject();
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
     bool res = requestClipMove(clipId, trackId, position, moveMirrorTracks, updateView, invalidateTimeline, logUndo, undo, redo, revertMove);
     if (res && logUndo) {
-        PUSH_UNDO(undo, redo, i18n("Move clip"));
+        QJsonObject operation;
+        if (!address.isEmpty()) {
+            operation = {{QStringLiteral("op"), QStringLiteral("moveClip")}, {QStringLiteral("item"), address},
+                         {QStringLiteral("track"), getTrackPosition(trackId)}, {QStringLiteral("position"), position},
+                         {QStringLiteral("mirror"), moveMirrorTracks}, {QStringLiteral("revert"), revertMove}};
+        }
+        PUSH_JOURNALED_UNDO(undo, redo, i18n("Move clip"), operation);
     }
     TRACE_RES(res);
     return res;
@@ -2253,11 +2257,18 @@ bool TimelineModel::requestGroupMove(int itemId, int groupId, int delta_track, i
 {
     QWriteLocker locker(&m_lock);
     TRACE(itemId, groupId, delta_track, delta_pos, updateView, logUndo);
+    const QJsonObject address = logUndo ? journalAddress(itemId) : QJsonObject();
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
     bool res = requestGroupMove(itemId, groupId, delta_track, delta_pos, updateView, logUndo, undo, redo, revertMove, moveMirrorTracks);
     if (res && logUndo) {
-        PUSH_UNDO(undo, redo, i18n("Move group"));
+        QJsonObject operation;
+        if (!address.isEmpty() && groupId == m_groups->getRootId(itemId)) {
+            operation = {{QStringLiteral("op"), QStringLiteral("moveGroup")}, {QStringLiteral("item"), address},
+                         {QStringLiteral("deltaTrack"), delta_track}, {QStringLiteral("deltaPosition"), delta_pos},
+                         {QStringLiteral("mirror"), moveMirrorTracks}, {QStringLiteral("revert"), revertMove}};
+        }
+        PUSH_JOURNALED_UNDO(undo, redo, i18n("Move group"), operation);
     }
     TRACE_RES(res);
     return res;
@@ -3100,6 +3111,7 @@ int TimelineModel::requestItemResize(int itemId, int size, bool right, bool logU
         TRACE_RES(-1)
         return -1;
     }
+    const QJsonObject address = logUndo ? journalAddress(itemId) : QJsonObject();
     int in = 0;
     int offset = getItemPlaytime(itemId);
     int tid = getItemTrackId(itemId);
@@ -3332,14 +3344,19 @@ int TimelineModel::requestItemResize(int itemId, int size, bool right, bool logU
         bool undone = undo();
         Q_ASSERT(undone);
     } else if (logUndo) {
+        QJsonObject operation;
+        if (!address.isEmpty()) {
+            operation = {{QStringLiteral("op"), QStringLiteral("resize")}, {QStringLiteral("item"), address}, {QStringLiteral("size"), size},
+                         {QStringLiteral("right"), right}, {QStringLiteral("single"), allowSingleResize}};
+        }
         if (isClip(itemId)) {
             adjust_mix();
             PUSH_LAMBDA(adjust_mix, redo);
-            PUSH_UNDO(undo, redo, i18n("Resize clip"))
+            PUSH_JOURNALED_UNDO(undo, redo, i18n("Resize clip"), operation)
         } else if (isComposition(itemId)) {
-            PUSH_UNDO(undo, redo, i18n("Resize composition"))
+            PUSH_JOURNALED_UNDO(undo, redo, i18n("Resize composition"), operation)
         } else if (isSubTitle(itemId)) {
-            PUSH_UNDO(undo, redo, i18n("Resize subtitle"))
+            PUSH_JOURNALED_UNDO(undo, redo, i18n("Resize subtitle"), operation)
         }
     }
     int res = result ? size : -1;
@@ -4247,6 +4264,8 @@ void TimelineModel::registerSubtitle(int id, GenTime startTime, bool temporary)
 {
     Q_ASSERT(m_allSubtitles.count(id) == 0);
     m_allSubtitles.emplace(id, startTime);
+    m_subtitleRows.insert(std::upper_bound(m_subtitleRows.begin(), m_subtitleRows.end(), id), id);
+    m_subtitlesByStart[startTime] = id;
     if (!temporary) {
         m_groups->createGroupItem(id);
     }
@@ -4254,7 +4273,28 @@ void TimelineModel::registerSubtitle(int id, GenTime startTime, bool temporary)
 
 int TimelineModel::positionForIndex(int id)
 {
-    return int(std::distance(m_allSubtitles.begin(),m_allSubtitles.find(id)));
+    return int(std::lower_bound(m_subtitleRows.begin(), m_subtitleRows.end(), id) - m_subtitleRows.begin());
+}
+
+void TimelineModel::setSubtitleStart(int id, GenTime startTime)
+{
+    GenTime &current = m_allSubtitles.at(id);
+    auto previous = m_subtitlesByStart.find(current);
+    // Another subtitle may already have been moved to this position
+    if (previous != m_subtitlesByStart.end() && previous->second == id) {
+        m_subtitlesByStart.erase(previous);
+    }
+    current = startTime;
+    m_subtitlesByStart[startTime] = id;
+}
+
+int TimelineModel::getSubtitleIdForStart(GenTime startTime) const
+{
+    auto it = m_subtitlesByStart.find(startTime);
+    if (it == m_subtitlesByStart.end()) {
+        return -1;
+    }
+    return it->second;
 }
 
 void TimelineModel::deregisterSubtitle(int id, bool temporary)
@@ -4263,6 +4303,11 @@ void TimelineModel::deregisterSubtitle(int id, bool temporary)
     if (!temporary && m_subtitleModel->isSelected(id)) {
         requestClearSelection(true);
     }
+    auto start = m_subtitlesByStart.find(m_allSubtitles.at(id));
+    if (start != m_subtitlesByStart.end() && start->second == id) {
+        m_subtitlesByStart.erase(start);
+    }
+    m_subtitleRows.erase(std::lower_bound(m_subtitleRows.begin(), m_subtitleRows.end(), id));
     m_allSubtitles.erase(id);
     if (!temporary) {
         m_groups->destructGroupItem(id);
@@ -4825,6 +4870,7 @@ bool TimelineModel::requestCompositionMove(int compoId, int trackId, int positio
         int delta_pos = position - m_allCompositions[compoId]->getPosition();
         return requestGroupMove(compoId, groupId, delta_track, delta_pos, true, updateView, logUndo);
     }
+    const QJsonObject address = logUndo ? journalAddress(compoId) : QJsonObject();
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
     int min = getCompositionPosition(compoId);
@@ -4840,7 +4886,12 @@ bool TimelineModel::requestCompositionMove(int compoId, int trackId, int positio
     }
 
     if (res && logUndo) {
-        PUSH_UNDO(undo, redo, i18n("Move composition"));
+        QJsonObject operation;
+        if (!address.isEmpty()) {
+            operation = {{QStringLiteral("op"), QStringLiteral("moveComposition")}, {QStringLiteral("item"), address},
+                         {QStringLiteral("track"), getTrackPosition(trackId)}, {QStringLiteral("position"), position}};
+        }
+        PUSH_JOURNALED_UNDO(undo, redo, i18n("Move composition"), operation);
         checkRefresh(min, max);
     }
     return res;
@@ -5272,9 +5323,36 @@ std::shared_ptr<Mlt::Producer> TimelineModel::producer()
     return std::make_shared<Mlt::Producer>(tractor());
 }
 
+const QString TimelineModel::lockedSceneList(const QString &root, const QString &filterData)
+{
+    // The bin playlist is saved with the tractor, so the bin must not change either. An edit holding one of the locks
+    // for writing may need the other one, so we never wait for a lock while holding the other
+    std::shared_ptr<ProjectItemModel> binModel = pCore->projectItemModel();
+    while (true) {
+        m_lock.lockForRead();
+        if (!binModel || binModel->m_lock.tryLockForRead()) {
+            break;
+        }
+        m_lock.unlock();
+        // Wait until the bin is released, then try again
+        binModel->m_lock.lockForRead();
+        binModel->m_lock.unlock();
+    }
+    const QString playlist = sceneList(root, QString(), filterData);
+    if (binModel) {
+        binModel->m_lock.unlock();
+    }
+    m_lock.unlock();
+    return playlist;
+}
+
 const QString TimelineModel::sceneList(const QString &root, const QString &fullPath, const QString &filterData)
 {
     LocaleHandling::resetLocale();
+    if (m_subtitleModel) {
+        // The subtitle filter of the scene must use an up to date subtitle file
+        m_subtitleModel->flushSubtitleFile();
+    }
     QString playlist;
     Mlt::Consumer xmlConsumer(*m_profile, "xml", fullPath.isEmpty() ? "kdenlive_playlist" : fullPath.toUtf8().constData());
     if (!root.isEmpty()) {
@@ -5305,6 +5383,163 @@ const QString TimelineModel::sceneList(const QString &root, const QString &fullP
     return playlist;
 }
 
+QJsonObject TimelineModel::journalAddress(const ObjectId &owner) const
+{
+    READ_LOCK();
+    switch (owner.first) {
+    case ObjectType::TimelineClip:
+    case ObjectType::TimelineComposition:
+    case ObjectType::TimelineSubtitle:
+        return journalAddress(owner.second);
+    case ObjectType::TimelineTrack:
+        if (isTrack(owner.second)) {
+            return {{QStringLiteral("type"), QStringLiteral("track")}, {QStringLiteral("track"), getTrackPosition(owner.second)}};
+        }
+        break;
+    case ObjectType::BinClip:
+        return {{QStringLiteral("type"), QStringLiteral("bin")}, {QStringLiteral("id"), owner.second}};
+    case ObjectType::Master:
+        return {{QStringLiteral("type"), QStringLiteral("master")}};
+    default:
+        break;
+    }
+    return QJsonObject();
+}
+
+QJsonObject TimelineModel::journalAddress(int itemId) const
+{
+    READ_LOCK();
+    if (isSubTitle(itemId)) {
+        return {{QStringLiteral("type"), QStringLiteral("subtitle")}, {QStringLiteral("position"), getSubtitlePosition(itemId)}};
+    }
+    if (!isClip(itemId) && !isComposition(itemId)) {
+        return QJsonObject();
+    }
+    int trackId = getItemTrackId(itemId);
+    if (!isTrack(trackId)) {
+        return QJsonObject();
+    }
+    return {{QStringLiteral("type"), isClip(itemId) ? QStringLiteral("clip") : QStringLiteral("composition")},
+            {QStringLiteral("track"), getTrackPosition(trackId)},
+            {QStringLiteral("position"), getItemPosition(itemId)}};
+}
+
+ObjectId TimelineModel::journalItem(const QJsonObject &address) const
+{
+    READ_LOCK();
+    const QString type = address.value(QStringLiteral("type")).toString();
+    int position = address.value(QStringLiteral("position")).toInt(-1);
+    if (type == QLatin1String("bin")) {
+        return {ObjectType::BinClip, address.value(QStringLiteral("id")).toInt(-1)};
+    }
+    if (type == QLatin1String("master")) {
+        return {ObjectType::Master, 0};
+    }
+    if (type == QLatin1String("subtitle")) {
+        int sid = getSubtitleByStartPosition(position);
+        return sid > -1 ? ObjectId(ObjectType::TimelineSubtitle, sid) : ObjectId(ObjectType::NoItem, -1);
+    }
+    int trackPosition = address.value(QStringLiteral("track")).toInt(-1);
+    if (trackPosition < 0 || trackPosition >= int(m_allTracks.size())) {
+        return {ObjectType::NoItem, -1};
+    }
+    int trackId = getTrackIndexFromPosition(trackPosition);
+    if (type == QLatin1String("track")) {
+        return {ObjectType::TimelineTrack, trackId};
+    }
+    if (type == QLatin1String("clip")) {
+        int cid = getClipByStartPosition(trackId, position);
+        if (cid > -1) {
+            return {ObjectType::TimelineClip, cid};
+        }
+    } else if (type == QLatin1String("composition")) {
+        int compoId = getCompositionByPosition(trackId, position);
+        if (compoId > -1 && getCompositionPosition(compoId) == position) {
+            return {ObjectType::TimelineComposition, compoId};
+        }
+    }
+    return {ObjectType::NoItem, -1};
+}
+
+bool TimelineModel::replayJournal(const QJsonObject &operation)
+{
+    QWriteLocker locker(&m_lock);
+    const QString type = operation.value(QStringLiteral("op")).toString();
+    if (type == QLatin1String("setParameter")) {
+        const ObjectId owner = journalItem(operation.value(QStringLiteral("owner")).toObject());
+        int effectRow = operation.value(QStringLiteral("effect")).toInt(-1);
+        std::shared_ptr<AssetParameterModel> model;
+        if (effectRow < 0) {
+            if (owner.first == ObjectType::TimelineComposition) {
+                model = getCompositionParameterModel(owner.second);
+            }
+        } else {
+            std::shared_ptr<EffectStackModel> stack;
+            switch (owner.first) {
+            case ObjectType::TimelineClip:
+                stack = getClipEffectStackModel(owner.second);
+                break;
+            case ObjectType::TimelineTrack:
+                stack = getTrackEffectStackModel(owner.second);
+                break;
+            case ObjectType::Master:
+                stack = getMasterEffectStackModel();
+                break;
+            case ObjectType::BinClip:
+                stack = pCore->getItemEffectStack(int(owner.first), owner.second);
+                break;
+            default:
+                break;
+            }
+            if (stack && effectRow < stack->rowCount()) {
+                model = std::dynamic_pointer_cast<EffectItemModel>(stack->getEffectStackRow(effectRow));
+            }
+        }
+        int row = operation.value(QStringLiteral("row")).toInt(-1);
+        if (!model || row < 0 || row >= model->rowCount()) {
+            return false;
+        }
+        QModelIndex index = model->index(row, 0);
+        if (model->data(index, AssetParameterModel::NameRole).toString() != operation.value(QStringLiteral("name")).toString()) {
+            return false;
+        }
+        pCore->pushUndo(new AssetCommand(model, index, operation.value(QStringLiteral("value")).toString()), operation);
+        return true;
+    }
+    const ObjectId item = journalItem(operation.value(QStringLiteral("item")).toObject());
+    int itemId = item.second;
+    if (item.first != ObjectType::TimelineClip && item.first != ObjectType::TimelineComposition && item.first != ObjectType::TimelineSubtitle) {
+        return false;
+    }
+    bool mirror = operation.value(QStringLiteral("mirror")).toBool();
+    bool revert = operation.value(QStringLiteral("revert")).toBool();
+    if (type == QLatin1String("resize")) {
+        int size = operation.value(QStringLiteral("size")).toInt();
+        bool right = operation.value(QStringLiteral("right")).toBool();
+        return requestItemResize(itemId, size, right, true, -1, operation.value(QStringLiteral("single")).toBool()) == size;
+    }
+    if (type == QLatin1String("moveGroup")) {
+        if (!m_groups->isInGroup(itemId)) {
+            return false;
+        }
+        return requestGroupMove(itemId, m_groups->getRootId(itemId), operation.value(QStringLiteral("deltaTrack")).toInt(),
+                                operation.value(QStringLiteral("deltaPosition")).toInt(), mirror, true, true, revert);
+    }
+    int trackPosition = operation.value(QStringLiteral("track")).toInt(-1);
+    if (trackPosition < 0 || trackPosition >= int(m_allTracks.size())) {
+        return false;
+    }
+    int trackId = getTrackIndexFromPosition(trackPosition);
+    int position = operation.value(QStringLiteral("position")).toInt();
+    if (type == QLatin1String("moveClip") && item.first == ObjectType::TimelineClip) {
+        return requestClipMove(itemId, trackId, position, mirror, true, true, false, revert);
+    }
+    if (type == QLatin1String("moveComposition") && item.first == ObjectType::TimelineComposition) {
+        return requestCompositionMove(itemId, trackId, position, true, true);
+    }
+    return false;
+}
+
 void TimelineModel::checkRefresh(int start, int end)
 {
     if (m_blockRefresh) {
@@ -6358,21 +6593,20 @@ void TimelineModel::setSubModel(std::shared_ptr<SubtitleModel> model)
 
 int TimelineModel::getSubtitleIndex(int subId) const
 {
-    if (m_allSubtitles.count(subId) == 0) {
+    auto it = std::lower_bound(m_subtitleRows.begin(), m_subtitleRows.end(), subId);
+    if (it == m_subtitleRows.end() || *it != subId) {
         return -1;
     }
-    auto it = m_allSubtitles.find(subId);
-    return int(std::distance( m_allSubtitles.begin(), it));
+    return int(it - m_subtitleRows.begin());
 }
 
 std::pair<int, GenTime> TimelineModel::getSubtitleIdFromIndex(int index) const
 {
-    if (index >= static_cast<int> (m_allSubtitles.size())) {
+    if (index < 0 || index >= static_cast<int> (m_subtitleRows.size())) {
         return {-1, GenTime()};
     }
-    auto it = m_allSubtitles.begin();
-    std::advance(it, index);
-    return {it->first, it->second};
+    int id = m_subtitleRows[size_t(index)];
+    return {id, m_allSubtitles.at(id)};
 }
 
 QVariantList TimelineModel::getMasterEffectZones() const
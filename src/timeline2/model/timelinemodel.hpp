@@ -10,6 +10,7 @@
 #include "undohelper.hpp"
 #include "trackmodel.hpp"
 #include <QAbstractItemModel>
+#include <QJsonObject>
 #include <QReadWriteLock>
 #include <cassert>
 #include <memory>
@@ -450,8 +451,22 @@ public:
     /**  @brief Returns the current project xml playlist for saving
      */
     const QString sceneList(const QString &root, const QString &fullPath = QString(), const QString &filterData = QString());
+    /**  @brief Returns the current project xml playlist for saving, like sceneList.
+         The timeline and the bin are locked for reading while the playlist is built, so that other threads cannot edit them
+     */
+    const QString lockedSceneList(const QString &root, const QString &filterData = QString());
+    /** @brief Describe the owner of an asset for the undo journal. Timeline items are described by their track index and
+        position, since their ids change when the project is reopened. Returns an empty object if the owner cannot be described
+     */
+    QJsonObject journalAddress(const ObjectId &owner) const;
+    /** @brief Apply an edit read from the undo journal, returns false if it cannot be replayed */
+    bool replayJournal(const QJsonObject &operation);
 
 protected:
+    /** @brief Describe a timeline item for the undo journal */
+    QJsonObject journalAddress(int itemId) const;
+    /** @brief Find the item described in the undo journal, returns ObjectType::NoItem if it does not exist */
+    ObjectId journalItem(const QJsonObject &address) const;
     /** @brief Creates a new clip instance without inserting it.
        This action is undoable, returns true on success
        @param binClipId: Bin id of the clip to insert
@@ -813,6 +828,10 @@ protected:
     
     void registerSubtitle(int id, GenTime startTime, bool temporary = false);
     void deregisterSubtitle(int id, bool temporary = false);
+    /** @brief Change the start position of a registered subtitle, keeping the subtitle indexes up to date */
+    void setSubtitleStart(int id, GenTime startTime);
+    /** @brief Returns the id of the subtitle starting at @param startTime, or -1 */
+    int getSubtitleIdForStart(GenTime startTime) const;
     /** @brief Returns the index for a subtitle's id (it's position in the list
      */
     int positionForIndex(int id);
@@ -919,6 +938,10 @@ protected:
         m_allCompositions; // the keys are the composition id, and the values are the corresponding pointers
         
     std::map<int, GenTime> m_allSubtitles;
+    // Subtitle ids in ascending order, the row of a subtitle in the SubtitleModel is its index here
+    std::vector<int> m_subtitleRows;
+    // Subtitle ids by start position
+    std::map<GenTime, int> m_subtitlesByStart;
 
     static int next_id; /// next valid id to assign
 
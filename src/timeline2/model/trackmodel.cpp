@@ -19,6 +19,7 @@
 #include "timelinemodel.hpp"
 #include <QDebug>
 #include <QModelIndex>
+#include <limits>
 #include <memory>
 #include <mlt++/MltTransition.h>
 
@@ -167,6 +168,7 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
             m_allClips[clip->getId()] = clip; // store clip
             // update clip position and track
             clip->setPosition(position);
+            updateClipIndex(clipId, -1, position);
             if (finalMove) {
                 clip->setSubPlaylistIndex(subPlaylist, m_id);
             }
@@ -403,6 +405,7 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
             m_playlists[target_track].consolidate_blanks();
             m_allClips[clipId]->setCurrentTrackId(-1);
             //m_allClips[clipId]->setSubPlaylistIndex(-1);
+            updateClipIndex(clipId, m_allClips[clipId]->getPosition(), -1);
             m_allClips.erase(clipId);
             delete prod;
             m_playlists[target_track].unlock();
@@ -622,7 +625,8 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
     if (!isHidden() && !isAudioTrack()) {
         checkRefresh = true;
     }
-    auto update_snaps = [old_in, old_out, checkRefresh, right, this](int new_in, int new_out) {
+    auto update_snaps = [clipId, old_in, old_out, checkRefresh, right, this](int new_in, int new_out) {
+        updateClipPlaytime(clipId);
         if (auto ptr = m_parent.lock()) {
             if (right) {
                 ptr->m_snaps->removePoint(old_out);
@@ -664,6 +668,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
             // The second is parameter is delta - 1 because this function expects an out time, which is basically size - 1
             m_playlists[target_track].insert_blank(blank_index, delta - 1);
             if (!right) {
+                updateClipIndex(clipId, m_allClips[clipId]->getPosition(), clip_position + delta);
                 m_allClips[clipId]->setPosition(clip_position + delta);
                 // Because we inserted blank before, the index of our clip has increased
                 target_clip_mutable++;
@@ -757,7 +762,9 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                     err = m_playlists[target_track].resize_clip(target_clip_mutable, in, out);
                 }
                 if (!right && err == 0) {
-                    m_allClips[clipId]->setPosition(m_playlists[target_track].clip_start(target_clip_mutable));
+                    int new_position = m_playlists[target_track].clip_start(target_clip_mutable);
+                    updateClipIndex(clipId, m_allClips[clipId]->getPosition(), new_position);
+                    m_allClips[clipId]->setPosition(new_position);
                 }
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
@@ -780,10 +787,9 @@ int TrackModel::getId() const
 int TrackModel::getClipByStartPosition(int position) const
 {
     READ_LOCK();
-    for (auto &clip : m_allClips) {
-        if (clip.second->getPosition() == position) {
-            return clip.second->getId();
-        }
+    auto it = m_clipsByPosition.lower_bound({position, std::numeric_limits<int>::min()});
+    if (it != m_clipsByPosition.cend() && it->first == position) {
+        return it->second;
     }
     return -1;
 }
@@ -858,19 +864,72 @@ int TrackModel::getClipByRow(int row) const
     return (*it).first;
 }
 
+void TrackModel::updateClipIndex(int clipId, int oldPosition, int newPosition)
+{
+    QWriteLocker locker(&m_lock);
+    if (oldPosition > -1) {
+        m_clipsByPosition.erase({oldPosition, clipId});
+    }
+    auto it = m_indexedPlaytimes.find(clipId);
+    if (newPosition > -1) {
+        m_clipsByPosition.insert({newPosition, clipId});
+        if (it == m_indexedPlaytimes.end()) {
+            int playtime = m_allClips.at(clipId)->getPlaytime();
+            m_indexedPlaytimes[clipId] = playtime;
+            m_playtimes.insert(playtime);
+        } else {
+            updateClipPlaytime(clipId);
+        }
+    } else if (it != m_indexedPlaytimes.end()) {
+        m_playtimes.erase(m_playtimes.find(it->second));
+        m_indexedPlaytimes.erase(it);
+    }
+}
+
+void TrackModel::updateClipPlaytime(int clipId)
+{
+    QWriteLocker locker(&m_lock);
+    auto it = m_indexedPlaytimes.find(clipId);
+    if (it == m_indexedPlaytimes.end()) {
+        // The clip is not indexed yet, its playtime will be read on insertion
+        return;
+    }
+    int playtime = m_allClips.at(clipId)->getPlaytime();
+    if (it->second != playtime) {
+        m_playtimes.erase(m_playtimes.find(it->second));
+        m_playtimes.insert(playtime);
+        it->second = playtime;
+    }
+}
+
 std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
 {
     READ_LOCK();
     std::unordered_set<int> ids;
-    for (const auto &clp : m_allClips) {
-        int pos = clp.second->getPosition();
-        int length = clp.second->getPlaytime();
-        if (end > -1 && pos >= end) {
+    auto first = m_clipsByPosition.lower_bound({position, std::numeric_limits<int>::min()});
+    // Clips of a same playlist don't overlap, so among the clips starting before the range only the last one of each
+    // playlist can intersect it. The longest playtime of the track bounds the search when a playlist has no such clip.
+    const int maxPlaytime = m_playtimes.empty() ? 0 : *m_playtimes.crbegin();
+    bool found[2] = {false, m_playlists[1].count() == 0};
+    for (auto it = std::set<std::pair<int, int>>::const_reverse_iterator(first); it != m_clipsByPosition.crend() && !(found[0] && found[1]); ++it) {
+        if (it->first + maxPlaytime - 1 < position) {
+            break;
+        }
+        const auto &clip = m_allClips.at(it->second);
+        int playlist = clip->getSubPlaylistIndex() == 1 ? 1 : 0;
+        if (found[playlist]) {
             continue;
         }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(clp.first);
+        found[playlist] = true;
+        if (it->first + clip->getPlaytime() - 1 >= position) {
+            ids.insert(it->second);
+        }
+    }
+    for (auto it = first; it != m_clipsByPosition.cend(); ++it) {
+        if (end > -1 && it->first >= end) {
+            break;
         }
+        ids.insert(it->second);
     }
     return ids;
 }
@@ -887,16 +946,19 @@ std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end
     READ_LOCK();
     // TODO: this function doesn't take into accounts the fact that there are two tracks
     std::unordered_set<int> ids;
-    for (const auto &compo : m_allCompositions) {
-        int pos = compo.second->getPosition();
-        int length = compo.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
+    auto it = m_compoPos.lower_bound(position);
+    if (it != m_compoPos.begin()) {
+        // Compositions don't overlap on a track, so only the previous one can intersect the start of the range
+        auto prev = std::prev(it);
+        if (prev->first + m_allCompositions.at(prev->second)->getPlaytime() - 1 >= position) {
+            ids.insert(prev->second);
         }
-        if (pos >= position || pos + length - 1 >= position) {
-            
-            ids.insert(compo.first);
+    }
+    for (; it != m_compoPos.end(); ++it) {
+        if (end > -1 && it->first >= end) {
+            break;
         }
+        ids.insert(it->second);
     }
     return ids;
 }
@@ -956,6 +1018,20 @@ bool TrackModel::checkConsistency()
         clips.emplace_back(c.second->getPosition(), c.first);
     }
     std::sort(clips.begin(), clips.end());
+    if (clips.size() != m_clipsByPosition.size() || clips.size() != m_playtimes.size()) {
+        qDebug() << "ERROR: the clip position index has" << m_clipsByPosition.size() << "entries, expected" << clips.size();
+        return false;
+    }
+    for (const auto &c : clips) {
+        if (m_clipsByPosition.count(c) == 0) {
+            qDebug() << "ERROR: clip" << c.second << "is missing from the position index at position" << c.first;
+            return false;
+        }
+        if (m_indexedPlaytimes.count(c.second) == 0 || m_indexedPlaytimes.at(c.second) != m_allClips[c.second]->getPlaytime()) {
+            qDebug() << "ERROR: the indexed playtime of clip" << c.second << "does not match its playtime" << m_allClips[c.second]->getPlaytime();
+            return false;
+        }
+    }
     int last_out = 0;
     for (size_t i = 0; i < clips.size(); ++i) {
         auto cur_clip = m_allClips[clips[i].second];
@@ -13,6 +13,7 @@
 #include <memory>
 #include <mlt++/MltPlaylist.h>
 #include <mlt++/MltTractor.h>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -307,6 +308,12 @@ protected:
     /** @brief Returns the list of the ids of the compositions that intersect the given range */
     std::unordered_set<int> getCompositionsInRange(int position, int end);
 
+    /** @brief Update the position index after a clip moved from oldPosition to newPosition on this track.
+       Pass -1 as oldPosition when the clip is inserted, and -1 as newPosition when it is removed */
+    void updateClipIndex(int clipId, int oldPosition, int newPosition);
+    /** @brief Update the indexed playtime of a clip of this track after its length changed */
+    void updateClipPlaytime(int clipId);
+
     /** @brief Import effects from a service that contains some (another track) */
     bool importEffects(std::weak_ptr<Mlt::Service> service);
     /** @brief Copy effects from another effect stack */
@@ -349,6 +356,13 @@ private:
 
     /** This is important to keep an ordered structure to store the clips, since we use their ids order as row order*/
     std::map<int, std::shared_ptr<ClipModel>> m_allClips;
+    /** We keep the clips sorted by {position, id} so that range and collision queries don't have to walk all the clips of the track */
+    std::set<std::pair<int, int>> m_clipsByPosition;
+    /** Playtime of each indexed clip, and all these playtimes sorted. Any clip intersecting a frame starts at most
+     *  the longest playtime before it, which bounds the range queries on m_clipsByPosition
+     */
+    std::unordered_map<int, int> m_indexedPlaytimes;
+    std::multiset<int> m_playtimes;
     /** This is important to keep an ordered structure to store the compositions, since we use their ids order as row order*/
     std::map<int, std::shared_ptr<CompositionModel>> m_allCompositions;
 
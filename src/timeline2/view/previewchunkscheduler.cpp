@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "previewchunkscheduler.h"
+
+#include <algorithm>
+#include <QtGlobal>
+
+PreviewChunkScheduler::PreviewChunkScheduler(int chunkSize)
+    : m_chunkSize(qMax(1, chunkSize))
+    , m_playhead(0)
+{
+}
+
+void PreviewChunkScheduler::setChunkSize(int chunkSize)
+{
+    m_chunkSize = qMax(1, chunkSize);
+}
+
+void PreviewChunkScheduler::setPlayhead(int position)
+{
+    m_playhead = qMax(0, position);
+}
+
+int PreviewChunkScheduler::playhead() const
+{
+    return m_playhead;
+}
+
+void PreviewChunkScheduler::setZone(const QPoint &zone)
+{
+    m_zone = zone;
+}
+
+int PreviewChunkScheduler::distance(int chunk, int start) const
+{
+    int startChunk = start - start % m_chunkSize;
+    int count = (chunk - startChunk) / m_chunkSize;
+    if (count >= 0) {
+        // Chunks after the start are watched first
+        return 2 * count;
+    }
+    // Chunks before the start only count after the following ones at twice their distance
+    return -4 * count - 1;
+}
+
+int PreviewChunkScheduler::priority(int chunk) const
+{
+    int result = distance(chunk, m_playhead);
+    bool validZone = m_zone.y() > m_zone.x();
+    bool playheadInZone = m_playhead >= m_zone.x() && m_playhead < m_zone.y();
+    if (validZone && !playheadInZone && chunk + m_chunkSize > m_zone.x() && chunk < m_zone.y()) {
+        // Playing the zone starts at its beginning, at equal distance the playhead wins
+        result = qMin(result, distance(chunk, m_zone.x()) + 1);
+    }
+    return result;
+}
+
+void PreviewChunkScheduler::sort(QList<int> &chunks) const
+{
+    std::stable_sort(chunks.begin(), chunks.end(), [this](int a, int b) {
+        int priorityA = priority(a);
+        int priorityB = priority(b);
+        return priorityA < priorityB || (priorityA == priorityB && a < b);
+    });
+}
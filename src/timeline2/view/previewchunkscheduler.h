@@ -0,0 +1,41 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef PREVIEWCHUNKSCHEDULER_H
+#define PREVIEWCHUNKSCHEDULER_H
+
+#include <QList>
+#include <QPoint>
+
+/** @class PreviewChunkScheduler
+    @brief Orders the timeline preview chunks so that the ones the user is about to watch are rendered first.
+    Chunks are ordered by their distance to the playhead, chunks after the playhead coming first since
+    playback goes forward. When the playhead is outside of the timeline zone, the chunks of the zone are
+    also ordered by their distance to the zone start, where zone playback starts.
+ */
+class PreviewChunkScheduler
+{
+public:
+    explicit PreviewChunkScheduler(int chunkSize = 25);
+    void setChunkSize(int chunkSize);
+    void setPlayhead(int position);
+    int playhead() const;
+    /** @brief Set the timeline zone, a null zone is ignored */
+    void setZone(const QPoint &zone);
+    /** @brief Returns the priority of the chunk starting at frame @param chunk, lower values are rendered first */
+    int priority(int chunk) const;
+    /** @brief Sort the chunks by priority, the most urgent first */
+    void sort(QList<int> &chunks) const;
+
+private:
+    int m_chunkSize;
+    int m_playhead;
+    QPoint m_zone;
+    /** @brief Priority of a chunk relative to the chunk where playback starts */
+    int distance(int chunk, int start) const;
+};
+
+#endif
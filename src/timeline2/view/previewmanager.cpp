@@ -21,6 +21,19 @@
 #include <QProcess>
 #include <QMutexLocker>
 #include <QStandardPaths>
+#include <QThread>
+#include <climits>
+
+namespace {
+// Maximum number of chunks given to a process at once, so that the queue order is regularly re-evaluated
+const int maxChunksPerProcess = 10;
+// Threads per encoder when the preview profile lets the encoder decide
+const int defaultEncoderThreads = 4;
+// A chunk that failed to render is rendered again once before aborting
+const int maxChunkRetries = 1;
+// Chunks with a lower priority are worth restarting a process for (the chunks around the playhead)
+const int preemptPriority = 4;
+} // namespace
 
 PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tractor)
     : QObject()
@@ -30,12 +43,11 @@ PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tra
     , m_previewTrack(nullptr)
     , m_overlayTrack(nullptr)
     , m_previewTrackIndex(-1)
+    , m_abortingRender(false)
     , m_initialized(false)
 {
     m_previewGatherTimer.setSingleShot(true);
     m_previewGatherTimer.setInterval(200);
-    QObject::connect(&m_previewProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &PreviewManager::processEnded);
-
 
     // Find path for Kdenlive renderer
 #ifdef Q_OS_WIN
@@ -49,8 +61,6 @@ PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tra
             KMessageBox::sorry(pCore->window(), i18n("Could not find the kdenlive_render application, something is wrong with your installation. Rendering will not work"));
         }
     }
-    connect(this, &PreviewManager::abortPreview, &m_previewProcess, &QProcess::kill, Qt::DirectConnection);
-    connect(&m_previewProcess, &QProcess::readyReadStandardError, this, &PreviewManager::receivedStderr);
 }
 
 PreviewManager::~PreviewManager()
@@ -112,6 +122,10 @@ bool PreviewManager::initialize()
     connect(&m_previewTimer, &QTimer::timeout, this, &PreviewManager::startPreviewRender);
     connect(this, &PreviewManager::previewRender, this, &PreviewManager::gotPreviewRender, Qt::DirectConnection);
     connect(&m_previewGatherTimer, &QTimer::timeout, this, &PreviewManager::slotProcessDirtyChunks);
+    m_rescheduleTimer.setSingleShot(true);
+    m_rescheduleTimer.setInterval(500);
+    connect(&m_rescheduleTimer, &QTimer::timeout, this, &PreviewManager::slotReschedule);
+    connect(pCore->getMonitor(Kdenlive::ProjectMonitor), &Monitor::seekPosition, this, &PreviewManager::slotPlayheadMoved);
     m_initialized = true;
     return true;
 }
@@ -479,12 +493,12 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
     if (add) {
         qDebug() << "CHUNKS CHANGED: " << m_dirtyChunks;
         emit m_controller->dirtyChunksChanged();
-        if (m_previewProcess.state() == QProcess::NotRunning && KdenliveSettings::autopreview()) {
+        if (!isRendering() && KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     } else {
         // Remove processed chunks
-        bool isRendering = m_previewProcess.state() != QProcess::NotRunning;
+        bool wasRendering = isRendering();
         m_previewGatherTimer.stop();
         abortRendering();
         m_tractor->lock();
@@ -506,7 +520,7 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
         emit m_controller->renderedChunksChanged();
         emit m_controller->dirtyChunksChanged();
         m_tractor->unlock();
-        if (isRendering || KdenliveSettings::autopreview()) {
+        if (wasRendering || KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     }
@@ -514,15 +528,22 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
 
 void PreviewManager::abortRendering()
 {
-    if (m_previewProcess.state() == QProcess::NotRunning) {
+    if (m_abortingRender || !isRendering()) {
         return;
     }
+    m_abortingRender = true;
     emit abortPreview();
-    m_previewProcess.waitForFinished();
-    if (m_previewProcess.state() != QProcess::NotRunning) {
-        m_previewProcess.kill();
-        m_previewProcess.waitForFinished();
+    for (auto &worker : m_workers) {
+        worker.process->waitForFinished();
+        if (worker.process->state() != QProcess::NotRunning) {
+            worker.process->kill();
+            worker.process->waitForFinished();
+        }
     }
+    m_dirtyMutex.lock();
+    m_renderQueue.clear();
+    m_dirtyMutex.unlock();
+    m_abortingRender = false;
     // Re-init time estimation
     emit previewRender(-1, QString(), 1000);
 }
@@ -561,20 +582,27 @@ void PreviewManager::startPreviewRender()
 
         }
         m_previewTimer.stop();
-        doPreviewRender(sceneList);
+        m_scheduler.setPlayhead(pCore->getTimelinePosition());
+        doPreviewRender();
     }
 }
 
-void PreviewManager::receivedStderr()
+void PreviewManager::receivedStderr(int ix)
 {
-    QStringList resultList = QString::fromLocal8Bit(m_previewProcess.readAllStandardError()).split(QLatin1Char('\n'));
+    RenderWorker &worker = m_workers[size_t(ix)];
+    QStringList resultList = QString::fromLocal8Bit(worker.process->readAllStandardError()).split(QLatin1Char('\n'));
     resultList.removeAll(QString(""));
     for (auto &result : resultList) {
         if (result.startsWith(QLatin1String("START:"))) {
-            workingPreview = result.section(QLatin1String("START:"), 1).simplified().toInt();
+            worker.current = result.section(QLatin1String("START:"), 1).simplified().toInt();
+            workingPreview = worker.current;
             emit m_controller->workingPreviewChanged();
         } else if (result.startsWith(QLatin1String("DONE:"))) {
             int chunk = result.section(QLatin1String("DONE:"), 1).simplified().toInt();
+            worker.chunks.removeAll(chunk);
+            if (worker.current == chunk) {
+                worker.current = -1;
+            }
             m_processedChunks++;
             QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
             qDebug() << "---------------\nJOB PROGRRESS: " << m_chunksToRender << ", " << m_processedChunks << " = "
@@ -586,54 +614,272 @@ void PreviewManager::receivedStderr()
     }
 }
 
-void PreviewManager::doPreviewRender(const QString &scene)
+bool PreviewManager::isRendering() const
 {
-    // initialize progress bar
-    if (m_dirtyChunks.isEmpty()) {
-        return;
+    for (const auto &worker : m_workers) {
+        if (worker.process->state() != QProcess::NotRunning) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int PreviewManager::encoderThreads() const
+{
+    for (const QString &param : m_consumerParams) {
+        if (param.startsWith(QLatin1String("threads="))) {
+            int threads = param.section(QLatin1Char('='), 1).toInt();
+            if (threads > 0) {
+                return threads;
+            }
+        }
+    }
+    return defaultEncoderThreads;
+}
+
+int PreviewManager::workerCount() const
+{
+    if (KdenliveSettings::previewworkers() > 0) {
+        return KdenliveSettings::previewworkers();
+    }
+    return qMax(1, QThread::idealThreadCount() / encoderThreads());
+}
+
+void PreviewManager::createWorkers(int count)
+{
+    m_workers.clear();
+    m_workers.resize(size_t(count));
+    for (int i = 0; i < count; i++) {
+        m_workers[size_t(i)].process.reset(new QProcess());
+        QProcess *process = m_workers[size_t(i)].process.get();
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this, i](int exitCode, QProcess::ExitStatus status) { processEnded(i, exitCode, status); });
+        connect(process, &QProcess::readyReadStandardError, this, [this, i]() { receivedStderr(i); });
+        connect(this, &PreviewManager::abortPreview, process, &QProcess::kill, Qt::DirectConnection);
+    }
+}
+
+QList<int> PreviewManager::nextChunks()
+{
+    // Chunks may have been rendered or removed from the preview zone since the render started
+    QList<int> available;
+    for (int chunk : qAsConst(m_renderQueue)) {
+        if (m_dirtyChunks.contains(chunk)) {
+            available << chunk;
+        }
+    }
+    m_scheduler.setChunkSize(KdenliveSettings::timelinechunks());
+    m_scheduler.setZone(QPoint(m_controller->zoneIn(), m_controller->zoneOut()));
+    m_scheduler.sort(available);
+    // Share the remaining chunks between the processes
+    int count = qBound(1, available.count() / int(m_workers.size()), maxChunksPerProcess);
+    QList<int> chunks = available.mid(0, count);
+    m_renderQueue = available.mid(count);
+    return chunks;
+}
+
+bool PreviewManager::startWorker(int ix)
+{
+    RenderWorker &worker = m_workers[size_t(ix)];
+    m_dirtyMutex.lock();
+    worker.chunks = nextChunks();
+    m_dirtyMutex.unlock();
+    if (worker.chunks.isEmpty()) {
+        return false;
+    }
+    QStringList chunks;
+    for (int chunk : qAsConst(worker.chunks)) {
+        chunks << QString::number(chunk);
+    }
+    QStringList consumerParams = m_consumerParams;
+    if (m_workers.size() > 1) {
+        // Share the cores between the processes instead of letting each encoder use all of them
+        for (int i = consumerParams.count() - 1; i >= 0; i--) {
+            if (consumerParams.at(i).startsWith(QLatin1String("threads="))) {
+                consumerParams.removeAt(i);
+            }
+        }
+        consumerParams << QStringLiteral("threads=%1").arg(encoderThreads());
     }
-    QMutexLocker lock(&m_dirtyMutex);
-    Q_ASSERT(m_previewProcess.state() == QProcess::NotRunning);
-    std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end());
-    qDebug()<<":: got dirty chks: "<<m_dirtyChunks;
-    const QStringList dirtyChunks = getCompressedList(m_dirtyChunks);
-    m_chunksToRender = m_dirtyChunks.count();
-    m_processedChunks = 0;
     int chunkSize = KdenliveSettings::timelinechunks();
     QStringList args{KdenliveSettings::rendererpath(),
-                     scene,
+                     m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt")),
                      m_cacheDir.absolutePath(),
                      QStringLiteral("-split"),
-                     dirtyChunks.join(QLatin1Char(',')),
+                     chunks.join(QLatin1Char(',')),
                      QString::number(chunkSize - 1),
                      pCore->getCurrentProfilePath(),
                      m_extension,
-                     m_consumerParams.join(QLatin1Char(' '))};
+                     consumerParams.join(QLatin1Char(' '))};
     qDebug() << " -  - -STARTING PREVIEW JOBS: " << args;
+    worker.process->start(m_renderer, args);
+    if (!worker.process->waitForStarted()) {
+        // Leave the chunks to the other processes
+        m_dirtyMutex.lock();
+        m_renderQueue << worker.chunks;
+        m_dirtyMutex.unlock();
+        worker.chunks.clear();
+        return false;
+    }
+    qDebug() << " -  - -STARTING PREVIEW JOBS . . . STARTED";
+    return true;
+}
+
+void PreviewManager::slotPlayheadMoved(int position)
+{
+    m_scheduler.setPlayhead(position);
+    if (!m_rescheduleTimer.isActive() && isRendering()) {
+        m_rescheduleTimer.start();
+    }
+}
+
+void PreviewManager::slotReschedule()
+{
+    if (m_abortingRender || !isRendering()) {
+        return;
+    }
+    QMutexLocker lock(&m_dirtyMutex);
+    // Sort the queue without taking chunks from it
+    QList<int> queue;
+    for (int chunk : qAsConst(m_renderQueue)) {
+        if (m_dirtyChunks.contains(chunk)) {
+            queue << chunk;
+        }
+    }
+    m_scheduler.setChunkSize(KdenliveSettings::timelinechunks());
+    m_scheduler.setZone(QPoint(m_controller->zoneIn(), m_controller->zoneOut()));
+    m_scheduler.sort(queue);
+    m_renderQueue = queue;
+    if (queue.isEmpty() || m_scheduler.priority(queue.first()) >= preemptPriority) {
+        return;
+    }
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        if (m_workers[i].process->state() == QProcess::NotRunning) {
+            // An idle process can take it
+            lock.unlock();
+            startWorker(int(i));
+            return;
+        }
+    }
+    // A chunk the user is about to watch waits in the queue, restart the process with the least urgent chunks
+    const int urgent = m_scheduler.priority(queue.first());
+    int preempt = -1;
+    int preemptBest = urgent;
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        const RenderWorker &worker = m_workers[i];
+        if (worker.preempted || worker.process->state() == QProcess::NotRunning) {
+            continue;
+        }
+        int best = worker.current >= 0 ? m_scheduler.priority(worker.current) : INT_MAX;
+        for (int chunk : worker.chunks) {
+            best = qMin(best, m_scheduler.priority(chunk));
+        }
+        if (best > preemptBest) {
+            preemptBest = best;
+            preempt = int(i);
+        }
+    }
+    lock.unlock();
+    if (preempt >= 0) {
+        qDebug() << "// Restarting preview process to render chunk" << queue.first();
+        m_workers[size_t(preempt)].preempted = true;
+        m_workers[size_t(preempt)].process->kill();
+    }
+}
+
+void PreviewManager::updateWorkingPreview()
+{
+    int current = -1;
+    for (const auto &worker : m_workers) {
+        if (worker.current >= 0 && (current < 0 || worker.current == workingPreview)) {
+            current = worker.current;
+        }
+    }
+    if (current != workingPreview) {
+        workingPreview = current;
+        emit m_controller->workingPreviewChanged();
+    }
+}
+
+void PreviewManager::doPreviewRender()
+{    // initialize progress bar
+    QMutexLocker lock(&m_dirtyMutex);
+    if (m_dirtyChunks.isEmpty()) {
+        return;
+    }
+    Q_ASSERT(!isRendering());
+    qDebug()<<":: got dirty chks: "<<m_dirtyChunks;
+    m_renderQueue.clear();
+    for (const auto &chunk : qAsConst(m_dirtyChunks)) {
+        m_renderQueue << chunk.toInt();
+    }
+    m_chunksToRender = m_dirtyChunks.count();
+    m_processedChunks = 0;
+    m_chunkFailures.clear();
+    int workers = qMin(workerCount(), m_chunksToRender);
+    if (int(m_workers.size()) != workers) {
+        createWorkers(workers);
+    }
+    lock.unlock();
     pCore->currentDoc()->previewProgress(0);
-    m_previewProcess.start(m_renderer, args);
-    if (m_previewProcess.waitForStarted()) {
-        qDebug() << " -  - -STARTING PREVIEW JOBS . . . STARTED";
+    for (int i = 0; i < workers; i++) {
+        startWorker(i);
+    }
+    if (!isRendering()) {
+        pCore->currentDoc()->previewProgress(-1);
     }
 }
 
-void PreviewManager::processEnded(int exitCode, QProcess::ExitStatus status)
+void PreviewManager::processEnded(int ix, int exitCode, QProcess::ExitStatus status)
 {
+    RenderWorker &worker = m_workers[size_t(ix)];
+    int failedChunk = worker.current;
+    bool failed = status == QProcess::CrashExit || exitCode != 0;
+    worker.current = -1;
+    if (worker.preempted) {
+        // The process was stopped on purpose, its chunk is rendered later
+        worker.preempted = false;
+        if (!m_abortingRender && failedChunk >= 0) {
+            m_cacheDir.remove(QStringLiteral("%1.%2").arg(failedChunk).arg(m_extension));
+            failedChunk = -1;
+        }
+        failed = false;
+    }
+    // The chunks that were not rendered are still dirty, give them to the next process
+    worker.chunks.removeAll(failedChunk);
+    m_dirtyMutex.lock();
+    m_renderQueue << worker.chunks;
+    m_dirtyMutex.unlock();
+    worker.chunks.clear();
+    if (failed && failedChunk >= 0) {
+        const QString fileName = QStringLiteral("%1.%2").arg(failedChunk).arg(m_extension);
+        if (m_abortingRender) {
+            m_cacheDir.remove(fileName);
+        } else {
+            // Queue the chunk again, or abort if it already crashed a process
+            corruptedChunk(failedChunk, fileName);
+        }
+    }
+    // A process failing before it starts a chunk would fail again, do not restart it
+    if (!m_abortingRender && (!failed || failedChunk >= 0) && startWorker(ix)) {
+        updateWorkingPreview();
+        return;
+    }
+    updateWorkingPreview();
+    if (isRendering()) {
+        return;
+    }
     const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
     QFile::remove(sceneList);
-    if (status == QProcess::QProcess::CrashExit) {
+    if (failed) {
         pCore->currentDoc()->previewProgress(-1);
-        if (workingPreview >= 0) {
-            const QString fileName = QStringLiteral("%1.%2").arg(workingPreview).arg(m_extension);
-            if (m_cacheDir.exists(fileName)) {
-                m_cacheDir.remove(fileName);
-            }
+        if (!m_abortingRender && failedChunk < 0) {
+            // The process could not even start rendering
+            emit previewRender(0, m_errorLog, -1);
         }
     } else {
         pCore->currentDoc()->previewProgress(1000);
     }
-    workingPreview = -1;
-    emit m_controller->workingPreviewChanged();
 }
 
 void PreviewManager::slotProcessDirtyChunks()
@@ -677,7 +923,7 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
 
     std::sort(m_renderedChunks.begin(), m_renderedChunks.end());
     m_previewGatherTimer.stop();
-    bool stopPreview = m_previewProcess.state() == QProcess::Running;
+    bool stopPreview = isRendering();
     if (m_renderedChunks.isEmpty() || ((workingPreview < m_renderedChunks.first().toInt() || workingPreview > m_renderedChunks.last().toInt()) && (end < m_renderedChunks.first().toInt() || start > m_renderedChunks.last().toInt()))) {
         // invalidated zone is not in the preview zone, don't stop process
         stopPreview = false;
@@ -786,19 +1032,27 @@ void PreviewManager::gotPreviewRender(int frame, const QString &file, int progre
 
 void PreviewManager::corruptedChunk(int frame, const QString &fileName)
 {
-    emit abortPreview();
-    m_previewProcess.waitForFinished();
-    if (workingPreview >= 0) {
-        workingPreview = -1;
-        emit m_controller->workingPreviewChanged();
-    }
-    emit previewRender(0, m_errorLog, -1);
     m_cacheDir.remove(fileName);
+    QMutexLocker lock(&m_dirtyMutex);
     if (!m_dirtyChunks.contains(frame)) {
-        QMutexLocker lock(&m_dirtyMutex);
         m_dirtyChunks << frame;
         std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end());
     }
+    if (m_abortingRender) {
+        return;
+    }
+    if (++m_chunkFailures[frame] <= maxChunkRetries) {
+        // Another process renders it again
+        m_renderQueue << frame;
+        m_chunksToRender++;
+        return;
+    }
+    // The chunk keeps failing, the render parameters are probably wrong
+    m_renderQueue.clear();
+    lock.unlock();
+    abortRendering();
+    updateWorkingPreview();
+    emit previewRender(0, m_errorLog, -1);
 }
 
 int PreviewManager::setOverlayTrack(Mlt::Playlist *overlay)
@@ -8,12 +8,16 @@
 #define PREVIEWMANAGER_H
 
 #include "definitions.h"
+#include "previewchunkscheduler.h"
 
 #include <QDir>
 #include <QFuture>
+#include <QHash>
 #include <QMutex>
 #include <QProcess>
 #include <QTimer>
+#include <memory>
+#include <vector>
 
 class TimelineController;
 
@@ -30,6 +34,10 @@ class Producer;
     This allow us to get a preview with a smooth playback of our project.
     Only the preview zone is rendered. Once defined, a preview zone shows as a red line below
     the timeline ruler. As chunks are rendered, the zone turns to green.
+    Chunks are rendered by several kdenlive_render processes in parallel. Each process takes a
+    small batch of the most urgent dirty chunks (see PreviewChunkScheduler), then asks for the
+    next batch. When the playhead moves, a process busy with chunks far from it is restarted
+    so that the chunk under the playhead is rendered first.
  */
 class PreviewManager : public QObject
 {
@@ -85,8 +93,29 @@ private:
     int m_previewTrackIndex;
     /** @brief: The kdenlive renderer app. */
     QString m_renderer;
-    /** @brief: The kdenlive timeline preview process. */
-    QProcess m_previewProcess;
+    /** @brief: A kdenlive_render process rendering a batch of chunks. */
+    struct RenderWorker
+    {
+        std::unique_ptr<QProcess> process;
+        /** @brief: The chunks given to this process that are not rendered yet */
+        QList<int> chunks;
+        /** @brief: The chunk being rendered, -1 if none */
+        int current{-1};
+        /** @brief: The process was stopped to render more urgent chunks */
+        bool preempted{false};
+    };
+    /** @brief: The timeline preview processes. */
+    std::vector<RenderWorker> m_workers;
+    /** @brief: The chunks of the current render that were not given to a process yet. */
+    QList<int> m_renderQueue;
+    /** @brief: How many times each chunk failed to render during the current render. */
+    QHash<int, int> m_chunkFailures;
+    /** @brief: True while the processes are being stopped, so that they are not restarted. */
+    bool m_abortingRender;
+    /** @brief: Decides which chunks are rendered first. */
+    PreviewChunkScheduler m_scheduler;
+    /** @brief: Limits how often the render queue is re-evaluated while the playhead moves. */
+    QTimer m_rescheduleTimer;
     /** @brief: The directory used to store the preview files. */
     QDir m_cacheDir;
     /** @brief: The directory used to store undo history of preview files (child of m_cacheDir). */
@@ -109,8 +138,22 @@ private:
     QString m_errorLog;
     /** @brief: After an undo/redo, if we have preview history, use it. */
     void reloadChunks(const QVariantList &chunks);
-    /** @brief: A chunk failed to render, abort. */
+    /** @brief: A chunk failed to render, render it again or abort if it already failed before. */
     void corruptedChunk(int workingPreview, const QString &fileName);
+    /** @brief: True if a preview process is running. */
+    bool isRendering() const;
+    /** @brief: The number of processes to use, from the settings or from the encoder threads. */
+    int workerCount() const;
+    /** @brief: The number of threads used by each encoder. */
+    int encoderThreads() const;
+    /** @brief: Replace the preview processes, only called when none is running. */
+    void createWorkers(int count);
+    /** @brief: Give the next batch of chunks to a process and start it, returns false if there is nothing left to render. */
+    bool startWorker(int ix);
+    /** @brief: Take the next chunks to render from the render queue. m_dirtyMutex must be locked. */
+    QList<int> nextChunks();
+    /** @brief: Show the chunk of a running process on the ruler. */
+    void updateWorkingPreview();
     /** @brief: Re-enable timeline preview track. */
     void enable();
     /** @brief: Temporarily disable timeline preview track. */
@@ -121,15 +164,20 @@ private:
 private slots:
     /** @brief: To avoid filling the hard drive, remove preview undo history after 5 steps. */
     void doCleanupOldPreviews();
-    /** @brief: Start the real rendering process. */
-    void doPreviewRender(const QString &scene); // std::shared_ptr<Mlt::Producer> sourceProd);
+    /** @brief: Start the rendering processes on the scene saved in preview.mlt. */
+    void doPreviewRender();
     /** @brief: If user does an undo, then makes a new timeline operation, delete undo history of more recent stack . */
     void slotRemoveInvalidUndo(int ix);
     /** @brief: When the timer collecting invalid zones is done, process. */
     void slotProcessDirtyChunks();
+    /** @brief: The timeline playhead moved, re-evaluate the render queue. */
+    void slotPlayheadMoved(int position);
+    /** @brief: Sort the render queue and restart a process if the chunk under the playhead waits. */
+    void slotReschedule();
     /** @brief: Process preview rendering output. */
-    void receivedStderr();
-    void processEnded(int, QProcess::ExitStatus status);
+    void receivedStderr(int ix);
+    /** @brief: A preview process ended, give it the next chunks. */
+    void processEnded(int ix, int exitCode, QProcess::ExitStatus status);
 
 public slots:
     /** @brief: Prepare and start rendering. */
@@ -9,6 +9,7 @@
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioLevels.h"
 #include <QElapsedTimer>
 #include <QPainter>
 #include <QPainterPath>
@@ -110,6 +111,7 @@ public:
                 } else {
                     // Clip changed, reset levels
                     m_audioLevels.clear();
+                    m_levelsPyramid = AudioLevels();
                 }
             }
         });
@@ -130,6 +132,7 @@ public:
             if (m_audioLevels.isEmpty()) {
                 return;
             }
+            m_levelsPyramid = pCore->projectItemModel()->getAudioLevelsPyramidByBinID(m_binId, m_stream);
             m_audioMax = KdenliveSettings::normalizechannels() ? pCore->projectItemModel()->getAudioMaxLevel(m_binId, m_stream) : 0;
         }
 
@@ -165,6 +168,15 @@ public:
         }
         bool reverse = m_speed < 0;
         int maxLength = m_audioLevels.length();
+        // When zoomed out, several frames are covered by each drawn step: read the max level of these frames
+        // from the matching decimation instead of sampling a single frame
+        int decimation = 0;
+        if (m_levelsPyramid.channels() == m_channels) {
+            double framesPerStep = increment * qAbs(m_speed) / m_scale;
+            while (decimation < m_levelsPyramid.decimationCount() && (2 << decimation) <= framesPerStep) {
+                decimation++;
+            }
+        }
         if (reverse) {
             m_inPoint = qMin(m_inPoint, maxLength - m_channels);
         }
@@ -192,9 +204,9 @@ public:
                 if (idx + m_channels >= maxLength || idx < 0) {
                     break;
                 }
-                level = m_audioLevels.at(idx) / scaleFactor;
+                level = levelAt(idx, decimation) / scaleFactor;
                 for (int k = 1; k < m_channels; k++) {
-                    level = qMax(level, m_audioLevels.at(idx + k) / scaleFactor);
+                    level = qMax(level, levelAt(idx + k, decimation) / scaleFactor);
                 }
                 if (pathDraw) {
                     double val = height() - level * height();
@@ -253,10 +265,10 @@ public:
                     idx += channel;
                     if (idx >= maxLength || idx < 0) break;
                     if (pathDraw) {
-                        level = m_audioLevels.at(idx) * scaleFactor;
+                        level = levelAt(idx, decimation) * scaleFactor;
                         path.lineTo(i, y - level);
                     } else {
-                        level = m_audioLevels.at(idx) * scaleFactor; // divide height by 510 (2*255) to get height
+                        level = levelAt(idx, decimation) * scaleFactor; // divide height by 510 (2*255) to get height
                         painter->drawLine(int(i), int(y - level), int(i), int(y + level));
                     }
                 }
@@ -282,7 +294,21 @@ signals:
     void audioChannelsChanged();
 
 private:
+    /** @brief Returns the level at index idx of the raw levels, or the max level of the block
+        of 2^decimation frames containing it */
+    uint8_t levelAt(int idx, int decimation) const
+    {
+        if (decimation == 0) {
+            return m_audioLevels.at(idx);
+        }
+        const QVector<uint8_t> &levels = m_levelsPyramid.decimation(decimation);
+        int entry = (idx / m_channels) >> decimation;
+        int pos = entry * m_channels + idx % m_channels;
+        return pos < levels.size() ? levels.at(pos) : m_audioLevels.at(idx);
+    }
+
     QVector<uint8_t> m_audioLevels;
+    AudioLevels m_levelsPyramid;
     int m_inPoint;
     int m_outPoint;
     QString m_binId;
@@ -6,49 +6,93 @@
 */
 
 #include "thumbnailprovider.h"
-#include "bin/projectclip.h"
-#include "bin/projectitemmodel.h"
-#include "core.h"
-#include "doc/kthumb.h"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailgenerator.hpp"
 
 #include <QCryptographicHash>
 #include <QDebug>
-#include <QQuickImageProvider>
-#include <mlt++/MltFilter.h>
-#include <mlt++/MltProfile.h>
+#include <QMutex>
 
-ThumbnailProvider::ThumbnailProvider()
-    : QQuickImageProvider(QQmlImageProviderBase::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
+namespace {
+class ThumbnailResponse : public QQuickImageResponse
 {
-}
+public:
+    ThumbnailResponse() = default;
+
+    // Called by the generator, or directly for cached thumbnails
+    void setImage(const QImage &img)
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_finished) {
+            return;
+        }
+        m_image = img;
+        m_finished = true;
+        lock.unlock();
+        emit finished();
+    }
+
+    void setRequest(std::shared_ptr<ThumbnailRequest> request)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_request = std::move(request);
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        QMutexLocker lock(&m_mutex);
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    void cancel() override
+    {
+        QMutexLocker lock(&m_mutex);
+        std::shared_ptr<ThumbnailRequest> request = m_request;
+        lock.unlock();
+        // Once cancelled, the generator does not use this response anymore
+        if (request) {
+            request->cancel();
+        }
+        // The engine still waits for finished() to delete the response
+        setImage(QImage());
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QImage m_image;
+    bool m_finished{false};
+    std::shared_ptr<ThumbnailRequest> m_request;
+};
+} // namespace
+
+ThumbnailProvider::ThumbnailProvider() = default;
 
 ThumbnailProvider::~ThumbnailProvider() = default;
 
-QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+QQuickImageResponse *ThumbnailProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
 {
-    QImage result;
+    Q_UNUSED(requestedSize)
+    auto *response = new ThumbnailResponse();
     // id is binID/#frameNumber
     QString binId = id.section('/', 0, 0);
     bool ok;
     int frameNumber = id.section('#', -1).toInt(&ok);
-    if (ok) {
-        if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false)) {
-            result = ThumbnailCache::get()->getThumbnail(binId, frameNumber);
-            *size = result.size();
-            return result;
-        }
-        std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
-        if (binClip) {
-            std::shared_ptr<Mlt::Producer> prod = binClip->thumbProducer();
-            if (prod && prod->is_valid()) {
-                result = makeThumbnail(prod, frameNumber, requestedSize);
-                ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false);
-            }
-        }
+    if (!ok) {
+        response->setImage(QImage());
+        return response;
+    }
+    if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false)) {
+        response->setImage(ThumbnailCache::get()->getThumbnail(binId, frameNumber));
+        return response;
     }
-    if (size) *size = result.size();
-    return result;
+    response->setRequest(ThumbnailGenerator::get()->request(binId, frameNumber, [response, binId](const QImage &img, int frame) {
+        // The thumbnail may have been extracted for a neighbour frame, only cache it for that one
+        if (!img.isNull()) {
+            ThumbnailCache::get()->storeThumbnail(binId, frame, img, false);
+        }
+        response->setImage(img);
+    }));
+    return response;
 }
 
 QString ThumbnailProvider::cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber)
@@ -68,18 +112,3 @@ QString ThumbnailProvider::cacheKey(Mlt::Properties &properties, const QString &
     }
     return key;
 }
-
-QImage ThumbnailProvider::makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize)
-{
-    Q_UNUSED(requestedSize)
-    producer->seek(frameNumber);
-    QScopedPointer<Mlt::Frame> frame(producer->get_frame());
-    if (frame == nullptr || !frame->is_valid()) {
-        return QImage();
-    }
-    // TODO: cache these values ?
-    int imageHeight = pCore->thumbProfile()->height();
-    int imageWidth = pCore->thumbProfile()->width();
-    int fullWidth = qRound(imageHeight * pCore->getCurrentDar());
-    return KThumb::getFrame(frame.data(), imageWidth, imageHeight, fullWidth);
-}
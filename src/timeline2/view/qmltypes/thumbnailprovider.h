@@ -8,22 +8,21 @@
 #ifndef THUMBNAILPROVIDER_H
 #define THUMBNAILPROVIDER_H
 
-#include <KImageCache>
-#include <QCache>
-#include <QQuickImageProvider>
-#include <memory>
-#include <mlt++/MltProducer.h>
-#include <mlt++/MltProfile.h>
+#include <QQuickAsyncImageProvider>
+#include <mlt++/MltProperties.h>
 
-class ThumbnailProvider : public QQuickImageProvider
+/** @class ThumbnailProvider
+    @brief Serves the clip thumbnails to QML. Thumbnails that are not cached are extracted
+    by the ThumbnailGenerator, and their extraction is cancelled when QML does not need them anymore.
+ */
+class ThumbnailProvider : public QQuickAsyncImageProvider
 {
 public:
     explicit ThumbnailProvider();
     ~ThumbnailProvider() override;
-    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
 
 private:
-    QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize);
     QString cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber);
 };
 
@@ -4837,6 +4837,7 @@ void TimelineController::exportSubtitle()
     if (subtitleModel == nullptr) {
         return;
     }
+    subtitleModel->flushSubtitleFile();
     QString currentSub = subtitleModel->getUrl();
     if (currentSub.isEmpty()) {
         pCore->displayMessage(i18n("No subtitles in current project"), ErrorMessage);
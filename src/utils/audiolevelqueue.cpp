@@ -0,0 +1,35 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audiolevelqueue.hpp"
+
+bool AudioLevelQueue::push(const MeterLevels &levels)
+{
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    // Acquire so that the consumer is done reading the entry before it is overwritten
+    if (head - m_tail.load(std::memory_order_acquire) >= capacity) {
+        return false;
+    }
+    m_entries[head % capacity] = levels;
+    // Release so that the consumer sees the entry once it sees the new head
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool AudioLevelQueue::pop(MeterLevels &levels)
+{
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    levels = m_entries[tail % capacity];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void AudioLevelQueue::discard()
+{
+    m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+}
@@ -0,0 +1,47 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/** @brief Audio levels of one frame, as sent to the meters */
+struct MeterLevels
+{
+    static constexpr int maxChannels = 8;
+    /** @brief Position of the frame, -1 if the entry is empty */
+    int position{-1};
+    int channels{0};
+    std::array<double, maxChannels> values{};
+};
+
+/** @class AudioLevelQueue
+    @brief Fixed size lock-free queue carrying the audio levels from the MLT audio thread to the GUI.
+    There must be a single producer thread, calling push(), and a single consumer thread, calling the other methods.
+    The entries are preallocated: pushing and popping never allocates or blocks. When the consumer does not keep up, the
+    newest levels are dropped, since the meters only display the levels of the frame shown in the monitor.
+ */
+class AudioLevelQueue
+{
+public:
+    /** @brief Number of entries, about 2 seconds of levels at 60 fps */
+    static constexpr std::size_t capacity = 128;
+
+    /** @brief Producer side: append the levels of a frame, returns false if the queue is full */
+    bool push(const MeterLevels &levels);
+    /** @brief Consumer side: take the oldest levels, returns false if the queue is empty */
+    bool pop(MeterLevels &levels);
+    /** @brief Consumer side: drop all the queued levels */
+    void discard();
+
+private:
+    std::array<MeterLevels, capacity> m_entries;
+    // Index of the next entry written by the producer, only modified by the producer
+    std::atomic<std::size_t> m_head{0};
+    // Index of the next entry read by the consumer, only modified by the consumer
+    std::atomic<std::size_t> m_tail{0};
+};
@@ -0,0 +1,88 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "definitions.h"
+#include <QByteArray>
+#include <QDir>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+class QFile;
+
+/** @class FileHashCache
+    @brief Persistent cache of the clip file hashes, shared by all projects.
+    The hash stored in the documents is the MD5 of the first and last megabytes of the file. It is remembered with the
+    size and modification time of the file, so that loading a project does not read its clips again when they did not change.
+    When only the modification time changed (for example after a copy), a much faster non cryptographic hash of the same
+    data tells whether the MD5 must be computed again.
+    The file listings of the image sequence folders are also cached, keyed by the modification time of the folder.
+    All methods are thread safe, files are read without holding the lock so that several clips can be hashed in parallel.
+ * Note that this class is a Singleton
+ */
+class FileHashCache
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<FileHashCache> &get();
+    virtual ~FileHashCache();
+
+    /** @brief Get the MD5 hash and the size of a file, reading it only if it is not in the cache or changed.
+        Returns an empty hash if the file cannot be read */
+    QPair<QByteArray, qint64> hash(const QString &path);
+
+    /** @brief Get the list of files in a folder, as returned by QDir::entryList(QDir::Files) */
+    QStringList folderEntries(const QDir &dir);
+
+    /** @brief Write the cache to disk if it changed */
+    void save();
+
+    /** @brief Fast non cryptographic hash, used to check whether the content of a file changed */
+    static quint64 fingerprint(const QByteArray &data);
+
+    /** @brief Version of the cache file format, increase it when changing the file layout */
+    static const quint32 formatVersion;
+
+protected:
+    // Constructor is protected because class is a Singleton
+    explicit FileHashCache(const QString &cacheFile);
+
+    struct Entry
+    {
+        qint64 size;
+        qint64 modified;
+        quint64 fingerprint;
+        QByteArray md5;
+        // Entries that were not used for a long time are dropped when saving
+        qint64 lastUsed;
+    };
+    struct Folder
+    {
+        qint64 modified;
+        QStringList files;
+        qint64 lastUsed;
+    };
+
+    /** @brief Read the part of the file that is hashed: the first and last megabytes */
+    static QByteArray readHashedData(QFile &file);
+    void load();
+
+    QString m_cacheFile;
+    // Protects the members below
+    QMutex m_mutex;
+    std::unordered_map<QString, Entry> m_files;
+    std::unordered_map<QString, Folder> m_folders;
+    bool m_modified{false};
+
+    static std::unique_ptr<FileHashCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the cache only once;
+};
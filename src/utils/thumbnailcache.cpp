@@ -8,10 +8,16 @@
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "doc/kdenlivedoc.h"
+#include "kdenlivesettings.h"
 #include "project/projectmanager.h"
+#include "thumbnailstore.hpp"
+#include <QCoreApplication>
 #include <QDir>
 #include <QMutexLocker>
+#include <QStandardPaths>
+#include <QtConcurrent>
 #include <list>
+#include <mlt++/MltProfile.h>
 
 std::unique_ptr<ThumbnailCache> ThumbnailCache::instance;
 std::once_flag ThumbnailCache::m_onceFlag;
@@ -82,7 +88,15 @@ protected:
 
 ThumbnailCache::ThumbnailCache()
     : m_volatileCache(new Cache_t(10000000))
+    , m_persistentCache(new ThumbnailStore(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/thumbnails"),
+                                           qint64(KdenliveSettings::thumbnailcachesize()) * 1024 * 1024))
 {
+    m_loaders.setMaxThreadCount(2);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    m_loaders.waitForDone();
 }
 
 std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
@@ -102,8 +116,13 @@ bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOn
     if (!ok || volatileOnly) {
         return false;
     }
-    QDir thumbFolder = getDir(pos < 0, &ok);
-    return ok && thumbFolder.exists(key);
+    if (pos < 0) {
+        QDir thumbFolder = getDir(true, &ok);
+        return ok && thumbFolder.exists(key);
+    }
+    locker.unlock();
+    const QString packKey = getPackKey(binId, &ok);
+    return ok && (m_persistentCache->contains(packKey, pos) || hasLegacyThumbnail(key));
 }
 
 QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly) const
@@ -119,7 +138,6 @@ QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly
     }
     QDir thumbFolder = getDir(true, &ok);
     if (ok && thumbFolder.exists(key)) {
-        m_storedOnDisk[binId].push_back(-1);
         return QImage(thumbFolder.absoluteFilePath(key));
     }
     return QImage();
@@ -153,12 +171,39 @@ QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatile
     if (!ok || volatileOnly) {
         return QImage();
     }
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && thumbFolder.exists(key)) {
-        m_storedOnDisk[binId].push_back(pos);
-        return QImage(thumbFolder.absoluteFilePath(key));
+    // The persistent cache has its own locking, don't block other threads while it reads the disk
+    locker.unlock();
+    const QString packKey = getPackKey(binId, &ok);
+    if (!ok) {
+        return QImage();
     }
-    return QImage();
+    QImage result = m_persistentCache->image(packKey, pos);
+    if (result.isNull() && hasLegacyThumbnail(key)) {
+        // Thumbnail from a project created with an older version, move it to the persistent cache
+        QDir thumbFolder = getDir(false, &ok);
+        result = QImage(thumbFolder.absoluteFilePath(key));
+        if (!result.isNull()) {
+            m_persistentCache->store(packKey, pos, result);
+            QFile::remove(thumbFolder.absoluteFilePath(key));
+        }
+    }
+    if (!result.isNull()) {
+        // Keep it in memory, so that the next requests don't need the disk
+        locker.relock();
+        if (!m_volatileCache->contains(key)) {
+            m_volatileCache->insert(key, result, int(result.sizeInBytes()));
+            m_storedVolatile[binId].push_back(pos);
+        }
+    }
+    return result;
+}
+
+void ThumbnailCache::loadThumbnail(const QString &binId, int pos, const std::function<void(const QImage &)> &done)
+{
+    QtConcurrent::run(&m_loaders, [this, binId, pos, done]() {
+        const QImage result = getThumbnail(binId, pos);
+        QMetaObject::invokeMethod(qApp, [done, result]() { done(result); });
+    });
 }
 
 void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
@@ -170,12 +215,10 @@ void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage
         return;
     }
     if (persistent) {
-        QDir thumbFolder = getDir(false, &ok);
+        const QString packKey = getPackKey(binId, &ok);
         if (ok) {
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: "<<thumbFolder.absoluteFilePath(key);
-            }
-            m_storedOnDisk[binId].push_back(pos);
+            // The thumbnail is written later, on the persistent cache thread
+            m_persistentCache->store(packKey, pos, img);
             // if volatile cache also contains this entry, update it
             if (m_volatileCache->contains(key)) {
                 m_volatileCache->remove(key);
@@ -192,49 +235,51 @@ void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage
 
 void ThumbnailCache::saveCachedThumbs(const QStringList &keys)
 {
-    bool ok;
-    QDir thumbFolder = getDir(false, &ok);
-    if (!ok) {
-        return;
-    }
-    for (const QString &key : keys) {
-        if (!thumbFolder.exists(key) && m_volatileCache->contains(key)) {
-            QImage img = m_volatileCache->get(key);
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
-                break;
+    const QString suffix = packSuffix();
+    std::vector<std::pair<QString, int>> positions;
+    std::vector<QImage> images;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const QString &key : keys) {
+            if (!m_volatileCache->contains(key)) {
+                continue;
             }
+            // Keys are built as hash#pos.jpg, see getKey
+            const QString packKey = key.section(QLatin1Char('#'), 0, 0) + suffix;
+            const int pos = key.section(QLatin1Char('#'), 1).section(QLatin1Char('.'), 0, 0).toInt();
+            positions.emplace_back(packKey, pos);
+            images.push_back(m_volatileCache->get(key));
+        }
+    }
+    // Checking the persistent cache may read a pack index, don't block the other threads meanwhile
+    for (size_t i = 0; i < positions.size(); ++i) {
+        if (!m_persistentCache->contains(positions[i].first, positions[i].second)) {
+            m_persistentCache->store(positions[i].first, positions[i].second, images[i]);
         }
     }
 }
 
 void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
-        bool ok = false;
-        for (int pos : m_storedVolatile.at(binId)) {
-            auto key = getKey(binId, pos, &ok);
-            if (ok) {
-                m_volatileCache->remove(key);
-            }
-        }
-        m_storedVolatile.erase(binId);
-    }
     bool ok = false;
-    // Video thumbs
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
-        // Remove persistent cache
-        for (int pos : m_storedOnDisk.at(binId)) {
-            if (pos >= 0) {
-                auto key = getKey(binId, pos, &ok);
-                if (ok) {
-                    QFile::remove(thumbFolder.absoluteFilePath(key));
+    // Video thumbs. Other projects using the clip with other settings keep their thumbnails
+    const QString packKey = getPackKey(binId, &ok);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
+            bool found = false;
+            for (int pos : m_storedVolatile.at(binId)) {
+                auto key = getKey(binId, pos, &found);
+                if (found) {
+                    m_volatileCache->remove(key);
                 }
             }
+            m_storedVolatile.erase(binId);
         }
-        m_storedOnDisk.erase(binId);
+    }
+    if (ok) {
+        // Remove persistent cache, this waits for the pack writer and deletes the file
+        m_persistentCache->remove(packKey);
     }
 }
 
@@ -243,7 +288,40 @@ void ThumbnailCache::clearCache()
     QMutexLocker locker(&m_mutex);
     m_volatileCache->clear();
     m_storedVolatile.clear();
-    m_storedOnDisk.clear();
+    m_persistentCache->setMaxBytes(qint64(KdenliveSettings::thumbnailcachesize()) * 1024 * 1024);
+}
+
+bool ThumbnailCache::hasLegacyThumbnail(const QString &key) const
+{
+    bool ok = false;
+    QDir thumbFolder = getDir(false, &ok);
+    return ok && thumbFolder.exists(key);
+}
+
+// static
+QString ThumbnailCache::getPackKey(const QString &binId, bool *ok)
+{
+    if (binId.isEmpty()) {
+        *ok = false;
+        return QString();
+    }
+    auto binClip = pCore->projectItemModel()->getClipByBinID(binId);
+    *ok = binClip != nullptr;
+    return *ok ? binClip->hash() + packSuffix() : QString();
+}
+
+// static
+QString ThumbnailCache::packSuffix()
+{
+    // A frame number is another time at another frame rate, and the thumbnail size follows the project profile
+    Mlt::Profile *profile = pCore->thumbProfile();
+    return QStringLiteral("_%1-%2_%3x%4_%5-%6")
+        .arg(profile->frame_rate_num())
+        .arg(profile->frame_rate_den())
+        .arg(profile->width())
+        .arg(profile->height())
+        .arg(profile->display_aspect_num())
+        .arg(profile->display_aspect_den());
 }
 
 // static
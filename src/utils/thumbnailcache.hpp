@@ -10,14 +10,20 @@
 #include <QUrl>
 #include <QImage>
 #include <QMutex>
+#include <QThreadPool>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
 
+class ThumbnailStore;
+
 /** @class ThumbnailCache
     @brief This class class is an interface to the caches that store thumbnails.
     In Kdenlive, we use two such caches, a persistent that is stored on disk to allow thumbnails to be reused when reopening.
+    The persistent cache is shared by all projects and keyed by clip content and the project settings affecting the
+    thumbnails, see ThumbnailStore.
     The other one is a volatile LRU cache that lives in memory.
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
@@ -30,6 +36,7 @@ class ThumbnailCache
 public:
     // Returns the instance of the Singleton
     static std::unique_ptr<ThumbnailCache> &get();
+    ~ThumbnailCache();
 
     /** @brief Check whether a given thumbnail is in the cache
        @param binId is the id of the queried clip
@@ -44,13 +51,17 @@ public:
        @param volatileOnly if true, we only check the volatile cache (no disk access)
     */
     QImage getThumbnail(const QString &binId, int pos, bool volatileOnly = false) const;
+    /** @brief Get a given thumbnail from the cache without blocking on the disk
+       @param done is called from the main thread with the thumbnail, which is null if it is not cached
+    */
+    void loadThumbnail(const QString &binId, int pos, const std::function<void(const QImage &)> &done);
     QImage getAudioThumbnail(const QString &binId, bool volatileOnly = false) const;
     const QList <QUrl> getAudioThumbPath(const QString &binId) const;
 
     /** @brief Get a given thumbnail from the cache
        @param binId is the id of the queried clip
        @param pos is the position where we query
-       @param persistent if true, we store the image in the persistent cache, which generates a disk access
+       @param persistent if true, we also store the image in the persistent cache, which is written to disk in the background
     */
     void storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent = false);
 
@@ -69,6 +80,12 @@ protected:
 
     // Return the key associated to a thumbnail
     static QString getKey(const QString &binId, int pos, bool *ok);
+    // Return the key of a clip in the persistent cache, made of its content hash and packSuffix()
+    static QString getPackKey(const QString &binId, bool *ok);
+    // Return the part of the persistent cache keys depending on the project settings
+    static QString packSuffix();
+    // Check whether a thumbnail was stored as a single file by older versions
+    bool hasLegacyThumbnail(const QString &key) const;
     static QStringList getAudioKey(const QString &binId, bool *ok);
 
     // Return the dir where the persistent cache lives
@@ -79,10 +96,12 @@ protected:
 
     class Cache_t;
     std::unique_ptr<Cache_t> m_volatileCache;
+    std::unique_ptr<ThumbnailStore> m_persistentCache;
     mutable QMutex m_mutex;
+    // Threads reading the persistent cache for loadThumbnail
+    QThreadPool m_loaders;
 
     // the following maps keeps track of the positions that we store for each clip in volatile caches.
     // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
-    std::unordered_map<QString, std::vector<int>> m_storedVolatile;
-    mutable std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
+    mutable std::unordered_map<QString, std::vector<int>> m_storedVolatile;
 };
@@ -0,0 +1,222 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "thumbnailgenerator.hpp"
+#include "bin/projectclip.h"
+#include "bin/projectitemmodel.h"
+#include "core.h"
+#include "doc/kthumb.h"
+
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include <mlt++/MltFrame.h>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+
+std::unique_ptr<ThumbnailGenerator> ThumbnailGenerator::instance;
+std::once_flag ThumbnailGenerator::m_onceFlag;
+
+const int ThumbnailGenerator::producersPerClip = 2;
+
+ThumbnailRequest::ThumbnailRequest(int frame, std::function<void(const QImage &, int)> done)
+    : m_frame(frame)
+    , m_done(std::move(done))
+{
+}
+
+void ThumbnailRequest::cancel()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cancelled = true;
+    m_done = nullptr;
+}
+
+bool ThumbnailRequest::isCancelled() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_cancelled;
+}
+
+int ThumbnailRequest::frame() const
+{
+    return m_frame;
+}
+
+void ThumbnailRequest::deliver(const QImage &img, int frame)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_done) {
+        m_done(img, frame);
+        m_done = nullptr;
+    }
+}
+
+std::unique_ptr<ThumbnailGenerator> &ThumbnailGenerator::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ThumbnailGenerator()); });
+    return instance;
+}
+
+ThumbnailGenerator::ThumbnailGenerator()
+{
+    // Decoding thumbnails should not compete with the playback
+    m_workers.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+}
+
+ThumbnailGenerator::~ThumbnailGenerator()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        for (Job &job : m_jobs) {
+            for (const auto &request : job.requests) {
+                request->cancel();
+            }
+        }
+    }
+    m_workers.waitForDone();
+}
+
+std::shared_ptr<ThumbnailRequest> ThumbnailGenerator::request(const QString &binId, int frame, std::function<void(const QImage &, int)> done)
+{
+    auto request = std::make_shared<ThumbnailRequest>(frame, std::move(done));
+    QMutexLocker lock(&m_mutex);
+    auto job = std::find_if(m_jobs.begin(), m_jobs.end(), [&](const Job &j) { return j.binId == binId && coalesce(j.frame, frame); });
+    if (job == m_jobs.end()) {
+        m_jobs.push_front(Job{binId, frame, {}, false});
+        job = m_jobs.begin();
+    } else if (!job->running) {
+        // The thumbnail was requested again, process it before the older ones
+        m_jobs.splice(m_jobs.begin(), m_jobs, job);
+    }
+    job->requests.push_back(request);
+    if (m_running < m_workers.maxThreadCount()) {
+        m_running++;
+        QtConcurrent::run(&m_workers, this, &ThumbnailGenerator::process);
+    }
+    return request;
+}
+
+void ThumbnailGenerator::releaseProducers(const QString &binId)
+{
+    QMutexLocker lock(&m_mutex);
+    auto pool = m_pools.find(binId);
+    if (pool == m_pools.end()) {
+        return;
+    }
+    if (pool->second.busy == 0) {
+        m_pools.erase(pool);
+    } else {
+        // The pool is removed when its last busy producer is done
+        pool->second.idle.clear();
+        pool->second.generation++;
+    }
+}
+
+void ThumbnailGenerator::waitForDone()
+{
+    m_workers.waitForDone();
+}
+
+bool ThumbnailGenerator::coalesce(int frame, int other)
+{
+    return qAbs(frame - other) <= 1;
+}
+
+void ThumbnailGenerator::process()
+{
+    QMutexLocker lock(&m_mutex);
+    while (true) {
+        // Find the most recent job whose clip has a producer available
+        auto job = m_jobs.begin();
+        while (job != m_jobs.end()) {
+            if (!job->running) {
+                auto &requests = job->requests;
+                requests.erase(std::remove_if(requests.begin(), requests.end(),
+                                              [](const std::shared_ptr<ThumbnailRequest> &request) { return request->isCancelled(); }),
+                               requests.end());
+                if (requests.empty()) {
+                    job = m_jobs.erase(job);
+                    continue;
+                }
+                auto pool = m_pools.find(job->binId);
+                if (pool == m_pools.end() || !pool->second.idle.empty() || pool->second.busy < producersPerClip) {
+                    break;
+                }
+            }
+            ++job;
+        }
+        if (job == m_jobs.end()) {
+            break;
+        }
+        job->running = true;
+        const QString binId = job->binId;
+        const int frame = job->frame;
+        Pool &pool = m_pools[binId];
+        const int generation = pool.generation;
+        std::shared_ptr<Mlt::Producer> producer;
+        if (!pool.idle.empty()) {
+            producer = pool.idle.back();
+            pool.idle.pop_back();
+        }
+        pool.busy++;
+        lock.unlock();
+
+        if (!producer) {
+            producer = createProducer(binId);
+        }
+        QImage img;
+        if (producer) {
+            img = makeThumbnail(producer, frame);
+        }
+
+        lock.relock();
+        auto current = m_pools.find(binId);
+        current->second.busy--;
+        // Producers released while they were busy are not given back
+        if (producer && current->second.generation == generation) {
+            current->second.idle.push_back(producer);
+        }
+        // Do not keep empty pools of released or deleted clips
+        if (current->second.busy == 0 && current->second.idle.empty()) {
+            m_pools.erase(current);
+        }
+        // Running jobs are only removed by the thread processing them
+        std::vector<std::shared_ptr<ThumbnailRequest>> requests = std::move(job->requests);
+        m_jobs.erase(job);
+        lock.unlock();
+        for (const auto &request : requests) {
+            request->deliver(img, frame);
+        }
+        lock.relock();
+    }
+    m_running--;
+}
+
+std::shared_ptr<Mlt::Producer> ThumbnailGenerator::createProducer(const QString &binId)
+{
+    std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
+    if (!binClip) {
+        return nullptr;
+    }
+    std::shared_ptr<Mlt::Producer> producer = binClip->createThumbProducer();
+    if (producer && !producer->is_valid()) {
+        return nullptr;
+    }
+    return producer;
+}
+
+QImage ThumbnailGenerator::makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frame)
+{
+    producer->seek(frame);
+    QScopedPointer<Mlt::Frame> mltFrame(producer->get_frame());
+    if (mltFrame == nullptr || !mltFrame->is_valid()) {
+        return QImage();
+    }
+    int imageHeight = pCore->thumbProfile()->height();
+    int imageWidth = pCore->thumbProfile()->width();
+    int fullWidth = qRound(imageHeight * pCore->getCurrentDar());
+    return KThumb::getFrame(mltFrame.data(), imageWidth, imageHeight, fullWidth);
+}
@@ -0,0 +1,120 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "definitions.h"
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Mlt {
+class Producer;
+}
+
+/** @class ThumbnailRequest
+    @brief Handle on a queued thumbnail, used to cancel it when it is not needed anymore.
+ */
+class ThumbnailRequest
+{
+public:
+    ThumbnailRequest(int frame, std::function<void(const QImage &, int)> done);
+
+    /** @brief The thumbnail is not needed anymore. Once this returns, the callback will not be called */
+    void cancel();
+    bool isCancelled() const;
+    int frame() const;
+
+protected:
+    friend class ThumbnailGenerator;
+    /** @brief Call the callback if the request was not cancelled */
+    void deliver(const QImage &img, int frame);
+
+    const int m_frame;
+    mutable QMutex m_mutex;
+    bool m_cancelled{false};
+    std::function<void(const QImage &, int)> m_done;
+};
+
+/** @class ThumbnailGenerator
+    @brief Extracts clip thumbnails on a few background threads.
+    Each clip gets a small pool of thumbnail producers, so that several frames of the same clip can be decoded in parallel.
+    The most recent requests are processed first: when the timeline is scrolled, the thumbnails that became visible
+    are requested last, while the requests of the thumbnails that went out of view are cancelled.
+    Requests for adjacent frames of a clip are coalesced in a single extraction, they cannot be told apart at thumbnail size.
+ * Note that this class is a Singleton
+ */
+class ThumbnailGenerator
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ThumbnailGenerator> &get();
+    virtual ~ThumbnailGenerator();
+
+    /** @brief Queue the extraction of a thumbnail
+       @param binId is the id of the clip
+       @param frame is the position of the thumbnail
+       @param done is called from a worker thread with the thumbnail, which is null if it could not be extracted,
+       and the frame it was extracted from, which may be next to the requested one
+     */
+    std::shared_ptr<ThumbnailRequest> request(const QString &binId, int frame, std::function<void(const QImage &, int)> done);
+
+    /** @brief Drop the thumbnail producers of a clip, because it was reloaded or deleted */
+    void releaseProducers(const QString &binId);
+
+    /** @brief Wait until all the queued thumbnails are processed */
+    void waitForDone();
+
+    /** @brief Maximum number of thumbnail producers of a clip */
+    static const int producersPerClip;
+
+protected:
+    // Constructor is protected because class is a Singleton
+    ThumbnailGenerator();
+
+    /** @brief Create a new thumbnail producer for a clip, called from a worker thread */
+    virtual std::shared_ptr<Mlt::Producer> createProducer(const QString &binId);
+    /** @brief Extract a frame, called from a worker thread */
+    virtual QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frame);
+
+    struct Job
+    {
+        QString binId;
+        int frame;
+        std::vector<std::shared_ptr<ThumbnailRequest>> requests;
+        bool running{false};
+    };
+    struct Pool
+    {
+        std::vector<std::shared_ptr<Mlt::Producer>> idle;
+        int busy{0};
+        // Increased when the producers are released, so that the busy ones are not given back to the pool
+        int generation{0};
+    };
+
+    /** @brief True if both frames are close enough to share a thumbnail */
+    static bool coalesce(int frame, int other);
+    /** @brief Worker loop, processing jobs until none can be started */
+    void process();
+
+    // Protects the members below
+    QMutex m_mutex;
+    // Pending and running jobs, the most recent first
+    std::list<Job> m_jobs;
+    std::unordered_map<QString, Pool> m_pools;
+    int m_running{0};
+    QThreadPool m_workers;
+
+    static std::unique_ptr<ThumbnailGenerator> instance;
+    static std::once_flag m_onceFlag; // flag to create the generator only once;
+};
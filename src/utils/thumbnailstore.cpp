@@ -0,0 +1,360 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "thumbnailstore.hpp"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+const char packMagic[4] = {'K', 'D', 'T', 'H'};
+// magic, version, entry count
+const int headerSize = 4 + 2 * int(sizeof(quint32));
+// frame, offset, size
+const int entrySize = int(sizeof(qint32) + sizeof(quint64) + sizeof(quint32));
+// Time given to other thumbnails to be queued before a batch is written, in ms
+const unsigned long batchDelay = 1000;
+// When over budget, packs are removed until the store uses this part of its budget
+const double evictionTarget = 0.9;
+} // namespace
+
+const quint32 ThumbnailStore::formatVersion = 1;
+
+ThumbnailStore::ThumbnailStore(const QString &folder, qint64 maxBytes)
+    : m_folder(folder)
+    , m_maxBytes(maxBytes)
+{
+    QDir().mkpath(m_folder);
+    // A single writer thread, so that packs never need to be locked for reading by the writer
+    m_writerPool.setMaxThreadCount(1);
+}
+
+ThumbnailStore::~ThumbnailStore()
+{
+    flush();
+}
+
+QString ThumbnailStore::packPath(const QString &key) const
+{
+    return m_folder + QLatin1Char('/') + key + QStringLiteral(".thumbs");
+}
+
+// static
+bool ThumbnailStore::readIndex(const QString &path, Index &index)
+{
+    index.clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 fileSize = file.size();
+    const QByteArray header = file.read(headerSize);
+    if (header.size() != headerSize || memcmp(header.constData(), packMagic, 4) != 0) {
+        return false;
+    }
+    const auto *data = reinterpret_cast<const uchar *>(header.constData());
+    const quint32 count = qFromLittleEndian<quint32>(data + 8);
+    if (qFromLittleEndian<quint32>(data + 4) != formatVersion || qint64(count) * entrySize > fileSize - headerSize) {
+        return false;
+    }
+    const QByteArray entries = file.read(qint64(count) * entrySize);
+    if (entries.size() != int(count) * entrySize) {
+        return false;
+    }
+    const auto *pos = reinterpret_cast<const uchar *>(entries.constData());
+    for (quint32 i = 0; i < count; ++i, pos += entrySize) {
+        Entry entry{qFromLittleEndian<quint64>(pos + 4), qFromLittleEndian<quint32>(pos + 12)};
+        if (entry.offset + entry.size > quint64(fileSize)) {
+            index.clear();
+            return false;
+        }
+        index[qFromLittleEndian<qint32>(pos)] = entry;
+    }
+    return true;
+}
+
+const QImage *ThumbnailStore::queuedImage(const QString &key, int frame) const
+{
+    for (const Batch *batch : {&m_queued, &m_writing}) {
+        auto clip = batch->find(key);
+        if (clip != batch->end() && m_discarded.count(key) == 0) {
+            auto img = clip->second.find(frame);
+            if (img != clip->second.end()) {
+                return &img->second;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool ThumbnailStore::findEntry(const QString &key, int frame, Entry &entry)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_indexes.find(key);
+    if (it == m_indexes.end()) {
+        // First access to this pack, load its index
+        lock.unlock();
+        Index index;
+        {
+            QReadLocker packLock(&m_packLock);
+            readIndex(packPath(key), index);
+        }
+        lock.relock();
+        // The writer thread may have stored a newer index in the meantime, keep it
+        it = m_indexes.emplace(key, std::move(index)).first;
+    }
+    auto found = it->second.find(frame);
+    if (found == it->second.end()) {
+        return false;
+    }
+    entry = found->second;
+    return true;
+}
+
+bool ThumbnailStore::contains(const QString &key, int frame)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        if (queuedImage(key, frame) != nullptr) {
+            return true;
+        }
+    }
+    Entry entry;
+    return findEntry(key, frame, entry);
+}
+
+QImage ThumbnailStore::image(const QString &key, int frame)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        if (const QImage *img = queuedImage(key, frame)) {
+            return *img;
+        }
+    }
+    Entry entry;
+    if (!findEntry(key, frame, entry)) {
+        return QImage();
+    }
+    QByteArray data;
+    {
+        QReadLocker packLock(&m_packLock);
+        {
+            // The pack may have been replaced since the lookup
+            QMutexLocker lock(&m_mutex);
+            auto it = m_indexes.find(key);
+            if (it == m_indexes.end() || it->second.count(frame) == 0) {
+                return QImage();
+            }
+            entry = it->second.at(frame);
+            m_accessed.insert(key);
+        }
+        QFile file(packPath(key));
+        if (!file.open(QIODevice::ReadOnly) || !file.seek(qint64(entry.offset))) {
+            return QImage();
+        }
+        data = file.read(entry.size);
+    }
+    return QImage::fromData(data, "JPG");
+}
+
+void ThumbnailStore::store(const QString &key, int frame, const QImage &img)
+{
+    if (img.isNull()) {
+        return;
+    }
+    QMutexLocker lock(&m_mutex);
+    m_queued[key][frame] = img;
+    if (!m_writerRunning) {
+        m_writerRunning = true;
+        QtConcurrent::run(&m_writerPool, this, &ThumbnailStore::writeBatches);
+    }
+}
+
+void ThumbnailStore::remove(const QString &key)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_queued.erase(key);
+        if (m_writing.count(key) > 0) {
+            // Do not let the writer thread recreate the pack
+            m_discarded.insert(key);
+        }
+    }
+    QWriteLocker packLock(&m_packLock);
+    const QString path = packPath(key);
+    const qint64 size = QFileInfo(path).size();
+    QMutexLocker lock(&m_mutex);
+    m_indexes[key] = Index();
+    if (QFile::remove(path) && m_currentBytes >= 0) {
+        m_currentBytes -= size;
+    }
+}
+
+void ThumbnailStore::flush()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_flushRequested = true;
+        m_wakeWriter.wakeAll();
+    }
+    m_writerPool.waitForDone();
+    QMutexLocker lock(&m_mutex);
+    m_flushRequested = false;
+}
+
+void ThumbnailStore::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker lock(&m_mutex);
+    m_maxBytes = maxBytes;
+}
+
+void ThumbnailStore::writeBatches()
+{
+    QMutexLocker lock(&m_mutex);
+    while (!m_queued.empty()) {
+        if (!m_flushRequested) {
+            // Give other thumbnails a chance to be queued, so that they are written in the same batch
+            m_wakeWriter.wait(&m_mutex, batchDelay);
+        }
+        m_writing.swap(m_queued);
+        std::unordered_set<QString> accessed;
+        accessed.swap(m_accessed);
+        lock.unlock();
+        // m_writing is only modified by this thread, it can be read without lock
+        for (const auto &clip : m_writing) {
+            writePack(clip.first, clip.second);
+        }
+        // Packs are evicted by modification time, mark the ones that were used
+        for (const QString &key : accessed) {
+            QFile file(packPath(key));
+            if (file.open(QIODevice::Append)) {
+                file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            }
+        }
+        lock.relock();
+        const bool overBudget = m_currentBytes < 0 || m_currentBytes > m_maxBytes;
+        lock.unlock();
+        if (overBudget) {
+            evict();
+        }
+        lock.relock();
+        m_writing.clear();
+        m_discarded.clear();
+    }
+    m_writerRunning = false;
+}
+
+void ThumbnailStore::writePack(const QString &key, const std::map<int, QImage> &images)
+{
+    const QString path = packPath(key);
+    std::map<int, QByteArray> jpegs;
+    for (const auto &img : images) {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        if (img.second.save(&buffer, "JPG")) {
+            jpegs[img.first] = data;
+        }
+    }
+    // Keep the thumbnails already in the pack. Only this thread writes packs, so no lock is needed to read it
+    Index previous;
+    QFile current(path);
+    const qint64 previousSize = current.size();
+    if (readIndex(path, previous) && current.open(QIODevice::ReadOnly)) {
+        for (const auto &entry : previous) {
+            if (jpegs.count(entry.first) > 0 || !current.seek(qint64(entry.second.offset))) {
+                continue;
+            }
+            QByteArray data = current.read(entry.second.size);
+            if (data.size() == int(entry.second.size)) {
+                jpegs[entry.first] = data;
+            }
+        }
+        current.close();
+    }
+    if (jpegs.empty()) {
+        return;
+    }
+
+    // Build the index, the JPEG data follows it
+    Index index;
+    quint64 offset = quint64(headerSize) + jpegs.size() * entrySize;
+    QByteArray header(int(offset), 0);
+    auto *out = reinterpret_cast<uchar *>(header.data());
+    memcpy(out, packMagic, 4);
+    qToLittleEndian<quint32>(formatVersion, out + 4);
+    qToLittleEndian<quint32>(quint32(jpegs.size()), out + 8);
+    out += headerSize;
+    for (const auto &jpeg : jpegs) {
+        Entry entry{offset, quint32(jpeg.second.size())};
+        qToLittleEndian<qint32>(jpeg.first, out);
+        qToLittleEndian<quint64>(entry.offset, out + 4);
+        qToLittleEndian<quint32>(entry.size, out + 12);
+        out += entrySize;
+        index[jpeg.first] = entry;
+        offset += entry.size;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "// Cannot write thumbnails to" << path;
+        return;
+    }
+    file.write(header);
+    for (const auto &jpeg : jpegs) {
+        file.write(jpeg.second);
+    }
+
+    QWriteLocker packLock(&m_packLock);
+    QMutexLocker lock(&m_mutex);
+    if (m_discarded.count(key) > 0) {
+        // The pack was removed while we were writing
+        file.cancelWriting();
+        return;
+    }
+    if (!file.commit()) {
+        qDebug() << "// Error writing thumbnails to" << path;
+        return;
+    }
+    m_indexes[key] = std::move(index);
+    if (m_currentBytes >= 0) {
+        m_currentBytes += qint64(offset) - previousSize;
+    }
+}
+
+void ThumbnailStore::evict()
+{
+    // Oldest packs first
+    const QFileInfoList packs = QDir(m_folder).entryInfoList({QStringLiteral("*.thumbs")}, QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    for (const QFileInfo &pack : packs) {
+        total += pack.size();
+    }
+    QMutexLocker lock(&m_mutex);
+    const auto target = total > m_maxBytes ? qint64(double(m_maxBytes) * evictionTarget) : total;
+    lock.unlock();
+    for (const QFileInfo &pack : packs) {
+        if (total <= target) {
+            break;
+        }
+        const QString key = pack.completeBaseName();
+        QWriteLocker packLock(&m_packLock);
+        lock.relock();
+        if (QFile::remove(pack.absoluteFilePath())) {
+            total -= pack.size();
+            m_indexes[key] = Index();
+        }
+        lock.unlock();
+    }
+    lock.relock();
+    m_currentBytes = total;
+}
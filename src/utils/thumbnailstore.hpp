@@ -0,0 +1,105 @@
+/*
+    SPDX-FileCopyrightText: 2022 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "definitions.h"
+#include <QImage>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+/** @class ThumbnailStore
+    @brief Persistent thumbnail storage, shared by all projects.
+    Thumbnails are grouped by a pack key and indexed by frame number. ThumbnailCache builds the key from the content
+    hash of the clip and the project settings the thumbnails depend on, so that a clip used in several projects with
+    the same settings only has its thumbnails stored once.
+    All the thumbnails of a pack are stored in a single file, made of an index followed by the concatenated JPEG data.
+    Thumbnails are queued in memory and written in batches on a background thread, so that storing a thumbnail never
+    waits for the disk. The total size of the store is kept below a budget by removing the least recently used packs.
+ */
+class ThumbnailStore
+{
+
+public:
+    /** @param folder is the directory holding the packed files
+        @param maxBytes is the size budget of the store
+     */
+    ThumbnailStore(const QString &folder, qint64 maxBytes);
+    ~ThumbnailStore();
+
+    /** @brief Check whether a thumbnail is stored, either on disk or waiting to be written */
+    bool contains(const QString &key, int frame);
+
+    /** @brief Get a stored thumbnail, returns a null image if it is not stored */
+    QImage image(const QString &key, int frame);
+
+    /** @brief Queue a thumbnail for writing. The disk is accessed later, on the background thread */
+    void store(const QString &key, int frame, const QImage &img);
+
+    /** @brief Remove all the thumbnails of a pack */
+    void remove(const QString &key);
+
+    /** @brief Wait until all the queued thumbnails are written */
+    void flush();
+
+    void setMaxBytes(qint64 maxBytes);
+
+    /** @brief Version of the packed file format, increase it when changing the file layout */
+    static const quint32 formatVersion;
+
+protected:
+    struct Entry
+    {
+        quint64 offset;
+        quint32 size;
+    };
+    // frame -> location of its JPEG data in the pack
+    using Index = std::map<int, Entry>;
+    using Batch = std::unordered_map<QString, std::map<int, QImage>>;
+
+    QString packPath(const QString &key) const;
+    /** @brief Look for a thumbnail in the index of its pack, reading the index from disk the first time.
+        m_mutex and m_packLock must not be locked */
+    bool findEntry(const QString &key, int frame, Entry &entry);
+    /** @brief Read the index of a pack file, returns false if the file is not a valid pack */
+    static bool readIndex(const QString &path, Index &index);
+    /** @brief Look for a thumbnail in the queued batches. m_mutex must be locked */
+    const QImage *queuedImage(const QString &key, int frame) const;
+
+    /** @brief Background loop writing the queued thumbnails */
+    void writeBatches();
+    /** @brief Merge new thumbnails in a pack */
+    void writePack(const QString &key, const std::map<int, QImage> &images);
+    /** @brief Remove the least recently used packs until the store fits in its budget */
+    void evict();
+
+    QString m_folder;
+    qint64 m_maxBytes;
+    // Protects the members below
+    QMutex m_mutex;
+    // Total size of the packs, -1 until computed by the writer thread
+    qint64 m_currentBytes{-1};
+    std::unordered_map<QString, Index> m_indexes;
+    // Thumbnails waiting for the next batch, and the batch being written
+    Batch m_queued;
+    Batch m_writing;
+    // Packs that were read since the last batch, their modification time is used for the LRU eviction
+    std::unordered_set<QString> m_accessed;
+    // Packs removed while their batch was being written
+    std::unordered_set<QString> m_discarded;
+    bool m_writerRunning{false};
+    bool m_flushRequested{false};
+    QWaitCondition m_wakeWriter;
+
+    // Readers of pack files lock it for reading, replacing or deleting a pack locks it for writing
+    QReadWriteLock m_packLock;
+    QThreadPool m_writerPool;
+};
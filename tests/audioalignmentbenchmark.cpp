@@ -0,0 +1,39 @@
+#include "audioalignmentutils.hpp"
+#include "catch.hpp"
+#include "lib/audio/audioCorrelationInfo.h"
+#include "lib/audio/batchCorrelation.h"
+#include "lib/audio/fftCorrelation.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <vector>
+
+// These test cases are hidden, run them with: runBenchmarks "[Benchmark]"
+TEST_CASE("Audio alignment cost", "[.][Benchmark]")
+{
+    // One hour at 25 fps
+    const size_t size = 90000;
+    const int clips = 10;
+    const std::vector<qint64> reference = testEnvelope(size, 1);
+    std::vector<std::vector<qint64>> children;
+    for (int i = 0; i < clips; ++i) {
+        children.push_back(childEnvelope(reference, size_t(i) * 1000, size - 10000, unsigned(i + 2)));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<size_t> expected;
+    for (const auto &child : children) {
+        AudioCorrelationInfo info(reference.size(), child.size());
+        FFTCorrelation::correlate(reference.data(), reference.size(), child.data(), child.size(), info.correlationVector());
+        expected.push_back(info.maxIndex());
+    }
+    qint64 sequential = timer.nsecsElapsed();
+    timer.restart();
+    auto infos = BatchCorrelation(reference).correlateAll(children);
+    qint64 batch = timer.nsecsElapsed();
+    for (size_t i = 0; i < children.size(); ++i) {
+        REQUIRE(infos[i]->maxIndex() == expected[i]);
+    }
+    qDebug() << "Aligning" << clips << "clips of" << size << "frames: sequential" << sequential / 1000000 << "ms, batch" << batch / 1000000 << "ms";
+}
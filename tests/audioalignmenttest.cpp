@@ -0,0 +1,62 @@
+#include "audioalignmentutils.hpp"
+#include "catch.hpp"
+#include "lib/audio/audioCorrelationInfo.h"
+#include "lib/audio/batchCorrelation.h"
+#include "lib/audio/fftCorrelation.h"
+
+#include <vector>
+
+namespace {
+// Shift of the child in the reference, as computed by AudioCorrelation::getShift()
+qint64 shift(const AudioCorrelationInfo &info, size_t childSize)
+{
+    return qint64(info.maxIndex()) - qint64(childSize);
+}
+} // namespace
+
+TEST_CASE("Audio alignment", "[AudioCorrelation]")
+{
+    const std::vector<qint64> reference = testEnvelope(20000, 1);
+    const std::vector<size_t> positions{0, 137, 5000, 12345};
+    const size_t childSize = 6000;
+    std::vector<std::vector<qint64>> children;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        children.push_back(childEnvelope(reference, positions[i], childSize, unsigned(i + 2)));
+    }
+
+    SECTION("Cached reference spectrum gives the same correlation")
+    {
+        FFTReference fft(reference.data(), reference.size());
+        for (const auto &child : children) {
+            AudioCorrelationInfo expected(reference.size(), child.size());
+            FFTCorrelation::correlate(reference.data(), reference.size(), child.data(), child.size(), expected.correlationVector());
+            AudioCorrelationInfo info(reference.size(), child.size());
+            fft.correlate(child.data(), child.size(), info.correlationVector());
+            REQUIRE(info.maxIndex() == expected.maxIndex());
+            for (size_t i = 0; i < info.size(); i += 97) {
+                REQUIRE(double(info.correlationVector()[i]) == Approx(double(expected.correlationVector()[i])).margin(1));
+            }
+        }
+    }
+
+    SECTION("All children are aligned")
+    {
+        BatchCorrelation batch(reference);
+        REQUIRE(batch.referenceSize() == reference.size());
+        auto infos = batch.correlateAll(children);
+        REQUIRE(infos.size() == children.size());
+        for (size_t i = 0; i < children.size(); ++i) {
+            REQUIRE(shift(*infos[i], childSize) == qint64(positions[i]));
+        }
+    }
+
+    SECTION("Short envelopes are aligned")
+    {
+        const std::vector<qint64> shortReference(reference.begin(), reference.begin() + 1000);
+        const std::vector<qint64> child = childEnvelope(shortReference, 300, 200, 7);
+        BatchCorrelation batch(shortReference);
+        AudioCorrelationInfo info(shortReference.size(), child.size());
+        batch.correlate(child, &info);
+        REQUIRE(shift(info, child.size()) == 300);
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <QtGlobal>
+#include <random>
+#include <vector>
+
+// Envelopes shared by the audio alignment tests and benchmarks
+
+// A noisy envelope, similar to the envelope of a recording
+inline std::vector<qint64> testEnvelope(size_t size, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<qint64> dist(0, 1 << 16);
+    std::vector<qint64> envelope(size);
+    for (qint64 &value : envelope) {
+        value = dist(gen);
+    }
+    return envelope;
+}
+
+// The part of the reference starting at position, with some noise added
+inline std::vector<qint64> childEnvelope(const std::vector<qint64> &reference, size_t position, size_t size, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<qint64> dist(0, 1 << 13);
+    std::vector<qint64> child(reference.begin() + long(position), reference.begin() + long(position + size));
+    for (qint64 &value : child) {
+        value += dist(gen);
+    }
+    return child;
+}
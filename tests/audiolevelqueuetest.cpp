@@ -0,0 +1,55 @@
+#include "catch.hpp"
+#include "utils/audiolevelqueue.hpp"
+
+#include <thread>
+
+TEST_CASE("Audio level queue", "[AudioLevels]")
+{
+    AudioLevelQueue queue;
+    MeterLevels levels;
+    REQUIRE_FALSE(queue.pop(levels));
+
+    SECTION("Levels are read in order, the newest are dropped when the queue is full")
+    {
+        for (int i = 0; i < int(AudioLevelQueue::capacity) + 10; i++) {
+            levels.position = i;
+            REQUIRE(queue.push(levels) == (i < int(AudioLevelQueue::capacity)));
+        }
+        for (int i = 0; i < int(AudioLevelQueue::capacity); i++) {
+            REQUIRE(queue.pop(levels));
+            REQUIRE(levels.position == i);
+        }
+        REQUIRE_FALSE(queue.pop(levels));
+        levels.position = 5;
+        REQUIRE(queue.push(levels));
+        queue.discard();
+        REQUIRE_FALSE(queue.pop(levels));
+    }
+
+    SECTION("Levels sent from another thread")
+    {
+        const int count = 100000;
+        std::thread producer([&queue]() {
+            MeterLevels sent;
+            sent.channels = 2;
+            for (int i = 0; i < count;) {
+                sent.position = i;
+                sent.values[0] = i;
+                sent.values[1] = -i;
+                if (queue.push(sent)) {
+                    i++;
+                }
+            }
+        });
+        int expected = 0;
+        bool valid = true;
+        while (expected < count) {
+            if (queue.pop(levels)) {
+                valid = valid && levels.position == expected && levels.channels == 2 && levels.values[0] == expected && levels.values[1] == -expected;
+                expected++;
+            }
+        }
+        producer.join();
+        REQUIRE(valid);
+    }
+}
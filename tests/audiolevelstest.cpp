@@ -0,0 +1,57 @@
+#include "catch.hpp"
+#include "lib/audio/audioLevels.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <algorithm>
+
+TEST_CASE("Audio levels cache", "[AudioLevels]")
+{
+    const int channels = 2;
+    const int frames = 1000;
+    QVector<uint8_t> levels;
+    for (int i = 0; i < frames; ++i) {
+        levels << uint8_t(i % 256) << uint8_t(255 - i % 256);
+    }
+    AudioLevels data(levels, channels);
+    REQUIRE(data.frames() == frames);
+    REQUIRE(data.decimationCount() > 0);
+
+    SECTION("Decimations keep the maximum")
+    {
+        const QVector<uint8_t> &first = data.decimation(1);
+        REQUIRE(first.size() == frames / 2 * channels);
+        // frames 0 and 1, channel 0
+        REQUIRE(first.at(0) == 1);
+        // frames 0 and 1, channel 1
+        REQUIRE(first.at(1) == 255);
+        // the coarsest decimation covers the whole range
+        const QVector<uint8_t> &last = data.decimation(data.decimationCount());
+        uint8_t max[channels] = {0, 0};
+        for (int i = 0; i < last.size(); ++i) {
+            max[i % channels] = std::max(max[i % channels], last.at(i));
+        }
+        REQUIRE(max[0] == 255);
+        REQUIRE(max[1] == 255);
+    }
+
+    SECTION("Save and load")
+    {
+        QTemporaryDir dir;
+        REQUIRE(dir.isValid());
+        const QString path = dir.filePath(QStringLiteral("levels"));
+        REQUIRE(data.save(path));
+        AudioLevels loaded = AudioLevels::load(path, channels);
+        REQUIRE(loaded.rawLevels() == levels);
+        REQUIRE(loaded.decimationCount() == data.decimationCount());
+        for (int i = 1; i <= data.decimationCount(); ++i) {
+            REQUIRE(loaded.decimation(i) == data.decimation(i));
+        }
+        // A channel count mismatch invalidates the cache
+        REQUIRE(AudioLevels::load(path, 1).isEmpty());
+        // So does a truncated file
+        QFile file(path);
+        REQUIRE(file.resize(file.size() - 1));
+        REQUIRE(AudioLevels::load(path, channels).isEmpty());
+    }
+}
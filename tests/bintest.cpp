@@ -0,0 +1,101 @@
+#include "test_utils.hpp"
+
+Mlt::Profile profile_bin;
+
+namespace {
+// The clip index must give the same clips as a scan of all the bin items
+void checkClipIndex(const std::shared_ptr<ProjectItemModel> &binModel)
+{
+    size_t clips = 0;
+    for (const auto &item : binModel->m_allItems) {
+        auto c = std::static_pointer_cast<AbstractProjectItem>(item.second.lock());
+        if (c->itemType() == AbstractProjectItem::ClipItem) {
+            clips++;
+            REQUIRE(binModel->getClipByBinID(c->clipId()) == c);
+            REQUIRE(binModel->getItemByBinId(c->clipId()) == c);
+        }
+    }
+    REQUIRE(binModel->m_clipsByBinId.size() == clips);
+}
+} // namespace
+
+TEST_CASE("Bin clip lookup index", "[ProjectItemModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    REQUIRE(binModel->m_clipsByBinId.empty());
+
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    const QString rootId = binModel->getRootFolder()->clipId();
+    QString folderId;
+    REQUIRE(binModel->requestAddFolder(folderId, QStringLiteral("Folder"), rootId, undo, redo));
+    std::vector<QString> binIds;
+    for (int i = 0; i < 10; ++i) {
+        std::shared_ptr<Mlt::Producer> producer = std::make_shared<Mlt::Producer>(profile_bin, "color", "red");
+        producer->set("length", 20);
+        producer->set("out", 19);
+        QString binId;
+        // Half of the clips are in a folder
+        REQUIRE(binModel->requestAddBinClip(binId, producer, i % 2 == 0 ? folderId : rootId, undo, redo));
+        binIds.push_back(binId);
+    }
+    checkClipIndex(binModel);
+    REQUIRE(binModel->m_clipsByBinId.size() == binIds.size());
+    REQUIRE(binModel->getClipByBinID(binIds[3])->clipId() == binIds[3]);
+    // Timeline ids with a stream suffix give the bin clip
+    REQUIRE(binModel->getClipByBinID(binIds[3] + QStringLiteral("_2")) == binModel->getClipByBinID(binIds[3]));
+    // Folders are not clips
+    REQUIRE(binModel->getClipByBinID(folderId) == nullptr);
+    REQUIRE(binModel->getItemByBinId(folderId) == binModel->getFolderByBinId(folderId));
+
+    SECTION("Undo and redo clip deletion")
+    {
+        Fun undoDelete = []() { return true; };
+        Fun redoDelete = []() { return true; };
+        REQUIRE(binModel->requestBinClipDeletion(binModel->getClipByBinID(binIds[0]), undoDelete, redoDelete));
+        REQUIRE(binModel->requestBinClipDeletion(binModel->getClipByBinID(binIds[1]), undoDelete, redoDelete));
+        REQUIRE(binModel->getClipByBinID(binIds[0]) == nullptr);
+        REQUIRE(binModel->getClipByBinID(binIds[1]) == nullptr);
+        checkClipIndex(binModel);
+        REQUIRE(undoDelete());
+        REQUIRE(binModel->getClipByBinID(binIds[0]) != nullptr);
+        REQUIRE(binModel->getClipByBinID(binIds[1]) != nullptr);
+        checkClipIndex(binModel);
+        REQUIRE(redoDelete());
+        REQUIRE(binModel->getClipByBinID(binIds[0]) == nullptr);
+        checkClipIndex(binModel);
+    }
+
+    SECTION("Undo and redo folder deletion")
+    {
+        Fun undoDelete = []() { return true; };
+        Fun redoDelete = []() { return true; };
+        REQUIRE(binModel->requestBinClipDeletion(binModel->getFolderByBinId(folderId), undoDelete, redoDelete));
+        for (size_t i = 0; i < binIds.size(); ++i) {
+            REQUIRE((binModel->getClipByBinID(binIds[i]) == nullptr) == (i % 2 == 0));
+        }
+        checkClipIndex(binModel);
+        REQUIRE(undoDelete());
+        for (const QString &binId : binIds) {
+            REQUIRE(binModel->getClipByBinID(binId) != nullptr);
+        }
+        checkClipIndex(binModel);
+        REQUIRE(redoDelete());
+        checkClipIndex(binModel);
+    }
+
+    SECTION("Undo and redo clip creation")
+    {
+        REQUIRE(undo());
+        REQUIRE(binModel->m_clipsByBinId.empty());
+        checkClipIndex(binModel);
+        REQUIRE(redo());
+        for (const QString &binId : binIds) {
+            REQUIRE(binModel->getClipByBinID(binId) != nullptr);
+        }
+        checkClipIndex(binModel);
+    }
+    binModel->clean();
+    REQUIRE(binModel->m_clipsByBinId.empty());
+}
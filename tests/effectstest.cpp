@@ -112,4 +112,51 @@ TEST_CASE("Effects stack", "[Effects]")
         REQUIRE(clipModel->rowCount() == 0);
         REQUIRE(splitModel->rowCount() == 1);
     }
+
+    SECTION("Batched parameter changes")
+    {
+        REQUIRE(model->appendEffect(anEffect));
+        auto effect = std::static_pointer_cast<EffectItemModel>(model->getEffectStackRow(0));
+        int notifications = 0;
+        QObject::connect(effect.get(), &AssetParameterModel::modelChanged, [&notifications]() { notifications++; });
+        {
+            AssetParameterTransaction transaction;
+            REQUIRE(AssetParameterTransaction::isRunning());
+            {
+                // Nested transactions are part of the outermost one
+                AssetParameterTransaction nested;
+                effect->setParameter(QStringLiteral("in"), 2, true);
+            }
+            effect->setParameter(QStringLiteral("out"), 20, true);
+            // Parameters are applied immediately, only the notifications are delayed
+            REQUIRE(effect->filter().get_int("in") == 2);
+            REQUIRE(effect->filter().get_int("out") == 20);
+            REQUIRE(notifications == 0);
+        }
+        REQUIRE_FALSE(AssetParameterTransaction::isRunning());
+        REQUIRE(notifications == 1);
+        effect->setParameter(QStringLiteral("out"), 25, true);
+        REQUIRE(notifications == 2);
+
+        // A transaction only merges the notifications that the changes send one by one
+        int dataChanges = 0;
+        QObject::connect(effect.get(), &AssetParameterModel::dataChanged, [&dataChanges]() { dataChanges++; });
+        effect->setParameter(QStringLiteral("out"), 30, false);
+        REQUIRE(notifications == 2);
+        REQUIRE(dataChanges == 0);
+        {
+            AssetParameterTransaction transaction;
+            effect->setParameter(QStringLiteral("in"), 3, false);
+            effect->setParameter(QStringLiteral("out"), 31, false);
+        }
+        REQUIRE(notifications == 2);
+        REQUIRE(dataChanges == 0);
+        {
+            AssetParameterTransaction transaction;
+            effect->setParameter(QStringLiteral("in"), 4, false);
+            effect->setParameter(QStringLiteral("out"), 32, true);
+        }
+        REQUIRE(notifications == 3);
+        REQUIRE(dataChanges == 1);
+    }
 }
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+#include "utils/filehashcache.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+class TestCache : public FileHashCache
+{
+public:
+    explicit TestCache(const QString &cacheFile)
+        : FileHashCache(cacheFile)
+    {
+    }
+};
+
+void writeFile(const QString &path, const QByteArray &data, const QDateTime &modified)
+{
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    file.write(data);
+    file.flush();
+    file.setFileTime(modified, QFileDevice::FileModificationTime);
+}
+} // namespace
+
+TEST_CASE("Persistent file hash cache", "[FileHashCache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString cacheFile = dir.filePath(QStringLiteral("cache/filehashes"));
+    const QString small = dir.filePath(QStringLiteral("small.dat"));
+    const QString large = dir.filePath(QStringLiteral("large.dat"));
+    const QDateTime date = QDateTime::currentDateTime().addDays(-1);
+    const QByteArray smallData(1000, 'a');
+    QByteArray largeData(3000000, 'b');
+    largeData[0] = 'c';
+    largeData[2999999] = 'd';
+    writeFile(small, smallData, date);
+    writeFile(large, largeData, date);
+
+    TestCache cache(cacheFile);
+    // The hash stored in the documents: the whole file, or its first and last megabytes
+    auto hash = cache.hash(small);
+    REQUIRE(hash.first == QCryptographicHash::hash(smallData, QCryptographicHash::Md5));
+    REQUIRE(hash.second == 1000);
+    hash = cache.hash(large);
+    REQUIRE(hash.first == QCryptographicHash::hash(largeData.left(1000000) + largeData.right(1000000), QCryptographicHash::Md5));
+    REQUIRE(hash.second == 3000000);
+    REQUIRE(cache.hash(dir.filePath(QStringLiteral("missing.dat"))).first.isEmpty());
+
+    SECTION("Files are only read again when they changed")
+    {
+        const QByteArray expected = cache.hash(small).first;
+        // Same size and modification time, the cached hash is used
+        writeFile(small, QByteArray(1000, 'e'), date);
+        REQUIRE(cache.hash(small).first == expected);
+        // Only the modification time changed
+        writeFile(small, smallData, date.addSecs(60));
+        REQUIRE(cache.hash(small).first == expected);
+        // The content changed
+        writeFile(small, QByteArray(1000, 'e'), date.addSecs(120));
+        REQUIRE(cache.hash(small).first == QCryptographicHash::hash(QByteArray(1000, 'e'), QCryptographicHash::Md5));
+        writeFile(small, QByteArray(999, 'e'), date.addSecs(120));
+        REQUIRE(cache.hash(small).second == 999);
+    }
+
+    SECTION("Hashes are kept on disk")
+    {
+        const QByteArray expected = cache.hash(large).first;
+        cache.save();
+        REQUIRE(QFile::exists(cacheFile));
+        writeFile(large, QByteArray(3000000, 'e'), date);
+        TestCache reopened(cacheFile);
+        REQUIRE(reopened.hash(large).first == expected);
+    }
+
+    SECTION("Folder listings")
+    {
+        QDir folder(dir.path());
+        REQUIRE(cache.folderEntries(folder) == folder.entryList(QDir::Files));
+        REQUIRE(cache.folderEntries(folder) == folder.entryList(QDir::Files));
+    }
+
+    SECTION("Fingerprint")
+    {
+        REQUIRE(FileHashCache::fingerprint(largeData) == FileHashCache::fingerprint(QByteArray(largeData)));
+        REQUIRE(FileHashCache::fingerprint(smallData) != FileHashCache::fingerprint(smallData.left(999)));
+        // A change in the hashed megabytes is detected when only the modification time tells the file changed
+        int minutes = 0;
+        for (int changedByte : {500000, 2500000}) {
+            QByteArray changed = largeData;
+            changed[changedByte] = 'f';
+            writeFile(large, changed, date.addSecs(60 * ++minutes));
+            REQUIRE(cache.hash(large).first == QCryptographicHash::hash(changed.left(1000000) + changed.right(1000000), QCryptographicHash::Md5));
+            writeFile(large, largeData, date.addSecs(60 * ++minutes));
+            REQUIRE(cache.hash(large).first == hash.first);
+        }
+        // The middle of the file is not hashed
+        QByteArray changed = largeData;
+        changed[1500000] = 'f';
+        writeFile(large, changed, date.addSecs(60 * ++minutes));
+        REQUIRE(cache.hash(large).first == hash.first);
+    }
+}
@@ -0,0 +1,86 @@
+#include "test_utils.hpp"
+
+#include <QElapsedTimer>
+#include <cmath>
+
+using namespace fakeit;
+
+// These test cases are hidden, run them with: runBenchmarks "[Benchmark]"
+TEST_CASE("Keyframe scrubbing cost", "[.][Benchmark]")
+{
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, cacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    Mlt::Profile pr;
+    std::shared_ptr<Mlt::Producer> producer = std::make_shared<Mlt::Producer>(pr, "color", "red");
+    auto effectstack = EffectStackModel::construct(producer, {ObjectType::TimelineClip, 0}, undoStack);
+
+    // Several keyframed parameters, each one with its own keyframe model
+    const int parameters = 4;
+    const int keyframes = 400;
+    const int spacing = 5;
+    std::vector<std::shared_ptr<EffectItemModel>> effects;
+    std::vector<std::shared_ptr<KeyframeModel>> models;
+    for (int i = 0; i < parameters; ++i) {
+        effectstack->appendEffect(QStringLiteral("audiobalance"));
+        auto effect = std::dynamic_pointer_cast<EffectItemModel>(effectstack->getEffectStackRow(i));
+        effect->prepareKeyframes();
+        auto model = std::make_shared<KeyframeModel>(effect, effect->index(0, 0), undoStack);
+        for (int k = 1; k < keyframes; ++k) {
+            REQUIRE(model->addKeyframe(GenTime(k * spacing, pCore->getCurrentFps()), KeyframeType::Linear, 50 + 40 * std::sin(k + i)));
+        }
+        effects.push_back(effect);
+        models.push_back(model);
+    }
+    REQUIRE(models.front()->rowCount() == keyframes);
+
+    // Scrub over the whole animation, one query per parameter and frame, skipping the frames holding a keyframe
+    const int frames = keyframes * spacing;
+    QElapsedTimer timer;
+    timer.start();
+    int queries = 0;
+    double sum = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        if (frame % spacing == 0) {
+            continue;
+        }
+        for (int i = 0; i < parameters; ++i) {
+            const QModelIndex index = effects[size_t(i)]->index(0, 0);
+            const QString anim = effects[size_t(i)]->data(index, AssetParameterModel::ValueRole).toString();
+            const int duration = effects[size_t(i)]->data(index, AssetParameterModel::ParentDurationRole).toInt();
+            // The interpolation as it was before the parsed animation was cached
+            sum += KeyframeModel::getAnimation(effects[size_t(i)], anim, duration)->anim_get_double("key", frame);
+            ++queries;
+        }
+    }
+    qint64 reference = timer.nsecsElapsed();
+    timer.restart();
+    double cachedSum = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        if (frame % spacing == 0) {
+            continue;
+        }
+        for (const auto &model : models) {
+            cachedSum += model->getInterpolatedValue(frame).toDouble();
+        }
+    }
+    qint64 cached = timer.nsecsElapsed();
+    REQUIRE(cachedSum == Approx(sum));
+    qDebug() << "Scrubbing" << parameters << "parameters with" << keyframes << "keyframes: reference" << reference / queries << "ns per query, cached"
+             << cached / queries << "ns per query";
+
+    // Editing a keyframe while scrubbing invalidates the parsed animation
+    timer.restart();
+    for (int k = 1; k < 50; ++k) {
+        REQUIRE(models.front()->updateKeyframe(GenTime(k * spacing, pCore->getCurrentFps()), QVariant(10.)));
+        const double value = models.front()->getInterpolatedValue(k * spacing + 1).toDouble();
+        const QString anim = effects.front()->data(effects.front()->index(0, 0), AssetParameterModel::ValueRole).toString();
+        REQUIRE(value == Approx(KeyframeModel::getAnimation(effects.front(), anim, frames)->anim_get_double("key", k * spacing + 1)));
+    }
+    qDebug() << "Edit and query:" << timer.nsecsElapsed() / 49 / 1000 << "us per edit";
+    pCore->m_projectManager = nullptr;
+}
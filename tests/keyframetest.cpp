@@ -257,5 +257,32 @@ TEST_CASE("Keyframe model", "[KeyframeModel]")
         undoStack->undo();
         state1(6.1);
     }
+
+    SECTION("Interpolation follows keyframe changes")
+    {
+        // Interpolated values must match a fresh parse of the animation, even though the parsed animation is cached
+        auto check_interpolation = [&]() {
+            const QString anim = effect->data(index, AssetParameterModel::ValueRole).toString();
+            const int duration = effect->data(index, AssetParameterModel::ParentDurationRole).toInt();
+            auto reference = KeyframeModel::getAnimation(effect, anim, duration);
+            const int end = GenTime(4.).frames(pCore->getCurrentFps());
+            for (int frame = 0; frame < end; frame += 7) {
+                REQUIRE(model->getInterpolatedValue(frame).toDouble() == Approx(reference->anim_get_double("key", frame)));
+            }
+        };
+        REQUIRE(model->addKeyframe(GenTime(1.), KeyframeType::Linear, 20));
+        REQUIRE(model->addKeyframe(GenTime(3.), KeyframeType::Linear, 60));
+        check_interpolation();
+        REQUIRE(model->updateKeyframe(GenTime(3.), 80));
+        check_interpolation();
+        REQUIRE(model->moveKeyframe(GenTime(1.), GenTime(2.), -1, true));
+        check_interpolation();
+        undoStack->undo();
+        check_interpolation();
+        undoStack->undo();
+        check_interpolation();
+        undoStack->redo();
+        check_interpolation();
+    }
     pCore->m_projectManager = nullptr;
 }
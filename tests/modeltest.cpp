@@ -274,6 +274,31 @@ TEST_CASE("Clip manipulation", "[ClipModel]")
         state(l, pos);
     }
 
+    SECTION("Range queries follow clip length changes")
+    {
+        int l = timeline->getClipPlaytime(cid5);
+        REQUIRE(timeline->requestClipMove(cid5, tid1, 0));
+        REQUIRE(timeline->requestItemResize(cid5, 10 * l, true) == 10 * l);
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 10 * l));
+        auto track = timeline->getTrackById(tid1);
+        REQUIRE(track->getClipsInRange(10 * l - 1, 10 * l) == std::unordered_set<int>{cid5});
+        REQUIRE(track->getClipsInRange(10 * l - 1, -1) == std::unordered_set<int>{cid5, cid1});
+
+        // The longest playtime of the track shrinks with the clip
+        REQUIRE(timeline->requestItemResize(cid5, l, true) == l);
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(*track->m_playtimes.crbegin() == std::max(l, timeline->getClipPlaytime(cid1)));
+        REQUIRE(track->getClipsInRange(l - 1, l) == std::unordered_set<int>{cid5});
+        REQUIRE(track->getClipsInRange(l, 10 * l).empty());
+
+        // In and out points changed on the clip itself are followed too
+        timeline->m_allClips[cid5]->setInOut(0, 5 * l - 1);
+        REQUIRE(track->m_indexedPlaytimes.at(cid5) == 5 * l);
+        REQUIRE(*track->m_playtimes.crbegin() == 5 * l);
+        timeline->m_allClips[cid5]->setInOut(0, l - 1);
+        REQUIRE(track->m_indexedPlaytimes.at(cid5) == l);
+    }
+
     SECTION("Insert a clip in a track and change track")
     {
         REQUIRE(timeline->checkConsistency());
@@ -0,0 +1,51 @@
+#include "catch.hpp"
+#include "timeline2/view/previewchunkscheduler.h"
+
+TEST_CASE("Preview chunks scheduling", "[PreviewChunkScheduler]")
+{
+    PreviewChunkScheduler scheduler(25);
+    QList<int> chunks;
+    for (int i = 0; i < 20; i++) {
+        chunks << i * 25;
+    }
+
+    SECTION("Chunks around the playhead come first")
+    {
+        scheduler.setPlayhead(260);
+        scheduler.sort(chunks);
+        // The chunk under the playhead, then the next one, then the previous one
+        REQUIRE(chunks.mid(0, 5) == QList<int>({250, 275, 225, 300, 325}));
+        REQUIRE(scheduler.priority(250) == 0);
+        REQUIRE(scheduler.priority(275) < scheduler.priority(225));
+        // Chunks before the playhead are watched last
+        REQUIRE(chunks.last() == 0);
+    }
+
+    SECTION("Order is re-evaluated when the playhead moves")
+    {
+        scheduler.setPlayhead(0);
+        scheduler.sort(chunks);
+        REQUIRE(chunks.first() == 0);
+        scheduler.setPlayhead(475);
+        scheduler.sort(chunks);
+        REQUIRE(chunks.first() == 475);
+        REQUIRE(chunks.at(1) == 450);
+    }
+
+    SECTION("Zone start is a playback start")
+    {
+        scheduler.setPlayhead(0);
+        scheduler.setZone(QPoint(300, 400));
+        scheduler.sort(chunks);
+        REQUIRE(chunks.mid(0, 4) == QList<int>({0, 300, 25, 325}));
+        // Chunks outside of the zone only depend on the playhead
+        REQUIRE(scheduler.priority(425) == 34);
+        // When the playhead is in the zone, the zone start has no priority
+        scheduler.setPlayhead(350);
+        REQUIRE(scheduler.priority(300) == 7);
+        // A null zone is ignored
+        scheduler.setPlayhead(0);
+        scheduler.setZone(QPoint());
+        REQUIRE(scheduler.priority(300) == 24);
+    }
+}
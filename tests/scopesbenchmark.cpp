@@ -0,0 +1,230 @@
+#include "catch.hpp"
+#include "lib/audio/fftTools.h"
+#include "scopes/audioscopes/spectrogramgenerator.h"
+#include "scopes/colorscopes/histogramgenerator.h"
+#include "scopes/colorscopes/rgbparadegenerator.h"
+#include "scopes/colorscopes/scopestatistics.h"
+#include "scopes/colorscopes/vectorscopegenerator.h"
+#include "scopes/colorscopes/waveformgenerator.h"
+#include "scopesutils.hpp"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QList>
+#include <QPainter>
+#include <QSize>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+// The waveform computation as it was before the flat histogram, kept as a reference for the benchmark
+QImage referenceWaveform(const QSize &waveformSize, const QImage &image)
+{
+    QImage wave(waveformSize, QImage::Format_ARGB32);
+    wave.fill(qRgba(0, 0, 0, 0));
+    const uint ww = uint(waveformSize.width());
+    const uint wh = uint(waveformSize.height());
+    const uint iw = uint(image.bytesPerLine());
+    const uint ih = uint(image.height());
+    const uint byteCount = iw * ih;
+    std::vector<std::vector<uint>> waveValues(ww, std::vector<uint>(wh, 0));
+    const float pixelDepth = float(byteCount >> 2) / (ww * wh);
+    const float gain = 255.f / (8 * pixelDepth);
+    const float hPrediv = (wh - 1) / 255.f;
+    const float wPrediv = (ww - 1) / float(iw - 1);
+    const uchar *bits = image.bits();
+    const int bpp = image.depth() / 8;
+    for (uint i = 0, x = 0; i < byteCount; i += uint(bpp)) {
+        auto *col = reinterpret_cast<const QRgb *>(bits);
+        float dY = REC_709_R * qRed(*col) + REC_709_G * qGreen(*col) + REC_709_B * qBlue(*col);
+        waveValues[size_t(x * wPrediv)][size_t(dY * hPrediv)]++;
+        bits += bpp;
+        x += uint(bpp);
+        if (x > iw) {
+            x -= iw;
+        }
+    }
+    for (uint i = 0; i < ww; ++i) {
+        for (uint j = 0; j < wh; ++j) {
+            float v = float(waveValues[i][j]);
+            wave.setPixel(int(i), int(wh - j - 1),
+                          qRgba(qBound(0, int(52 * logf(0.1f * gain * v)), 255), qBound(0, int(52 * logf(gain * v)), 255),
+                                qBound(0, int(52 * logf(.25f * gain * v)), 255), qBound(0, int(64 * logf(gain * v)), 255)));
+        }
+    }
+    return wave;
+}
+
+// The spectrogram as it was before the ring buffer, kept as a reference for the benchmark
+struct ReferenceSpectrogram
+{
+    FFTTools fftTools;
+    QList<QVector<float>> history;
+    QImage image;
+    QRgb colorMap[256];
+
+    QImage render(const audioShortVector &audioFrame, int fftWindow, const SpectrogramGenerator::Settings &settings, bool parameterChanged)
+    {
+        auto *freqSpectrum = new float[uint(fftWindow / 2)];
+        fftTools.fftNormalized(audioFrame, 0, 2, freqSpectrum, FFTTools::Window_Hamming, uint(fftWindow), 0);
+        QVector<float> spectrumVector(fftWindow / 2);
+        memcpy(spectrumVector.data(), &freqSpectrum[0], uint(fftWindow) / 2 * sizeof(float));
+        history.prepend(spectrumVector);
+        delete[] freqSpectrum;
+        while (history.size() > 1000) {
+            history.removeLast();
+        }
+        QImage spectrum(settings.size, QImage::Format_ARGB32);
+        spectrum.fill(qRgba(0, 0, 0, 0));
+        QPainter davinci(&spectrum);
+        const int h = settings.rect.height();
+        bool completeRedraw = true;
+        if (image.size() == settings.size && !parameterChanged) {
+            davinci.drawImage(0, -1, image);
+            completeRedraw = false;
+        }
+        int y = 0;
+        for (auto &it : history) {
+            uint right = uint(settings.maxFrequency * (it.size() - 1));
+            QVector<float> dbMap = FFTTools::interpolatePeakPreserving(it, uint(settings.rect.width()), 0, right, -180);
+            for (int i = 0; i < dbMap.size(); ++i) {
+                float val = (dbMap[i] - settings.dBmax) / (settings.dBmax - settings.dBmin) + 1.f;
+                val = qBound(0.f, val, 1.f);
+                spectrum.setPixel(settings.rect.left() + i, settings.rect.top() + h - 1 - y, colorMap[int(val * 255)]);
+            }
+            y++;
+            if (y >= h || !completeRedraw) {
+                break;
+            }
+        }
+        davinci.end();
+        image = spectrum;
+        return spectrum;
+    }
+};
+} // namespace
+
+// These test cases are hidden, run them with: runBenchmarks "[Benchmark]"
+TEST_CASE("Waveform scope cost", "[.][Benchmark]")
+{
+    WaveformGenerator generator;
+    const QSize scopeSize(720, 400);
+    const int iterations = 20;
+    for (const QSize &frameSize : {QSize(1920, 1080), QSize(3840, 2160)}) {
+        QImage frame = testFrame(frameSize.width(), frameSize.height());
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < iterations; ++i) {
+            REQUIRE_FALSE(referenceWaveform(scopeSize, frame).isNull());
+        }
+        qint64 reference = timer.nsecsElapsed();
+        timer.restart();
+        for (int i = 0; i < iterations; ++i) {
+            REQUIRE_FALSE(generator.calculateWaveform(scopeSize, frame, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709).isNull());
+        }
+        qint64 current = timer.nsecsElapsed();
+        qDebug() << "Waveform on" << frameSize << ": reference" << reference / iterations / 1000 << "us per frame, current" << current / iterations / 1000
+                 << "us per frame";
+    }
+}
+
+TEST_CASE("Color scopes cost", "[.][Benchmark]")
+{
+    HistogramGenerator histogram;
+    RGBParadeGenerator parade;
+    WaveformGenerator waveform;
+    VectorscopeGenerator vectorscope;
+    const QSize scopeSize(720, 400);
+    const int iterations = 20;
+    ScopeRequest all;
+    all.accumulations = ScopeRequest::Histogram | ScopeRequest::Parade | ScopeRequest::Waveform | ScopeRequest::Vectorscope;
+    all.paradeColumns = RGBParadeGenerator::paradeColumns(scopeSize);
+    all.waveformSize = scopeSize;
+    all.vectorscopeSize = scopeSize;
+    const int components = HistogramGenerator::ComponentY | HistogramGenerator::ComponentR | HistogramGenerator::ComponentG | HistogramGenerator::ComponentB;
+    for (const QSize &frameSize : {QSize(1920, 1080), QSize(3840, 2160)}) {
+        QImage frame = testFrame(frameSize.width(), frameSize.height());
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < iterations; ++i) {
+            REQUIRE_FALSE(histogram.calculateHistogram(scopeSize, frame, components, ITURec::Rec_709, false, false).isNull());
+            REQUIRE_FALSE(parade.calculateRGBParade(scopeSize, frame, RGBParadeGenerator::PaintMode_RGB, true, false).isNull());
+            REQUIRE_FALSE(waveform.calculateWaveform(scopeSize, frame, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709).isNull());
+            REQUIRE_FALSE(vectorscope
+                              .calculateVectorscope(scopeSize, frame, 1.f, VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::ColorSpace_YUV, false)
+                              .isNull());
+        }
+        qint64 separate = timer.nsecsElapsed();
+        timer.restart();
+        for (int i = 0; i < iterations; ++i) {
+            auto statistics = ScopeStatistics::compute(frame, all);
+            REQUIRE_FALSE(histogram.drawHistogram(scopeSize, *statistics, components, false, false).isNull());
+            REQUIRE_FALSE(parade.drawRGBParade(scopeSize, *statistics, RGBParadeGenerator::PaintMode_RGB, true, false).isNull());
+            REQUIRE_FALSE(waveform.drawWaveform(*statistics, WaveformGenerator::PaintMode_Green, true).isNull());
+            REQUIRE_FALSE(vectorscope.drawVectorscope(*statistics, VectorscopeGenerator::PaintMode_Green2).isNull());
+        }
+        qint64 fused = timer.nsecsElapsed();
+        qDebug() << "Four color scopes on" << frameSize << ": one pass per scope" << separate / iterations / 1000 << "us per frame, fused pass"
+                 << fused / iterations / 1000 << "us per frame";
+    }
+}
+
+TEST_CASE("Spectrogram cost", "[.][Benchmark]")
+{
+    QRgb colorMap[256];
+    for (int i = 0; i < 256; ++i) {
+        colorMap[i] = spectrogramColor(i);
+    }
+    SpectrogramGenerator::Settings settings;
+    settings.size = QSize(1000, 620);
+    settings.rect = QRect(66, 6, 860, 560);
+    settings.highlightPeaks = false;
+    const int iterations = 200;
+    for (int windowSize : {2048, 8192, 32768}) {
+        const audioShortVector audio = testAudio(windowSize, 100, windowSize);
+        ReferenceSpectrogram reference;
+        std::copy(colorMap, colorMap + 256, reference.colorMap);
+        SpectrogramGenerator generator(1000);
+        generator.setColorMap(colorMap, qRgb(255, 255, 255));
+        // Fill the history
+        for (int i = 0; i < settings.rect.height(); ++i) {
+            reference.render(audio, windowSize, settings, false);
+            generator.addFrame(audio, 2, FFTTools::Window_Hamming, uint(windowSize));
+        }
+        generator.render(settings);
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < iterations; ++i) {
+            REQUIRE_FALSE(reference.render(audio, windowSize, settings, false).isNull());
+        }
+        qint64 referenceFrame = timer.nsecsElapsed();
+        timer.restart();
+        for (int i = 0; i < iterations; ++i) {
+            generator.addFrame(audio, 2, FFTTools::Window_Hamming, uint(windowSize));
+            REQUIRE_FALSE(generator.render(settings).isNull());
+        }
+        qint64 currentFrame = timer.nsecsElapsed();
+        // Complete redraws, as when the dB range or the maximum frequency is dragged
+        const int redraws = 10;
+        timer.restart();
+        for (int i = 0; i < redraws; ++i) {
+            REQUIRE_FALSE(reference.render(audio, windowSize, settings, true).isNull());
+        }
+        qint64 referenceRedraw = timer.nsecsElapsed();
+        timer.restart();
+        for (int i = 0; i < redraws; ++i) {
+            settings.dBmin = -70 - i % 2;
+            generator.addFrame(audio, 2, FFTTools::Window_Hamming, uint(windowSize));
+            REQUIRE_FALSE(generator.render(settings).isNull());
+        }
+        qint64 currentRedraw = timer.nsecsElapsed();
+        settings.dBmin = -70;
+        qDebug() << "Spectrogram with window size" << windowSize << ": reference" << referenceFrame / iterations / 1000 << "us per frame,"
+                 << referenceRedraw / redraws / 1000 << "us per redraw, current" << currentFrame / iterations / 1000 << "us per frame,"
+                 << currentRedraw / redraws / 1000 << "us per redraw";
+    }
+}
@@ -0,0 +1,178 @@
+#include "catch.hpp"
+#define private public
+#define protected public
+#include "lib/audio/fftTools.h"
+#include "scopes/audioscopes/spectrogramgenerator.h"
+#include "scopes/colorscopes/rgbparadegenerator.h"
+#include "scopes/colorscopes/scopestatistics.h"
+#include "scopesutils.hpp"
+
+#include <QImage>
+#include <QSize>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+TEST_CASE("Waveform histogram", "[Scopes]")
+{
+    QImage frame = testFrame(320, 180);
+    const QSize size(200, 120);
+    ScopeRequest request;
+    request.accumulations = ScopeRequest::Waveform;
+    request.waveformSize = size;
+    std::vector<uint> histogram = ScopeStatistics::compute(frame, request)->waveform;
+    REQUIRE(histogram.size() == size_t(size.width() * size.height()));
+    // Every pixel is counted once
+    uint total = 0;
+    for (uint v : histogram) {
+        total += v;
+    }
+    REQUIRE(total == uint(frame.width() * frame.height()));
+    // A white frame only fills the top row of the scope
+    frame.fill(Qt::white);
+    request.waveformRec = ITURec::Rec_601;
+    histogram = ScopeStatistics::compute(frame, request)->waveform;
+    for (int j = 0; j < size.height() - 1; ++j) {
+        for (int i = 0; i < size.width(); ++i) {
+            REQUIRE(histogram[size_t(j * size.width() + i)] == 0);
+        }
+    }
+}
+
+TEST_CASE("Fused scope statistics", "[Scopes]")
+{
+    QImage frame = testFrame(640, 360);
+    ScopeRequest histogram;
+    histogram.accumulations = ScopeRequest::Histogram;
+    histogram.histogramRec = ITURec::Rec_601;
+    ScopeRequest parade;
+    parade.accumulations = ScopeRequest::Parade;
+    parade.paradeColumns = RGBParadeGenerator::paradeColumns(QSize(500, 300));
+    ScopeRequest waveform;
+    waveform.accumulations = ScopeRequest::Waveform;
+    waveform.waveformSize = QSize(300, 200);
+    ScopeRequest vectorscope;
+    vectorscope.accumulations = ScopeRequest::Vectorscope;
+    vectorscope.vectorscopeSize = QSize(320, 300);
+    vectorscope.vectorscopeGain = 1.5;
+
+    ScopeRequest all;
+    for (const ScopeRequest &request : {histogram, parade, waveform, vectorscope}) {
+        all.merge(request);
+    }
+    for (const ScopeRequest &request : {histogram, parade, waveform, vectorscope}) {
+        REQUIRE(all.covers(request));
+    }
+    waveform.waveformRec = ITURec::Rec_601;
+    REQUIRE_FALSE(all.covers(waveform));
+    waveform.waveformRec = ITURec::Rec_709;
+
+    // A single pass gives the same accumulations as one pass per scope
+    auto fused = ScopeStatistics::compute(frame, all);
+    REQUIRE(fused->samples == frame.width() * frame.height());
+    auto separate = ScopeStatistics::compute(frame, histogram);
+    REQUIRE(fused->red == separate->red);
+    REQUIRE(fused->blue == separate->blue);
+    REQUIRE(fused->luma == separate->luma);
+    separate = ScopeStatistics::compute(frame, parade);
+    REQUIRE(fused->paradeGreen == separate->paradeGreen);
+    separate = ScopeStatistics::compute(frame, waveform);
+    REQUIRE(fused->waveform == separate->waveform);
+    separate = ScopeStatistics::compute(frame, vectorscope);
+    REQUIRE(fused->vectorscopeWidth == 300);
+    REQUIRE(fused->vectorscope == separate->vectorscope);
+    REQUIRE(fused->vectorscopeColors == separate->vectorscopeColors);
+
+    // Shared statistics are computed once per frame for all registered scopes
+    ScopeStatistics statistics;
+    statistics.setRequest(QStringLiteral("Histogram"), histogram);
+    statistics.setRequest(QStringLiteral("Waveform"), waveform);
+    auto first = statistics.statistics(frame, histogram);
+    REQUIRE(first == statistics.statistics(frame, waveform));
+    // A scope asking for an accumulation that was not registered triggers a new pass
+    auto other = statistics.statistics(frame, parade);
+    REQUIRE(other != first);
+    REQUIRE(other->request.covers(waveform));
+    // A new frame triggers a new pass
+    QImage next = frame.copy();
+    REQUIRE(statistics.statistics(next, histogram) != other);
+}
+
+TEST_CASE("Spectrogram history", "[Scopes]")
+{
+    const int windowSize = 1024;
+    const audioShortVector audio = testAudio(2000, 64, windowSize);
+
+    // The spectrum of a sine has its peak at the frequency of the sine, and its amplitude in dB
+    FFTTools fftTools;
+    std::vector<float> expected(windowSize / 2);
+    fftTools.fftNormalized(audio, 0, 2, expected.data(), FFTTools::Window_Rect, windowSize, 0);
+    auto peak = std::max_element(expected.begin(), expected.end());
+    REQUIRE(peak - expected.begin() == 64);
+    REQUIRE(*peak == Approx(20 * log10(16000. / 32767.)).margin(0.5));
+
+    SpectrogramGenerator generator(4);
+    QRgb colorMap[256];
+    for (int i = 0; i < 256; ++i) {
+        colorMap[i] = spectrogramColor(i);
+    }
+    generator.setColorMap(colorMap, qRgb(255, 255, 255));
+    for (int i = 0; i < 3; ++i) {
+        generator.addFrame(audio, 2, FFTTools::Window_Rect, windowSize);
+    }
+    REQUIRE(generator.historyCount() == 3);
+    generator.addFrame(testAudio(2000, 32, windowSize), 2, FFTTools::Window_Rect, windowSize);
+    generator.addFrame(audio, 2, FFTTools::Window_Rect, 256);
+    // The oldest spectrum was replaced
+    REQUIRE(generator.historyCount() == 4);
+    REQUIRE(generator.spectrum(0).size() == 128);
+    REQUIRE(generator.spectrum(2) == expected);
+    auto older = std::max_element(generator.spectrum(1).begin(), generator.spectrum(1).end());
+    REQUIRE(older - generator.spectrum(1).begin() == 32);
+
+    SpectrogramGenerator::Settings settings;
+    settings.size = QSize(120, 40);
+    settings.rect = QRect(10, 5, 100, 20);
+    settings.highlightPeaks = false;
+    QImage image = generator.render(settings);
+    REQUIRE(image.size() == settings.size);
+    // Outside of the drawing area and above the history, the image is transparent
+    REQUIRE(qAlpha(image.pixel(5, 20)) == 0);
+    REQUIRE(qAlpha(image.pixel(50, 30)) == 0);
+    REQUIRE(qAlpha(image.pixel(50, 24 - 4)) == 0);
+    for (int y = 24 - 3; y <= 24; ++y) {
+        REQUIRE(qAlpha(image.pixel(50, y)) == 255);
+    }
+
+    SECTION("New spectra scroll the image")
+    {
+        const QImage previous = image.copy();
+        generator.addFrame(audio, 2, FFTTools::Window_Rect, windowSize);
+        generator.addFrame(audio, 2, FFTTools::Window_Rect, windowSize);
+        QImage scrolled = generator.render(settings);
+        REQUIRE(scrolled.copy(settings.rect.adjusted(0, 0, 0, -2)) == previous.copy(settings.rect.adjusted(0, 2, 0, 0)));
+        // Drawing the new lines gives the same image as drawing the whole history
+        generator.invalidate();
+        const QImage redrawn = generator.render(settings);
+        const QRect history(10, 21, 100, 4);
+        REQUIRE(redrawn.copy(history) == scrolled.copy(history));
+        // Without new data, the image is not drawn again
+        REQUIRE(generator.render(settings).constBits() == redrawn.constBits());
+    }
+
+    SECTION("Changing the settings draws the whole history")
+    {
+        settings.dBmin = -40;
+        settings.maxFrequency = 0.5f;
+        QImage changed = generator.render(settings);
+        REQUIRE(changed != image);
+        SpectrogramGenerator other(4);
+        other.setColorMap(colorMap, qRgb(255, 255, 255));
+        for (int age = 3; age >= 0; --age) {
+            other.m_newest = (other.m_newest + 1) % 4;
+            other.m_history[size_t(other.m_newest)] = generator.spectrum(age);
+            other.m_count++;
+        }
+        REQUIRE(other.render(settings) == changed);
+    }
+}
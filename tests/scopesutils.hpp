@@ -0,0 +1,42 @@
+#pragma once
+#include "definitions.h"
+
+#include <QImage>
+#include <cmath>
+#include <random>
+
+// Test data shared by the scopes tests and benchmarks
+
+// A gradient with some noise, so that all luma values get used
+inline QImage testFrame(int width, int height)
+{
+    QImage frame(width, height, QImage::Format_RGB32);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (int y = 0; y < height; ++y) {
+        auto *line = reinterpret_cast<QRgb *>(frame.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            int base = 255 * x / width;
+            line[x] = qRgb((base + dist(gen) / 8) % 256, (255 - base + dist(gen) / 8) % 256, dist(gen));
+        }
+    }
+    return frame;
+}
+
+// Interleaved stereo samples, a sine on the first channel at the given frequency bin of the window size and some noise
+inline audioShortVector testAudio(int samples, int bin, int windowSize)
+{
+    audioShortVector audio(samples * 2);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(-200, 200);
+    for (int i = 0; i < samples; ++i) {
+        audio[2 * i] = qint16(16000 * sin(2 * M_PI * bin * i / windowSize) + dist(gen));
+        audio[2 * i + 1] = qint16(dist(gen));
+    }
+    return audio;
+}
+
+inline QRgb spectrogramColor(int i)
+{
+    return qRgb(i, 255 - i, i / 2);
+}
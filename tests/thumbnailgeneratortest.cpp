@@ -0,0 +1,124 @@
+#include "catch.hpp"
+#include "utils/thumbnailgenerator.hpp"
+
+#include <QMutex>
+#include <QSemaphore>
+#include <atomic>
+#include <tuple>
+#include <mlt++/MltProducer.h>
+
+namespace {
+// Extracts fake thumbnails, each extraction waits until the test lets it run
+class TestGenerator : public ThumbnailGenerator
+{
+public:
+    TestGenerator()
+    {
+        m_workers.setMaxThreadCount(1);
+    }
+    ~TestGenerator() override
+    {
+        gate.release(1000);
+        waitForDone();
+    }
+
+    std::shared_ptr<Mlt::Producer> createProducer(const QString &binId) override
+    {
+        Q_UNUSED(binId)
+        created++;
+        return std::make_shared<Mlt::Producer>();
+    }
+    QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frame) override
+    {
+        Q_UNUSED(producer)
+        started.release();
+        gate.acquire();
+        extracted.push_back(frame);
+        QImage img(8, 8, QImage::Format_RGB32);
+        img.fill(QColor(frame, 0, 0));
+        return img;
+    }
+
+    bool hasPool(const QString &binId)
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_pools.count(binId) > 0;
+    }
+
+    QSemaphore started;
+    QSemaphore gate;
+    std::atomic<int> created{0};
+    std::vector<int> extracted;
+};
+} // namespace
+
+TEST_CASE("Thumbnail generation queue", "[ThumbnailGenerator]")
+{
+    TestGenerator generator;
+    QMutex mutex;
+    // Requested frame, extracted frame and content of the thumbnail
+    std::vector<std::tuple<int, int, int>> delivered;
+    auto request = [&](const QString &binId, int frame) {
+        return generator.request(binId, frame, [&mutex, &delivered, frame](const QImage &img, int extracted) {
+            QMutexLocker lock(&mutex);
+            delivered.emplace_back(frame, extracted, qRed(img.pixel(0, 0)));
+        });
+    };
+
+    // The first job starts immediately, the next ones wait for the single worker
+    request(QStringLiteral("1"), 0);
+    generator.started.acquire();
+    // A request for a frame being extracted reuses the running job
+    request(QStringLiteral("1"), 0);
+    request(QStringLiteral("1"), 10);
+    auto cancelled = request(QStringLiteral("1"), 20);
+    request(QStringLiteral("1"), 30);
+    // Adjacent frames share an extraction, frames further apart do not
+    request(QStringLiteral("1"), 31);
+    request(QStringLiteral("1"), 33);
+    cancelled->cancel();
+    REQUIRE(cancelled->isCancelled());
+
+    generator.gate.release(100);
+    generator.waitForDone();
+
+    // Most recent requests first, cancelled ones are skipped
+    REQUIRE(generator.extracted == std::vector<int>{0, 33, 30, 10});
+    REQUIRE(delivered.size() == 6);
+    for (const auto &result : delivered) {
+        const int requested = std::get<0>(result);
+        REQUIRE(requested != 20);
+        // The callback gets the frame that was actually extracted
+        REQUIRE(std::get<1>(result) == (requested == 31 ? 30 : requested));
+        REQUIRE(std::get<2>(result) == std::get<1>(result));
+    }
+    // The producer of the clip is reused
+    REQUIRE(generator.created == 1);
+
+    SECTION("Released producers are recreated")
+    {
+        generator.releaseProducers(QStringLiteral("1"));
+        REQUIRE(!generator.hasPool(QStringLiteral("1")));
+        request(QStringLiteral("1"), 40);
+        generator.waitForDone();
+        REQUIRE(generator.created == 2);
+        request(QStringLiteral("2"), 40);
+        generator.waitForDone();
+        REQUIRE(generator.created == 3);
+    }
+
+    SECTION("Pools of clips released while busy are removed")
+    {
+        // Block the next extraction again
+        generator.gate.acquire(generator.gate.available());
+        generator.started.acquire(generator.started.available());
+        request(QStringLiteral("2"), 0);
+        generator.started.acquire();
+        generator.releaseProducers(QStringLiteral("2"));
+        REQUIRE(generator.hasPool(QStringLiteral("2")));
+        generator.gate.release();
+        generator.waitForDone();
+        REQUIRE(!generator.hasPool(QStringLiteral("2")));
+        REQUIRE(generator.hasPool(QStringLiteral("1")));
+    }
+}
@@ -0,0 +1,80 @@
+#include "catch.hpp"
+#include "utils/thumbnailstore.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+TEST_CASE("Persistent thumbnail store", "[ThumbnailStore]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString hash = QStringLiteral("0123456789abcdef");
+    QImage red(64, 36, QImage::Format_RGB32);
+    red.fill(Qt::red);
+    QImage blue(64, 36, QImage::Format_RGB32);
+    blue.fill(Qt::blue);
+
+    SECTION("Thumbnails are packed in one file per clip")
+    {
+        ThumbnailStore store(dir.path(), 1024 * 1024);
+        store.store(hash, 0, red);
+        store.store(hash, 25, blue);
+        // Queued thumbnails are available before being written
+        REQUIRE(store.contains(hash, 0));
+        REQUIRE_FALSE(store.contains(hash, 10));
+        store.flush();
+        REQUIRE(QDir(dir.path()).entryList(QDir::Files) == QStringList{hash + QStringLiteral(".thumbs")});
+        // A later batch is merged in the existing pack
+        store.store(hash, 50, red);
+        store.flush();
+
+        ThumbnailStore reopened(dir.path(), 1024 * 1024);
+        REQUIRE(reopened.contains(hash, 0));
+        REQUIRE(reopened.contains(hash, 25));
+        REQUIRE(reopened.contains(hash, 50));
+        QImage img = reopened.image(hash, 25);
+        REQUIRE(img.size() == blue.size());
+        REQUIRE(qBlue(img.pixel(10, 10)) > 200);
+        REQUIRE(qRed(img.pixel(10, 10)) < 50);
+
+        reopened.remove(hash);
+        REQUIRE_FALSE(reopened.contains(hash, 0));
+        REQUIRE(QDir(dir.path()).entryList(QDir::Files).isEmpty());
+    }
+
+    SECTION("Invalid packs are ignored")
+    {
+        QFile file(dir.filePath(hash + QStringLiteral(".thumbs")));
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write("KDTH garbage");
+        file.close();
+        ThumbnailStore store(dir.path(), 1024 * 1024);
+        REQUIRE_FALSE(store.contains(hash, 0));
+        REQUIRE(store.image(hash, 0).isNull());
+    }
+
+    SECTION("The store stays within its budget")
+    {
+        QImage noise(320, 180, QImage::Format_RGB32);
+        for (int y = 0; y < noise.height(); ++y) {
+            for (int x = 0; x < noise.width(); ++x) {
+                noise.setPixel(x, y, qRgb((x * 7 + y * 13) % 256, (x * y) % 256, (x + y * 3) % 256));
+            }
+        }
+        const qint64 budget = 256 * 1024;
+        ThumbnailStore store(dir.path(), budget);
+        for (int clip = 0; clip < 20; ++clip) {
+            store.store(QString::number(clip), 0, noise);
+            store.flush();
+        }
+        qint64 total = 0;
+        const QFileInfoList packs = QDir(dir.path()).entryInfoList(QDir::Files);
+        for (const QFileInfo &pack : packs) {
+            total += pack.size();
+        }
+        REQUIRE(total <= budget);
+        // The most recent clip is kept
+        REQUIRE(store.contains(QStringLiteral("19"), 0));
+    }
+}
@@ -0,0 +1,413 @@
+#include "test_utils.hpp"
+#define private public
+#define protected public
+
+#include "bin/model/subtitlemodel.hpp"
+#include "doc/kdenlivedoc.h"
+#include "timeline2/model/builders/meltBuilder.hpp"
+
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+#include <QtConcurrent>
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+
+using namespace fakeit;
+Mlt::Profile profile_benchmark;
+
+namespace {
+struct SyntheticTimeline
+{
+    std::vector<int> tracks;
+    // Clip ids of each track, in position order
+    std::vector<std::vector<int>> clips;
+    int compositions = 0;
+    int groups = 0;
+    int mixes = 0;
+};
+
+QString compositionId()
+{
+    for (const auto &trans : TransitionsRepository::get()->getNames()) {
+        if (TransitionsRepository::get()->isComposition(trans.first)) {
+            return trans.first;
+        }
+    }
+    return QString();
+}
+
+/** @brief Fill a timeline with trackCount tracks of clipsPerTrack adjacent clips.
+    Every 10th clip of the first two tracks are grouped together, tracks after the first one get a composition
+    every 10 clips, and the last track gets a same track mix every 10 clips.
+ */
+SyntheticTimeline buildTimeline(const std::shared_ptr<TimelineItemModel> &timeline, const QString &binId, int trackCount, int clipsPerTrack, int clipLength)
+{
+    SyntheticTimeline result;
+    const QString compo = compositionId();
+    for (int t = 0; t < trackCount; ++t) {
+        int tid = TrackModel::construct(timeline);
+        result.tracks.push_back(tid);
+        result.clips.emplace_back();
+        for (int i = 0; i < clipsPerTrack; ++i) {
+            int cid = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+            REQUIRE(timeline->requestClipMove(cid, tid, i * clipLength, true, false, false));
+            result.clips.back().push_back(cid);
+        }
+    }
+    for (int i = 0; i < clipsPerTrack; i += 10) {
+        if (trackCount > 1 && timeline->requestClipsGroup({result.clips[0][size_t(i)], result.clips[1][size_t(i)]}, false) > 0) {
+            result.groups++;
+        }
+        for (int t = 1; t < trackCount && !compo.isEmpty(); ++t) {
+            int id;
+            if (timeline->requestCompositionInsertion(compo, result.tracks[size_t(t)], (i + 5) * clipLength, clipLength, nullptr, id, false)) {
+                result.compositions++;
+            }
+        }
+        if (i + 5 < clipsPerTrack && timeline->mixClip(result.clips.back()[size_t(i + 5)])) {
+            result.mixes++;
+        }
+    }
+    return result;
+}
+
+/** @brief Print the latency percentiles of an operation, from samples in nanoseconds */
+void reportLatency(const QString &operation, int clipCount, std::vector<qint64> samples)
+{
+    REQUIRE_FALSE(samples.empty());
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) { return samples[std::min(samples.size() - 1, size_t(p * double(samples.size())))] / 1000; };
+    qDebug().noquote() << QStringLiteral("%1 on %2 clips: p50 %3 us, p90 %4 us, p99 %5 us, max %6 us")
+                              .arg(operation)
+                              .arg(clipCount)
+                              .arg(percentile(0.5))
+                              .arg(percentile(0.9))
+                              .arg(percentile(0.99))
+                              .arg(samples.back() / 1000);
+}
+
+template <typename F> void measure(std::vector<qint64> &samples, F &&operation)
+{
+    QElapsedTimer timer;
+    timer.start();
+    operation();
+    samples.push_back(timer.nsecsElapsed());
+}
+} // namespace
+
+// These test cases are built in the runBenchmarks target, run them with: runBenchmarks "[Benchmark]"
+TEST_CASE("Clip move cost on large tracks", "[.][Benchmark]")
+{
+    auto binModel = pCore->projectItemModel();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, cacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    const int clipLength = 20;
+    const int moves = 200;
+    for (int count : {100, 1000, 10000}) {
+        binModel->clean();
+        std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_benchmark, guideModel, undoStack);
+        QString binId = createProducer(profile_benchmark, "red", binModel, clipLength);
+        int tid = TrackModel::construct(timeline);
+        std::vector<int> clips;
+        clips.reserve(size_t(count));
+        for (int i = 0; i < count; ++i) {
+            int cid = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+            REQUIRE(timeline->requestClipMove(cid, tid, i * clipLength, true, false, false));
+            clips.push_back(cid);
+        }
+        REQUIRE(timeline->getTrackById(tid)->checkConsistency());
+
+        // Range queries must match a plain scan of the track
+        int middle = count / 2 * clipLength + clipLength / 2;
+        const int rangeEnd = middle + 3 * clipLength;
+        auto inRange = timeline->getTrackById(tid)->getClipsInRange(middle, rangeEnd);
+        std::unordered_set<int> scanned;
+        for (int cid : clips) {
+            int pos = timeline->getClipPosition(cid);
+            if (pos + timeline->getClipPlaytime(cid) - 1 >= middle && pos < rangeEnd) {
+                scanned.insert(cid);
+            }
+        }
+        REQUIRE(scanned.size() == 4);
+        REQUIRE(inRange == scanned);
+
+        // Move the last clip back and forth after the end of the track, each move checks collisions
+        int last = clips.back();
+        int lastPos = (count - 1) * clipLength;
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < moves; ++i) {
+            REQUIRE(timeline->requestClipMove(last, tid, lastPos + (i % 2 == 0 ? clipLength : 0), true, false, false));
+        }
+        qint64 elapsed = timer.nsecsElapsed();
+        // Collision checks against an occupied zone, which must fail
+        timer.restart();
+        for (int i = 0; i < moves; ++i) {
+            REQUIRE_FALSE(timeline->requestClipMove(last, tid, middle));
+        }
+        qint64 failed = timer.nsecsElapsed();
+        REQUIRE(timeline->getTrackById(tid)->checkConsistency());
+        qDebug() << "requestClipMove on" << count << "clips:" << elapsed / moves / 1000 << "us per move," << failed / moves / 1000
+                 << "us per rejected move";
+        binModel->clean();
+    }
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Timeline model scaling", "[.][Benchmark]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<KdenliveDoc> docMock;
+    KdenliveDoc &mockedDoc = docMock.get();
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, cacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+    When(Method(pmMock, current)).AlwaysReturn(&mockedDoc);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+    pCore->m_projectManager->m_project = &mockedDoc;
+    pCore->m_projectManager->m_project->m_guideModel = guideModel;
+
+    const int clipLength = 20;
+    const int iterations = 100;
+    const int fileIterations = 5;
+    const QString path = QDir::temp().absoluteFilePath(QStringLiteral("benchmark.kdenlive"));
+    for (const auto &size : std::vector<std::pair<int, int>>{{4, 250}, {8, 1250}}) {
+        const int trackCount = size.first;
+        const int clipCount = size.first * size.second;
+        std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_benchmark, guideModel, undoStack);
+        mocked.testSetActiveDocument(&mockedDoc, timeline);
+        std::unordered_map<QString, QString> binIdCorresp;
+        QStringList expandedFolders;
+        QDomDocument doc = mockedDoc.createEmptyDocument(2, 2);
+        QScopedPointer<Mlt::Producer> xmlProd(new Mlt::Producer(profile_benchmark, "xml-string", doc.toString().toUtf8()));
+        Mlt::Service s(*xmlProd);
+        Mlt::Tractor tractor(s);
+        binModel->loadBinPlaylist(&tractor, timeline->tractor(), binIdCorresp, expandedFolders, nullptr);
+
+        QString binId = createProducer(profile_benchmark, "red", binModel, clipLength, false);
+        SyntheticTimeline synthetic = buildTimeline(timeline, binId, trackCount, size.second, clipLength);
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(timeline->getClipsCount() == clipCount);
+        qDebug() << "Synthetic timeline:" << trackCount << "tracks," << clipCount << "clips," << synthetic.groups << "groups," << synthetic.compositions
+                 << "compositions," << synthetic.mixes << "mixes";
+        undoStack->clear();
+
+        // The last clips of the tracks have free space after them, and are neither grouped nor mixed
+        const int end = size.second * clipLength;
+        const int movedClip = synthetic.clips[2].back();
+        const int resizedClip = synthetic.clips[3].back();
+        const int groupId = timeline->requestClipsGroup({synthetic.clips[0].back(), synthetic.clips[1].back()}, false);
+        REQUIRE(groupId > 0);
+        std::vector<qint64> moves, groupMoves, resizes;
+        for (int i = 0; i < iterations; ++i) {
+            measure(moves, [&]() { REQUIRE(timeline->requestClipMove(movedClip, synthetic.tracks[2], end + (i % 2 == 0 ? clipLength : 0) - clipLength)); });
+            measure(groupMoves,
+                    [&]() { REQUIRE(timeline->requestGroupMove(synthetic.clips[0].back(), groupId, 0, i % 2 == 0 ? clipLength : -clipLength)); });
+            measure(resizes, [&]() { REQUIRE(timeline->requestItemResize(resizedClip, i % 2 == 0 ? 2 * clipLength : clipLength, true) > -1); });
+        }
+        REQUIRE(timeline->checkConsistency());
+        reportLatency(QStringLiteral("requestClipMove"), clipCount, moves);
+        reportLatency(QStringLiteral("requestGroupMove"), clipCount, groupMoves);
+        reportLatency(QStringLiteral("requestItemResize"), clipCount, resizes);
+
+        // Undo and redo the operations above
+        std::vector<qint64> undos, redos;
+        const int steps = undoStack->count();
+        for (int i = 0; i < steps; ++i) {
+            measure(undos, [&]() { undoStack->undo(); });
+        }
+        for (int i = 0; i < steps; ++i) {
+            measure(redos, [&]() { undoStack->redo(); });
+        }
+        REQUIRE(timeline->checkConsistency());
+        reportLatency(QStringLiteral("undo"), clipCount, undos);
+        reportLatency(QStringLiteral("redo"), clipCount, redos);
+
+        std::vector<qint64> saves;
+        for (int i = 0; i < fileIterations; ++i) {
+            measure(saves, [&]() { REQUIRE(mocked.testSaveFileAs(path)); });
+        }
+        reportLatency(QStringLiteral("project save"), clipCount, saves);
+        undoStack->clear();
+        timeline.reset();
+
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::ReadOnly | QIODevice::Text));
+        const QByteArray playlist = file.readAll();
+        file.close();
+        std::vector<qint64> loads;
+        for (int i = 0; i < fileIterations; ++i) {
+            binModel->clean();
+            std::shared_ptr<TimelineItemModel> loaded = TimelineItemModel::construct(&profile_benchmark, guideModel, undoStack);
+            mocked.testSetActiveDocument(&mockedDoc, loaded);
+            measure(loads, [&]() {
+                Mlt::Producer xmlProject(profile_benchmark, "xml-string", playlist.constData());
+                Mlt::Service service(xmlProject);
+                bool projectErrors;
+                REQUIRE(constructTimelineFromMelt(loaded, Mlt::Tractor(service), nullptr, QString(), QString(), QString(), 0, &projectErrors));
+            });
+            REQUIRE(loaded->getClipsCount() == clipCount);
+            undoStack->clear();
+        }
+        reportLatency(QStringLiteral("project load"), clipCount, loads);
+        QFile::remove(path);
+        binModel->clean();
+    }
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Subtitle model scaling", "[.][Benchmark]")
+{
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, cacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    const double fps = pCore->getCurrentFps();
+    // Subtitles of 50 frames, separated by 10 frames
+    const int length = 50;
+    const int spacing = 60;
+    const int iterations = 200;
+    for (int count : {1000, 5000, 20000}) {
+        std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_benchmark, guideModel, undoStack);
+        auto subtitleModel = std::make_shared<SubtitleModel>(nullptr, timeline);
+        timeline->setSubModel(subtitleModel);
+        std::vector<int> ids;
+        ids.reserve(size_t(count));
+        for (int i = 0; i < count; ++i) {
+            int id = TimelineModel::getNextId();
+            REQUIRE(subtitleModel->addSubtitle(id, GenTime(i * spacing, fps), GenTime(i * spacing + length, fps), QStringLiteral("Line %1").arg(i), false, false));
+            ids.push_back(id);
+        }
+        REQUIRE(subtitleModel->rowCount() == count);
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> pick(0, count - 1);
+
+        // Range selection, the range overlaps the end of a subtitle and covers 10 more
+        std::vector<qint64> ranges;
+        for (int i = 0; i < iterations; ++i) {
+            int first = pick(gen) % (count - 20);
+            int start = first * spacing + length / 2;
+            measure(ranges, [&]() { REQUIRE(subtitleModel->getItemsInRange(start, start + 10 * spacing).size() == 11); });
+        }
+        reportLatency(QStringLiteral("subtitle range query"), count, ranges);
+
+        // Row lookup, as done for each view update
+        std::vector<qint64> rows;
+        for (int i = 0; i < iterations; ++i) {
+            int id = ids[size_t(pick(gen))];
+            measure(rows, [&]() {
+                int row = subtitleModel->getRowForId(id);
+                REQUIRE(subtitleModel->data(subtitleModel->index(row), SubtitleModel::IdRole).toInt() == id);
+            });
+        }
+        reportLatency(QStringLiteral("subtitle row lookup"), count, rows);
+
+        // Move subtitles to the end of the track and back
+        std::vector<qint64> moves;
+        const int end = count * spacing;
+        for (int i = 0; i < iterations; ++i) {
+            int id = ids[size_t(pick(gen))];
+            GenTime previous = subtitleModel->getStartPosForId(id);
+            measure(moves, [&]() {
+                REQUIRE(subtitleModel->moveSubtitle(id, GenTime(end + i * spacing, fps), false, false));
+                REQUIRE(subtitleModel->getIdForStartPos(GenTime(end + i * spacing, fps)) == id);
+                REQUIRE(subtitleModel->moveSubtitle(id, previous, false, false));
+            });
+        }
+        reportLatency(QStringLiteral("subtitle move and back"), count, moves);
+        REQUIRE(subtitleModel->getIdForStartPos(GenTime(spacing, fps)) == ids[1]);
+
+        subtitleModel->unsetModel();
+        timeline->m_subtitleModel.reset();
+    }
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Autosave GUI stall", "[.][Benchmark]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<KdenliveDoc> docMock;
+    KdenliveDoc &mockedDoc = docMock.get();
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, cacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+    When(Method(pmMock, current)).AlwaysReturn(&mockedDoc);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+    pCore->m_projectManager->m_project = &mockedDoc;
+    pCore->m_projectManager->m_project->m_guideModel = guideModel;
+
+    const int clipLength = 20;
+    const int iterations = 5;
+    const QString root = QDir::temp().absolutePath();
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_benchmark, guideModel, undoStack);
+    mocked.testSetActiveDocument(&mockedDoc, timeline);
+    std::unordered_map<QString, QString> binIdCorresp;
+    QStringList expandedFolders;
+    QDomDocument doc = mockedDoc.createEmptyDocument(2, 2);
+    QScopedPointer<Mlt::Producer> xmlProd(new Mlt::Producer(profile_benchmark, "xml-string", doc.toString().toUtf8()));
+    Mlt::Service s(*xmlProd);
+    Mlt::Tractor tractor(s);
+    binModel->loadBinPlaylist(&tractor, timeline->tractor(), binIdCorresp, expandedFolders, nullptr);
+    QString binId = createProducer(profile_benchmark, "red", binModel, clipLength, false);
+    buildTimeline(timeline, binId, 8, 1250, clipLength);
+    const int clipCount = timeline->getClipsCount();
+    undoStack->clear();
+
+    QTemporaryFile file;
+    REQUIRE(file.open());
+    auto writeScene = [&file](const QString &scene) { return file.resize(0) && file.write(scene.toUtf8()) > 0 && file.flush(); };
+
+    // Autosave as it was done before, the playlist is built and written on the GUI thread
+    std::vector<qint64> blocking;
+    QString reference;
+    for (int i = 0; i < iterations; ++i) {
+        measure(blocking, [&]() {
+            reference = timeline->sceneList(root);
+            REQUIRE(writeScene(reference));
+        });
+    }
+    reportLatency(QStringLiteral("blocking autosave"), clipCount, blocking);
+
+    // The playlist is still built on the GUI thread, only the file writing is moved to a worker thread.
+    // This only measures what is left to the GUI thread, the serialization is not made any cheaper
+    std::vector<qint64> backgroundWrite;
+    for (int i = 0; i < iterations; ++i) {
+        QFuture<bool> task;
+        measure(backgroundWrite, [&]() {
+            const QString scene = timeline->lockedSceneList(root);
+            task = QtConcurrent::run([&writeScene, scene]() { return writeScene(scene); });
+        });
+        REQUIRE(task.result());
+        file.seek(0);
+        REQUIRE(QString::fromUtf8(file.readAll()) == reference);
+    }
+    reportLatency(QStringLiteral("autosave with background write"), clipCount, backgroundWrite);
+
+    undoStack->clear();
+    timeline.reset();
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
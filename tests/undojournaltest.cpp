@@ -0,0 +1,149 @@
+#include "doc/undojournal.hpp"
+#include "test_utils.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+using namespace fakeit;
+Mlt::Profile profile_journal;
+
+namespace {
+QJsonObject operation(int value)
+{
+    return {{QStringLiteral("op"), QStringLiteral("test")}, {QStringLiteral("value"), value}};
+}
+
+std::vector<int> readValues(const QString &path)
+{
+    std::vector<int> values;
+    for (const QJsonObject &op : UndoJournal::read(path)) {
+        values.push_back(op.value(QStringLiteral("value")).toInt());
+    }
+    return values;
+}
+} // namespace
+
+TEST_CASE("Undo journal files", "[UndoJournal]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("journal/test.journal"));
+    UndoJournal journal(path);
+    REQUIRE_FALSE(journal.isComplete());
+    journal.startSnapshot();
+    REQUIRE(journal.isComplete());
+    journal.append(operation(1));
+    journal.append(operation(2));
+    REQUIRE(journal.size() == 2);
+    REQUIRE(readValues(path) == std::vector<int>{1, 2});
+
+    SECTION("The edits are kept until the backup is written")
+    {
+        journal.startSnapshot();
+        REQUIRE(journal.size() == 0);
+        journal.append(operation(3));
+        REQUIRE(readValues(path) == std::vector<int>{1, 2, 3});
+        journal.finishSnapshot(true);
+        REQUIRE(readValues(path) == std::vector<int>{3});
+
+        // A failed backup keeps the previous edits, the next one needs all of them
+        journal.startSnapshot();
+        journal.append(operation(4));
+        journal.finishSnapshot(false);
+        REQUIRE_FALSE(journal.isComplete());
+        journal.append(operation(5));
+        journal.startSnapshot();
+        REQUIRE(readValues(path) == std::vector<int>{3, 4, 5});
+        journal.finishSnapshot(true);
+        REQUIRE(readValues(path).empty());
+    }
+
+    SECTION("Replay stops at an edit that was not recorded")
+    {
+        journal.invalidate();
+        REQUIRE_FALSE(journal.isComplete());
+        journal.append(operation(3));
+        REQUIRE(readValues(path) == std::vector<int>{1, 2});
+        journal.startSnapshot();
+        journal.append(operation(4));
+        journal.finishSnapshot(true);
+        REQUIRE(readValues(path) == std::vector<int>{4});
+    }
+
+    SECTION("Truncated edits are ignored")
+    {
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::WriteOnly | QIODevice::Append));
+        file.write("{\"op\":\"test\",\"val");
+        file.close();
+        REQUIRE(readValues(path) == std::vector<int>{1, 2});
+    }
+
+    journal.remove();
+    REQUIRE_FALSE(QFile::exists(path));
+}
+
+TEST_CASE("Replay timeline edits from the undo journal", "[UndoJournal]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, cacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    TimelineItemModel tim(&profile_journal, undoStack);
+    Mock<TimelineItemModel> timMock(tim);
+    auto timeline = std::shared_ptr<TimelineItemModel>(&timMock.get(), [](...) {});
+    TimelineItemModel::finishConstruct(timeline, guideModel);
+
+    QString binId = createProducer(profile_journal, "red", binModel);
+    int tid1 = TrackModel::construct(timeline);
+    int tid2 = TrackModel::construct(timeline);
+    int cid1 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    int cid2 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    REQUIRE(timeline->requestClipMove(cid1, tid1, 0, true, true, false));
+    REQUIRE(timeline->requestClipMove(cid2, tid1, 40, true, true, false));
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("timeline.journal"));
+    auto journal = std::make_shared<UndoJournal>(path);
+    undoStack->setJournal(journal);
+    journal->startSnapshot();
+
+    // Edits are recorded with the track index and position of the item, since ids are not saved
+    REQUIRE(timeline->requestClipMove(cid1, tid2, 10));
+    REQUIRE(timeline->requestItemResize(cid1, 5, true) == 5);
+    REQUIRE(journal->size() == 2);
+    REQUIRE(journal->isComplete());
+    const QVector<QJsonObject> operations = UndoJournal::read(path);
+    REQUIRE(operations.size() == 2);
+    REQUIRE(operations.at(0).value(QStringLiteral("op")).toString() == QLatin1String("moveClip"));
+    REQUIRE(operations.at(1).value(QStringLiteral("op")).toString() == QLatin1String("resize"));
+
+    // Undo is not recorded, the journal must be replayed on the state saved when it started
+    undoStack->undo();
+    undoStack->undo();
+    REQUIRE_FALSE(journal->isComplete());
+    REQUIRE(timeline->getClipTrackId(cid1) == tid1);
+    REQUIRE(timeline->getClipPosition(cid1) == 0);
+    REQUIRE(timeline->getClipPlaytime(cid1) == 20);
+    undoStack->setJournal(nullptr);
+
+    for (const QJsonObject &op : operations) {
+        REQUIRE(timeline->replayJournal(op));
+    }
+    REQUIRE(timeline->getClipTrackId(cid1) == tid2);
+    REQUIRE(timeline->getClipPosition(cid1) == 10);
+    REQUIRE(timeline->getClipPlaytime(cid1) == 5);
+    // The item of an edit must exist at the recorded position
+    REQUIRE_FALSE(timeline->replayJournal(operations.at(0)));
+
+    pCore->m_projectManager = nullptr;
+}